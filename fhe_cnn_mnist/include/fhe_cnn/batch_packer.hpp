@@ -0,0 +1,96 @@
+#ifndef FHE_CNN_BATCH_PACKER_HPP
+#define FHE_CNN_BATCH_PACKER_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/layout.hpp"
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Packing de N images par ciphertext
+ *
+ * En blocs, l'image k occupe les slots [k*stride, k*stride + image_size).
+ * Le stride est l'empreinte maximale d'une image dans le réseau (plus
+ * grande couche intermédiaire), pour qu'aucune couche n'écrive dans le
+ * bloc de la voisine. En entrelacé, le pixel i de l'image k est au slot
+ * i*capacity + k. Dans les deux cas capacity = numSlots / stride.
+ */
+class BatchPacker {
+public:
+    /**
+     * @param log_slots log2(nombre de slots)
+     * @param image_size Taille d'une image en entrée (784 pour MNIST)
+     * @param footprint Plus grande empreinte d'une image dans le réseau (slots)
+     * @param max_images Plafond optionnel (0 = capacité maximale)
+     * @param order Blocs contigus ou images entrelacées
+     * @throws std::runtime_error si une seule image ne tient pas
+     */
+    BatchPacker(int log_slots, int image_size, int footprint, int max_images = 0,
+                BatchOrder order = BatchOrder::Block);
+
+    int logSlots() const { return log_slots_; }
+    int imageSize() const { return image_size_; }
+
+    /** Écart entre deux images (slots) */
+    int stride() const { return stride_; }
+
+    /** Nombre maximal d'images par ciphertext */
+    int capacity() const { return capacity_; }
+
+    /** Premier slot de l'image k */
+    int offset(int k) const { return layout_.slot(k, 0); }
+
+    /** Layout des images packées (à passer aux couches) */
+    const SlotLayout& layout() const { return layout_; }
+
+    /**
+     * Packer jusqu'à capacity() images (les blocs manquants restent nuls)
+     *
+     * @param images Images à packer (chacune image_size valeurs)
+     * @param device CPU/GPU
+     */
+    heaan::Message<heaan::Complex> pack(
+        const std::vector<std::vector<double>>& images,
+        heaan::Device device = heaan::Device::CPU
+    ) const;
+
+    /**
+     * Extraire count résultats d'un message décodé
+     *
+     * @param msg Message décodé (CPU)
+     * @param count Nombre d'images
+     * @param output_size Valeurs par image
+     * @param output_stride Écart entre deux résultats en blocs (0 = layout())
+     */
+    std::vector<std::vector<double>> unpack(
+        const heaan::Message<heaan::Complex>& msg,
+        int count,
+        int output_size,
+        int output_stride = 0
+    ) const;
+
+    /**
+     * Déchiffrer puis extraire count résultats
+     */
+    std::vector<std::vector<double>> unpack(
+        const heaan::ICiphertext& ctxt,
+        const heaan::ISecretKey& sk,
+        heaan::EnDecoder& encoder,
+        heaan::EnDecryptor& decryptor,
+        int count,
+        int output_size,
+        int output_stride = 0
+    ) const;
+
+private:
+    int log_slots_;
+    int image_size_;
+    int stride_;
+    int capacity_;
+    SlotLayout layout_;
+};
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_BATCH_PACKER_HPP
@@ -2,24 +2,166 @@
 #define FHE_CNN_BOOTSTRAPPING_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/key_store.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace fhe_cnn {
 
+class KeyBundle;
+
+/**
+ * Contexte de bootstrapping partagé
+ * 
+ * Génère les clés de bootstrap et fait le warmup une seule fois par
+ * processus, puis est passé par référence à toutes les couches qui
+ * peuvent bootstrapper. bootstrap() est thread-safe (appels sérialisés).
+ */
+class BootstrapContext {
+public:
+    /**
+     * @param preset_id Paramètres (doit être compatible avec bootstrapping)
+     * @param sk Clé secrète (utilisée uniquement pour générer les clés)
+     */
+    BootstrapContext(heaan::PresetParamsId preset_id, const heaan::ISecretKey& sk);
+    
+    /**
+     * @param preset_id Paramètres
+     * @param bundle Paquet contenant les clés de bootstrap (sans clé secrète)
+     * @throws std::runtime_error si le paquet n'a pas de clés de bootstrap
+     */
+    BootstrapContext(heaan::PresetParamsId preset_id, const KeyBundle& bundle);
+    
+    BootstrapContext(const BootstrapContext&) = delete;
+    BootstrapContext& operator=(const BootstrapContext&) = delete;
+    
+    /**
+     * Rafraîchir un ciphertext (en place)
+     */
+    void bootstrap(heaan::ICiphertext& ctxt);
+    
+    /**
+     * Bootstrap creux: le message doit être périodique de période 2^log_slots
+     * (voir bootstrap_sparse). Le bootstrapper creux est créé et chauffé au
+     * premier appel pour ce log_slots, puis réutilisé.
+     */
+    void bootstrapSparse(heaan::ICiphertext& ctxt, int log_slots);
+    
+    heaan::PresetParamsId preset() const { return preset_id_; }
+    
+    /** Clés de bootstrap (pour l'écriture d'un paquet) */
+    const heaan::BootKeyPtrs& bootKeys() const { return *bootkeys_; }
+    
+    /** Niveau d'un ciphertext juste après bootstrap (mesuré à la création) */
+    int outputLevel() const { return output_level_; }
+    
+    /** Nombre de bootstraps effectués depuis la création */
+    int count() const { return count_.load(); }
+    
+private:
+    heaan::PresetParamsId preset_id_;
+    std::unique_ptr<heaan::BootKeyPtrs> bootkeys_;
+    heaan::Bootstrapper bootstrapper_;
+    std::map<int, std::unique_ptr<heaan::Bootstrapper>> sparse_bootstrappers_;
+    std::mutex mutex_;
+    std::atomic<int> count_;
+    int output_level_;
+};
+
 /**
  * Bootstrapping pour rafraîchir les niveaux d'un ciphertext
  * 
  * @param ctxt Ciphertext à rafraîchir (sera modifié)
- * @param sk Clé secrète
+ * @param boot_ctx Contexte de bootstrap partagé
  * @param eval Évaluateur homomorphe
- * @param preset_id Paramètres (doit être compatible avec bootstrapping)
  */
 void bootstrap_ciphertext(
     heaan::Ptr<heaan::ICiphertext>& ctxt,
-    const heaan::ISecretKey& sk,
+    BootstrapContext& boot_ctx,
+    heaan::HomEval& eval
+);
+
+/**
+ * Bootstrapping creux quand seuls quelques slots portent des données
+ * 
+ * Stratégie:
+ * 1. Masquer les slots live (le reste doit être nul)
+ * 2. Répliquer avec une période d = 2^ceil(log2(live_slots)) (rotate-and-add)
+ * 3. Bootstrap avec d slots seulement (beaucoup moins cher)
+ * 4. Re-masquer pour revenir au layout plein (slots live, zéros ailleurs)
+ * 
+ * Consomme 1 niveau avant et 1 niveau après le bootstrap (masques).
+ * Si live_slots est proche du nombre de slots, fait un bootstrap normal.
+ * 
+ * @param ctxt Ciphertext à rafraîchir (sera remplacé)
+ * @param live_slots Nombre de slots utiles (slots 0..live_slots-1)
+ * @param log_slots log2(nombre de slots)
+ * @param boot_ctx Contexte de bootstrap partagé
+ * @param rot_keys Clés de rotation (voir sparse_bootstrap_rotation_shifts)
+ * @param eval Évaluateur homomorphe
+ * @param encoder Encodeur du contexte (masques)
+ * @param mask_input Masquer l'entrée (false si les slots hors données sont déjà nuls)
+ * @param mask_output Re-masquer la sortie (false si l'appelant masque lui-même)
+ */
+void bootstrap_sparse(
+    heaan::Ptr<heaan::ICiphertext>& ctxt,
+    int live_slots,
+    int log_slots,
+    BootstrapContext& boot_ctx,
+    RotationKeyStore& rot_keys,
+    heaan::HomEval& eval,
+    heaan::EnDecoder& encoder,
+    bool mask_input = true,
+    bool mask_output = true
+);
+
+/**
+ * Bootstrapper plusieurs ciphertexts (un par lot) en un seul bootstrap
+ * 
+ * Stratégie:
+ * 1. Masquer chaque ciphertext sur ses live_slots slots
+ * 2. Le décaler (rotation à droite de k*live_slots) et tout additionner
+ * 3. Un seul bootstrap (creux si l'ensemble tient dans la moitié des slots)
+ * 4. Redécouper: rotation à gauche de k*live_slots puis masque
+ * 
+ * Consomme 1 niveau avant et 1 niveau après le bootstrap.
+ * 
+ * @param ctxts Ciphertexts à rafraîchir (remplacés en place)
+ * @param live_slots Slots utiles par ciphertext (slots 0..live_slots-1)
+ * @param log_slots log2(nombre de slots)
+ * @param boot_ctx Contexte de bootstrap partagé
+ * @param rot_keys Clés de rotation (voir merge_rotation_shifts)
+ * @param eval Évaluateur homomorphe
+ * @param encoder Encodeur du contexte (masques)
+ */
+void bootstrap_merged(
+    std::vector<heaan::Ptr<heaan::ICiphertext>>& ctxts,
+    int live_slots,
+    int log_slots,
+    BootstrapContext& boot_ctx,
+    RotationKeyStore& rot_keys,
     heaan::HomEval& eval,
-    heaan::PresetParamsId preset_id = heaan::PresetParamsId::F16Opt_Gr
+    heaan::EnDecoder& encoder
 );
 
+/**
+ * Nombre maximal de ciphertexts fusionnables dans un seul
+ */
+int max_merge_count(int live_slots, int log_slots);
+
+/**
+ * Rotations nécessaires à bootstrap_merged pour count ciphertexts
+ */
+std::vector<int> merge_rotation_shifts(int count, int live_slots, int log_slots);
+
+/**
+ * Rotations nécessaires à bootstrap_sparse
+ */
+std::vector<int> sparse_bootstrap_rotation_shifts(int live_slots, int log_slots);
+
 /**
  * Vérifier si le bootstrapping est nécessaire
  * 
@@ -35,4 +177,4 @@ bool need_bootstrap(
 
 } // namespace fhe_cnn
 
-#endif // FHE_CNN_BOOTSTRAPPING_HPP
\ No newline at end of file
+#endif // FHE_CNN_BOOTSTRAPPING_HPP
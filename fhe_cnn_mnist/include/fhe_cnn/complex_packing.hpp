@@ -0,0 +1,54 @@
+#ifndef FHE_CNN_COMPLEX_PACKING_HPP
+#define FHE_CNN_COMPLEX_PACKING_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+
+#include <utility>
+
+namespace fhe_cnn {
+
+/**
+ * Packing complexe: deux tenseurs réels dans un seul ciphertext
+ *
+ * z = a + i·b. Les couches linéaires à poids réels (conv, pool, FC) et
+ * le bootstrap agissent sur a et b indépendamment; les biais doivent être
+ * encodés b·(1 + i). Avant toute non-linéarité on sépare:
+ *   a = (z + conj(z)) / 2
+ *   b = (z - conj(z)) / 2i
+ */
+
+/**
+ * Combiner deux ciphertexts réels: ct_re + i·ct_im
+ *
+ * Multiplication par i exacte: aucun niveau consommé.
+ *
+ * @param ct_re Partie réelle
+ * @param ct_im Partie imaginaire
+ * @param eval Évaluateur homomorphe
+ * @return Ciphertext complexe
+ */
+heaan::Ptr<heaan::ICiphertext> combine_complex(
+    const heaan::ICiphertext& ct_re,
+    const heaan::ICiphertext& ct_im,
+    heaan::HomEval& eval
+);
+
+/**
+ * Séparer un ciphertext complexe en (partie réelle, partie imaginaire)
+ *
+ * Une conjugaison + ×0.5: consomme 1 niveau.
+ *
+ * @param ctxt Ciphertext complexe
+ * @param conj_key Clé de conjugaison
+ * @param eval Évaluateur homomorphe
+ * @return Paire (réel, imaginaire), chacun avec une partie imaginaire nulle
+ */
+std::pair<heaan::Ptr<heaan::ICiphertext>, heaan::Ptr<heaan::ICiphertext>> split_complex(
+    const heaan::ICiphertext& ctxt,
+    const heaan::ISwKey& conj_key,
+    heaan::HomEval& eval
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_COMPLEX_PACKING_HPP
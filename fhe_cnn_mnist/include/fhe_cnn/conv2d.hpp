@@ -2,8 +2,9 @@
 #define FHE_CNN_CONV2D_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
 #include <vector>
-#include <map>
 
 namespace fhe_cnn {
 
@@ -15,38 +16,54 @@ namespace fhe_cnn {
  * 2. Pour chaque position du kernel, extraire les 25 pixels
  * 3. Diagonal method pour calculer toutes les convolutions en parallèle
  * 
- * @param input_enc Ciphertext avec image packée (H×W slots)
+ * Les rotations suivent les strides de l'entrée (kh·h_stride + kw·w_stride):
+ * une entrée sortie d'un pooling non compacté se lit sans recopie.
+ * 
+ * Tenseurs découpés par canaux: chaque ciphertext de sortie accumule les
+ * contributions de tous les ciphertexts d'entrée; les rotations des entrées
+ * puis les sorties sont calculées en parallèle (un ciphertext par thread).
+ * Une sortie trop large pour les slots est découpée au lieu d'être refusée.
+ * 
+ * @param input Tenseur d'entrée (in_c × in_h × in_w)
  * @param weight Poids [out_c][in_c][5][5] en clair
  * @param bias Bias [out_c] en clair
- * @param in_c Canaux d'entrée
- * @param in_h Hauteur d'entrée
- * @param in_w Largeur d'entrée
  * @param out_c Canaux de sortie
  * @param kernel Taille du noyau (5)
- * @param out_h Hauteur de sortie
- * @param out_w Largeur de sortie
- * @param sk Clé secrète
- * @param rot_keys Map des clés de rotation
- * @param relin_key Clé de relinéarisation
- * @param eval Évaluateur homomorphe
+ * @param ctx Contexte FHE (évaluateur, encodeur, rotations)
+ * @param complex_packed Entrée en packing complexe: bias encodé b·(1 + i)
+ * @param ct_channels Plafond de canaux de sortie par ciphertext (0 = autant que les slots le permettent)
+ * @return Tenseur dense out_c × (in_h-kernel+1) × (in_w-kernel+1), mêmes images
  */
-heaan::Ptr<heaan::ICiphertext> homomorphic_conv2d(
-    const heaan::ICiphertext& input_enc,
+CtTensor homomorphic_conv2d(
+    const CtTensor& input,
     const std::vector<double>& weight,
     const std::vector<double>& bias,
-    int in_c,
-    int in_h,
-    int in_w,
     int out_c,
     int kernel,
-    int out_h,
-    int out_w,
-    const heaan::ISecretKey& sk,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys,
-    const heaan::ISwKey& relin_key,
-    heaan::HomEval& eval
+    FheContext& ctx,
+    bool complex_packed = false,
+    int ct_channels = 0
 );
 
+/**
+ * Emplacement de la sortie de homomorphic_conv2d (dense, découpé par
+ * canaux pour tenir dans 2^log_slots slots)
+ */
+TensorLayout conv2d_output_layout(
+    const TensorLayout& input,
+    int out_c,
+    int kernel,
+    int log_slots,
+    int ct_channels = 0
+);
+
+/**
+ * Rotations utilisées par homomorphic_conv2d (kh·h_stride + kw·w_stride,
+ * sauf 0, multipliées par le batch en layout entrelacé), les mêmes pour
+ * chaque ciphertext d'entrée
+ */
+std::vector<int> conv2d_rotation_shifts(const TensorLayout& input, int kernel);
+
 } // namespace fhe_cnn
 
 #endif // FHE_CNN_CONV2D_HPP
\ No newline at end of file
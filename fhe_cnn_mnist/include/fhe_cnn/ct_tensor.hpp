@@ -0,0 +1,134 @@
+#ifndef FHE_CNN_CT_TENSOR_HPP
+#define FHE_CNN_CT_TENSOR_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/layout.hpp"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Emplacement d'un tenseur [c][h][w] dans les slots
+ *
+ * L'élément (ch, y, x) de l'image b est au slot
+ * layout.slot(b, ch*c_stride + y*h_stride + x*w_stride). Après un pooling
+ * sans compaction (compact = false), les strides doublent au lieu de
+ * recopier les pixels: la couche suivante lit directement les pixels valides.
+ *
+ * Un tenseur trop large pour un ciphertext est découpé par canaux: le
+ * ciphertext g porte les canaux [g·ct_channels, (g+1)·ct_channels), chacun
+ * avec le même emplacement local (index() et extent() sont relatifs au
+ * ciphertext du canal).
+ */
+struct TensorLayout {
+    int c = 1;
+    int h = 1;
+    int w = 1;
+    int c_stride = 1;   // Écart entre deux canaux (éléments du layout)
+    int h_stride = 1;   // Écart entre deux lignes
+    int w_stride = 1;   // Écart entre deux colonnes
+    int ct_channels = 0;  // Canaux par ciphertext (0 = tous dans un seul)
+    SlotLayout slots;   // Placement des images
+
+    /** Tenseur dense: strides (h·w, w, 1), un seul ciphertext */
+    static TensorLayout dense(int c, int h, int w, const SlotLayout& slots = SlotLayout());
+
+    /**
+     * Même tenseur découpé par canaux pour tenir dans 2^log_slots slots
+     *
+     * @param log_slots log2(nombre de slots)
+     * @param max_channels Plafond de canaux par ciphertext (0 = autant que possible)
+     * @return Layout avec ct_channels maximal sous les deux contraintes
+     * @throws std::runtime_error si un seul canal dépasse les slots
+     *         (le découpage spatial n'est pas supporté)
+     */
+    TensorLayout split(int log_slots, int max_channels = 0) const;
+
+    /** Canaux par ciphertext (le dernier peut en porter moins) */
+    int channelsPerCt() const { return ct_channels > 0 && ct_channels < c ? ct_channels : c; }
+
+    /** Nombre de ciphertexts */
+    int numCts() const { return (c + channelsPerCt() - 1) / channelsPerCt(); }
+
+    /** Ciphertext qui porte le canal ch */
+    int ctOf(int ch) const { return ch / channelsPerCt(); }
+
+    /** Premier canal et nombre de canaux du ciphertext g */
+    int firstChannel(int g) const { return g * channelsPerCt(); }
+    int channelsIn(int g) const { return std::min(channelsPerCt(), c - firstChannel(g)); }
+
+    /** Nombre d'éléments par image (tous ciphertexts confondus) */
+    int size() const { return c * h * w; }
+
+    /** Nombre d'images */
+    int batch() const { return slots.batch; }
+
+    /** Indice (élément du layout) de (ch, y, x) dans le ciphertext ctOf(ch) */
+    int index(int ch, int y, int x) const {
+        return (ch % channelsPerCt()) * c_stride + y * h_stride + x * w_stride;
+    }
+
+    /** Slot de (ch, y, x) pour l'image image, dans le ciphertext ctOf(ch) */
+    int slot(int image, int ch, int y, int x) const { return slots.slot(image, index(ch, y, x)); }
+
+    /** Éléments couverts par une image dans un ciphertext plein */
+    int extent() const { return index(channelsPerCt() - 1, h - 1, w - 1) + 1; }
+
+    /** Les éléments sont-ils contigus (strides denses)? */
+    bool dense() const;
+};
+
+/**
+ * Tenseur chiffré: ciphertext(s) + emplacement des données
+ *
+ * Les couches consomment et produisent des CtTensor: la forme, les strides
+ * et le nombre d'images voyagent avec les données au lieu d'être repassés
+ * en entiers à chaque appel. cts[g] porte les canaux layout.firstChannel(g)
+ * à firstChannel(g) + channelsIn(g) - 1.
+ */
+struct CtTensor {
+    std::vector<heaan::Ptr<heaan::ICiphertext>> cts;
+    TensorLayout layout;
+
+    CtTensor() = default;
+    CtTensor(heaan::Ptr<heaan::ICiphertext> ct, const TensorLayout& layout);
+
+    /** Le ciphertext unique du tenseur (@throws std::runtime_error sinon) */
+    heaan::ICiphertext& ct();
+    const heaan::ICiphertext& ct() const;
+
+    /** Niveau courant (minimum sur les ciphertexts) */
+    int level(heaan::HomEval& eval) const;
+
+    int size() const { return layout.size(); }
+    int batch() const { return layout.batch(); }
+};
+
+/**
+ * Exécuter work(i, eval, encoder) pour i = 0..count-1, un ciphertext par tâche
+ *
+ * Les ciphertexts d'un tenseur découpé sont indépendants: les tâches
+ * tournent sur des threads (au plus num_threads), chacun avec son
+ * évaluateur et son encodeur (FheContext::eval(worker), créés au premier
+ * appel puis réutilisés); les clés de rotation restent partagées.
+ * Une seule tâche s'exécute directement sur l'évaluateur du contexte.
+ *
+ * @param count Nombre de tâches
+ * @param ctx Contexte FHE (preset, clés de rotation)
+ * @param work Tâche i (ne doit écrire que dans son propre résultat)
+ * @param num_threads Nombre de threads (0 = tous les cœurs)
+ * @throws La première exception levée par une tâche
+ */
+void parallel_for_cts(
+    int count,
+    FheContext& ctx,
+    const std::function<void(int, heaan::HomEval&, heaan::EnDecoder&)>& work,
+    int num_threads = 0
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_CT_TENSOR_HPP
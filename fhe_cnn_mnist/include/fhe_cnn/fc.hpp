@@ -2,34 +2,42 @@
 #define FHE_CNN_FC_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
 #include <vector>
-#include <map>
 
 namespace fhe_cnn {
 
 /**
  * Fully Connected layer homomorphique
  * 
- * @param x_enc Ciphertext d'entrée (vecteur packé dans les slots)
+ * L'entrée est lue à plat: in_features = x.size() éléments consécutifs du
+ * layout, quels que soient ses strides. Un tenseur découpé par canaux
+ * donne un produit partiel par ciphertext (colonnes de ses canaux, en
+ * parallèle), sommés avant le bias.
+ * 
+ * @param x Tenseur d'entrée
  * @param weight Poids [out_features * in_features]
  * @param bias Bias [out_features]
- * @param in_features Taille d'entrée
  * @param out_features Taille de sortie
- * @param sk Clé secrète
- * @param rot_keys Clés de rotation pour BSGS
- * @param eval Évaluateur homomorphe
+ * @param ctx Contexte FHE (évaluateur, encodeur, rotations BSGS)
+ * @param complex_packed Entrée en packing complexe: bias encodé b·(1 + i)
+ * @return Vecteur dense out_features × 1 × 1, mêmes images
  */
-heaan::Ptr<heaan::ICiphertext> homomorphic_fc(
-    const heaan::ICiphertext& x_enc,
+CtTensor homomorphic_fc(
+    const CtTensor& x,
     const std::vector<double>& weight,
     const std::vector<double>& bias,
-    int in_features,
     int out_features,
-    const heaan::ISecretKey& sk,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys,
-    heaan::HomEval& eval
+    FheContext& ctx,
+    bool complex_packed = false
 );
 
+/**
+ * Rotations utilisées par homomorphic_fc (baby steps, rotate-and-sum, giant steps)
+ */
+std::vector<int> fc_rotation_shifts(int out_features, const SlotLayout& layout = SlotLayout());
+
 } // namespace fhe_cnn
 
 #endif // FHE_CNN_FC_HPP
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef FHE_CNN_FHE_CONTEXT_HPP
+#define FHE_CNN_FHE_CONTEXT_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/server_context.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Contexte FHE unifié
+ *
+ * Créé une fois par processus et passé à toutes les couches: preset,
+ * évaluateur, encodeur, chiffreur et clés d'évaluation (ServerContext:
+ * relinéarisation, rotations, bootstrap). Les couches n'instancient plus
+ * leur propre EnDecoder à chaque appel, et changer de preset ne se fait
+ * qu'à la construction du contexte.
+ *
+ * Comme ServerContext, ne contient jamais de clé secrète.
+ */
+class FheContext {
+public:
+    /**
+     * Depuis un paquet de clés
+     *
+     * @param bundle Paquet projeté en mémoire
+     * @param max_resident Budget de clés de rotation résidentes (0 = illimité)
+     */
+    explicit FheContext(std::shared_ptr<const KeyBundle> bundle, size_t max_resident = 0);
+
+    /**
+     * Client et serveur dans le même processus (génération, tests)
+     *
+     * @param preset_id Paramètres
+     * @param sk Clé secrète (génération des clés d'évaluation, non conservée)
+     * @param with_bootstrap Générer les clés de bootstrap
+     * @param max_resident Budget de clés de rotation résidentes (0 = illimité)
+     */
+    FheContext(
+        heaan::PresetParamsId preset_id,
+        const heaan::ISecretKey& sk,
+        bool with_bootstrap = true,
+        size_t max_resident = 0
+    );
+
+    FheContext(const FheContext&) = delete;
+    FheContext& operator=(const FheContext&) = delete;
+
+    heaan::PresetParamsId preset() const { return server_.preset(); }
+    int logSlots() const { return server_.logSlots(); }
+    int numSlots() const { return 1 << server_.logSlots(); }
+
+    heaan::HomEval& eval() { return eval_; }
+    heaan::EnDecoder& encoder() { return encoder_; }
+    heaan::EnDecryptor& encryptor() { return encryptor_; }
+
+    /**
+     * Évaluateur et encodeur du thread worker de parallel_for_cts
+     *
+     * Le worker 0 est le thread appelant (eval(), encoder()); les autres
+     * sont créés par reserveWorkers() puis réutilisés d'un appel à l'autre.
+     * Un seul parallel_for_cts à la fois par contexte.
+     */
+    heaan::HomEval& eval(int worker) {
+        return worker == 0 ? eval_ : workers_.at(worker - 1)->eval;
+    }
+    heaan::EnDecoder& encoder(int worker) {
+        return worker == 0 ? encoder_ : workers_.at(worker - 1)->encoder;
+    }
+
+    /** Créer les évaluateurs/encodeurs manquants pour count workers */
+    void reserveWorkers(int count) {
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        while ((int)workers_.size() < count - 1) {
+            workers_.push_back(std::make_unique<Worker>(preset()));
+        }
+    }
+
+    ServerContext& server() { return server_; }
+    const ServerContext& server() const { return server_; }
+
+    const heaan::ISwKey& relinKey() const { return server_.relinKey(); }
+    RotationKeyStore& rotKeys() { return server_.rotKeys(); }
+    bool hasBootstrap() const { return server_.hasBootstrap(); }
+    BootstrapContext& bootstrap() { return server_.bootstrap(); }
+
+private:
+    struct Worker {
+        heaan::HomEval eval;
+        heaan::EnDecoder encoder;
+
+        explicit Worker(heaan::PresetParamsId preset_id) : eval(preset_id), encoder(preset_id) {}
+    };
+
+    ServerContext server_;
+    heaan::HomEval eval_;
+    heaan::EnDecoder encoder_;
+    heaan::EnDecryptor encryptor_;
+
+    std::mutex workers_mutex_;
+    std::vector<std::unique_ptr<Worker>> workers_;  // Workers 1..n-1
+};
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_FHE_CONTEXT_HPP
@@ -0,0 +1,157 @@
+#ifndef FHE_CNN_KEY_BUNDLE_HPP
+#define FHE_CNN_KEY_BUNDLE_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fhe_cnn {
+
+class ServerContext;
+
+/**
+ * Paquet de clés d'évaluation sur disque
+ *
+ * Format binaire, dans l'ordre d'octets de la machine qui l'écrit (un
+ * marqueur d'en-tête fait refuser un paquet venu d'une machine de l'autre
+ * ordre):
+ * - En-tête: magic "FHEKEYS2", marqueur d'ordre d'octets, preset, graine,
+ *   log_slots, niveau de sortie du bootstrap, position et taille du
+ *   répertoire
+ * - Une clé sérialisée par bloc, chaque bloc aligné sur une page
+ * - Répertoire en fin de fichier: (type, rotation, position, taille) par clé
+ *
+ * Le fichier est projeté en mémoire (mmap, lecture seule, partagé): ouvrir
+ * un paquet ne lit que l'en-tête et le répertoire, chaque clé n'est paginée
+ * qu'au moment où elle est chargée, et plusieurs processus qui ouvrent le
+ * même fichier partagent les pages du cache.
+ *
+ * Jamais de clé secrète: elle est dans un fichier client séparé (voir
+ * write_secret_key), un paquet qui en contient est refusé.
+ */
+class KeyBundle {
+public:
+    enum class KeyKind : uint32_t {
+        Secret = 0,  // Refusée dans un paquet
+        Relin = 1,
+        Conj = 2,
+        Rot = 3,
+        Boot = 4
+    };
+
+    /**
+     * Projeter un paquet existant
+     *
+     * @param path Chemin du fichier
+     * @param preset_id Preset attendu
+     * @param seed Graine attendue
+     * @throws std::runtime_error si le fichier est illisible, corrompu ou
+     *         généré pour un autre preset / une autre graine
+     */
+    KeyBundle(const std::string& path, heaan::PresetParamsId preset_id, uint64_t seed);
+    ~KeyBundle();
+
+    KeyBundle(const KeyBundle&) = delete;
+    KeyBundle& operator=(const KeyBundle&) = delete;
+
+    heaan::PresetParamsId preset() const { return preset_id_; }
+    uint64_t seed() const { return seed_; }
+    int logSlots() const { return log_slots_; }
+
+    bool has(KeyKind kind, int shift = 0) const;
+    bool hasRotKey(int shift) const { return has(KeyKind::Rot, shift); }
+
+    /** Rotations présentes dans le paquet, triées */
+    std::vector<int> rotShifts() const;
+
+    heaan::Ptr<heaan::ISwKey> loadRelinKey() const;
+    heaan::Ptr<heaan::ISwKey> loadConjKey() const;
+    heaan::Ptr<heaan::ISwKey> loadRotKey(int shift) const;
+    std::unique_ptr<heaan::BootKeyPtrs> loadBootKeys() const;
+
+    /** Niveau après bootstrap mesuré à l'écriture (-1 si pas de clés de bootstrap) */
+    int bootOutputLevel() const { return boot_output_level_; }
+
+private:
+    struct Span {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const Span& find(KeyKind kind, int shift) const;
+
+    // Flux sur la zone projetée; pages relâchées après lecture
+    template <typename Loader>
+    void read(KeyKind kind, int shift, Loader&& load) const;
+
+    std::string path_;
+    heaan::PresetParamsId preset_id_;
+    uint64_t seed_;
+    int log_slots_;
+    int boot_output_level_;
+
+    const char* data_;
+    size_t size_;
+    std::map<std::pair<uint32_t, int>, Span> directory_;
+};
+
+/**
+ * Chemin canonique d'un paquet: <dir>/keys_p<preset>_s<seed>.bin
+ */
+std::string key_bundle_path(const std::string& dir, heaan::PresetParamsId preset_id, uint64_t seed);
+
+bool key_bundle_exists(const std::string& path);
+
+/**
+ * Écrire un paquet de clés
+ *
+ * Contient les clés d'évaluation du serveur uniquement: relinéarisation,
+ * conjugaison, toutes les clés de rotation résidentes et les clés de
+ * bootstrap s'il en a.
+ *
+ * @param path Chemin du fichier (écrit dans un temporaire puis renommé)
+ * @param seed Graine identifiant le jeu de clés
+ * @param server Contexte serveur (preset et clés d'évaluation)
+ */
+void write_key_bundle(
+    const std::string& path,
+    uint64_t seed,
+    const ServerContext& server
+);
+
+/**
+ * Chemin canonique de la clé secrète: <dir>/sk_p<preset>_s<seed>.bin
+ */
+std::string secret_key_path(const std::string& dir, heaan::PresetParamsId preset_id, uint64_t seed);
+
+/**
+ * Écrire la clé secrète du client (fichier séparé du paquet, mode 0600)
+ *
+ * Format: magic "FHESKEY1", marqueur d'ordre d'octets, preset, graine,
+ * puis la clé sérialisée.
+ */
+void write_secret_key(
+    const std::string& path,
+    heaan::PresetParamsId preset_id,
+    uint64_t seed,
+    const heaan::ISecretKey& sk
+);
+
+/**
+ * Relire la clé secrète du client
+ *
+ * @throws std::runtime_error si le fichier est illisible ou écrit pour un
+ *         autre preset / une autre graine
+ */
+heaan::Ptr<heaan::ISecretKey> load_secret_key(
+    const std::string& path,
+    heaan::PresetParamsId preset_id,
+    uint64_t seed
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_KEY_BUNDLE_HPP
@@ -0,0 +1,130 @@
+#ifndef FHE_CNN_KEY_STORE_HPP
+#define FHE_CNN_KEY_STORE_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fhe_cnn {
+
+class KeyBundle;
+
+/**
+ * Table des clés de rotation
+ *
+ * - Accès O(1): tableau dense indexé par la rotation normalisée [0, num_slots)
+ * - Chargement paresseux: une clé absente est lue dans le paquet attaché
+ *   (voir KeyBundle), sinon générée au premier get() si une clé secrète
+ *   est fournie
+ * - Budget mémoire: au plus max_resident clés; au-delà, la clé la moins
+ *   utilisée (puis la plus ancienne) est évincée
+ * - Compteurs hits / misses / évictions
+ *
+ * Toutes les clés d'un preset ont la même taille: le budget mémoire se
+ * donne en nombre de clés. Thread-safe; get() renvoie un shared_ptr qui
+ * garde la clé vivante même si elle est évincée pendant son utilisation.
+ */
+class RotationKeyStore {
+public:
+    /**
+     * @param preset_id Paramètres
+     * @param log_slots log2(nombre de slots)
+     * @param sk Clé secrète pour la génération (nullptr = table figée)
+     * @param max_resident Nombre maximal de clés résidentes (0 = illimité)
+     */
+    RotationKeyStore(
+        heaan::PresetParamsId preset_id,
+        int log_slots,
+        const heaan::ISecretKey* sk = nullptr,
+        size_t max_resident = 0
+    );
+
+    RotationKeyStore(const RotationKeyStore&) = delete;
+    RotationKeyStore& operator=(const RotationKeyStore&) = delete;
+
+    /**
+     * Clé pour une rotation (chargée ou générée si absente)
+     *
+     * La lecture / génération d'une clé absente se fait hors verrou: les
+     * autres get() ne l'attendent pas, sauf ceux qui demandent la même clé.
+     *
+     * @throws std::runtime_error si absente, hors du paquet et table figée
+     */
+    std::shared_ptr<const heaan::ISwKey> get(int shift);
+
+    /**
+     * Rendre résidentes les clés manquantes: lues dans le paquet attaché si
+     * possible, les autres générées en parallèle (un générateur par thread)
+     *
+     * Sous budget, au plus max_resident clés sont générées (dans l'ordre de
+     * shifts); les suivantes le seront au premier get().
+     *
+     * @param shifts Rotations voulues (doublons et clés présentes ignorés)
+     * @param num_threads Nombre de threads (0 = tous les cœurs)
+     */
+    void generate(const std::vector<int>& shifts, int num_threads = 0);
+
+    /**
+     * Ajouter une clé existante (chargée ou générée ailleurs)
+     */
+    void insert(int shift, std::shared_ptr<const heaan::ISwKey> key);
+
+    /**
+     * Attacher un paquet de clés sur disque (source des clés absentes)
+     */
+    void attach(std::shared_ptr<const KeyBundle> bundle);
+
+    /** Clé résidente, sans compter d'accès (nullptr si absente) */
+    std::shared_ptr<const heaan::ISwKey> find(int shift) const;
+
+    /** Rotations dont la clé est résidente, triées */
+    std::vector<int> residentShifts() const;
+
+    bool resident(int shift) const;
+    /** Clé résidente, dans le paquet attaché ou générable */
+    bool available(int shift) const;
+    bool lazy() const { return sk_ != nullptr; }
+    bool full() const;
+
+    int logSlots() const { return log_slots_; }
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+    size_t evictions() const;
+
+    void printStats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const heaan::ISwKey> key;
+        uint64_t uses = 0;
+        uint64_t last_use = 0;
+    };
+
+    int normalize(int shift) const;
+    void store(int s, std::shared_ptr<const heaan::ISwKey> key);  // mutex tenu
+    void evictOne(int keep);                                       // mutex tenu
+
+    heaan::PresetParamsId preset_id_;
+    int log_slots_;
+    const heaan::ISecretKey* sk_;
+    size_t max_resident_;
+    std::shared_ptr<const KeyBundle> bundle_;
+
+    std::vector<Entry> entries_;
+    std::map<int, std::shared_future<std::shared_ptr<const heaan::ISwKey>>> pending_;  // En cours
+    size_t resident_ = 0;
+    uint64_t clock_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t evictions_ = 0;
+    mutable std::mutex mutex_;
+};
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_KEY_STORE_HPP
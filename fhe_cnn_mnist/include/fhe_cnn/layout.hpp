@@ -0,0 +1,73 @@
+#ifndef FHE_CNN_LAYOUT_HPP
+#define FHE_CNN_LAYOUT_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Ordre des images dans les slots
+ *
+ * Block      : slot = image·stride + i (blocs contigus)
+ * Interleaved: slot = i·batch + image (l'indice d'image varie le plus vite)
+ */
+enum class BatchOrder {
+    Block,
+    Interleaved
+};
+
+/**
+ * Placement de batch images dans les slots d'un ciphertext
+ *
+ * En entrelacé, décaler chaque image de s éléments est une rotation de
+ * s·batch: la même rotation sert les batch images à l'identique, sans
+ * déborder d'une image sur sa voisine. En blocs, la rotation vaut s et
+ * les derniers éléments d'un bloc lisent le début du bloc suivant.
+ *
+ * Le layout par défaut (un bloc, stride 0) est celui d'une image seule:
+ * slot = i, rotation = s.
+ */
+struct SlotLayout {
+    BatchOrder order = BatchOrder::Block;
+    int batch = 1;    // Images par ciphertext
+    int stride = 0;   // Block: écart entre deux images (slots)
+
+    static SlotLayout block(int batch, int stride);
+    static SlotLayout interleaved(int batch);
+
+    /** Slot de l'élément index de l'image image */
+    int slot(int image, int index) const;
+
+    /** Rotation qui décale chaque image de shift éléments */
+    int rotation(int shift) const;
+
+    /** Rotations pour une liste de décalages par image */
+    std::vector<int> rotations(const std::vector<int>& shifts) const;
+
+    /** Slots couverts par size éléments de chaque image (0 .. span-1) */
+    int span(int size) const;
+
+    bool interleavedOrder() const { return order == BatchOrder::Interleaved; }
+};
+
+/**
+ * Message avec values[i] à l'élément i de chaque image (zéros ailleurs)
+ *
+ * Sert aux poids, bias et masques des couches: une même valeur par
+ * élément, répliquée pour les batch images du layout.
+ *
+ * @param values Valeurs par élément (communes à toutes les images)
+ * @param layout Placement des images
+ * @param log_slots log2(nombre de slots)
+ * @throws std::runtime_error si layout.span(values.size()) dépasse les slots
+ */
+heaan::Message<heaan::Complex> broadcast_message(
+    const std::vector<heaan::Complex>& values,
+    const SlotLayout& layout,
+    int log_slots
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_LAYOUT_HPP
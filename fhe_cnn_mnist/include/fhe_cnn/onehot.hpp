@@ -2,10 +2,26 @@
 #define FHE_CNN_ONEHOT_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
-#include <map>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
+#include <vector>
 
 namespace fhe_cnn {
 
+/**
+ * Fonction échelon approximée (polynôme de signe ramené dans [0, 1])
+ * 
+ * @param diff_enc Ciphertext des différences x - y
+ * @param eval Évaluateur homomorphe
+ * @param relin_key Clé de relinéarisation
+ * @return Ciphertext avec ≈1 si diff > 0, ≈0 sinon (0.5 en 0)
+ */
+heaan::Ptr<heaan::ICiphertext> homomorphic_step(
+    const heaan::ICiphertext& diff_enc,
+    heaan::HomEval& eval,
+    const heaan::ISwKey& relin_key
+);
+
 /**
  * Comparaison homomorphe (approximation polynomiale)
  * 
@@ -33,27 +49,60 @@ heaan::Ptr<heaan::ICiphertext> homomorphic_gt(
  */
 heaan::Ptr<heaan::ICiphertext> homomorphic_max(
     const heaan::ICiphertext& logits_enc,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys,
+    RotationKeyStore& rot_keys,
     heaan::HomEval& eval,
     const heaan::ISwKey& relin_key
 );
 
+/**
+ * Argmax SIMD : toutes les comparaisons deux à deux en un seul passage
+ * 
+ * Stratégie:
+ * 1. Répliquer les logits dans 2n-1 blocs (rotations log-step)
+ * 2. Construire dans le même ciphertext les copies décalées de -(n-1)..(n-1)
+ * 3. Un seul polynôme de signe sur toutes les différences x_i - x_j
+ * 4. Somme par classe sur les blocs (rotate-and-sum)
+ * 
+ * Le logit t de l'image m est au slot slots.slot(m, t); les copies
+ * décalées avancent d'une classe (slots.rotation(1)) par bloc. Des blocs
+ * trop espacés pour tenir (stride du packer) sont d'abord ramenés à
+ * num_classes slots par image, par la permutation qui tient lieu de masque
+ * d'isolement (même profondeur).
+ * 
+ * @param logits Vecteur dense de num_classes logits par image
+ * @param ctx Contexte FHE (rotations: voir argmax_rotation_shifts)
+ * @return Un score par classe (≈1 au max), à l'emplacement de l'entrée
+ *         ou en blocs de num_classes slots après rapprochement
+ */
+CtTensor homomorphic_argmax(
+    const CtTensor& logits,
+    FheContext& ctx
+);
+
+/**
+ * Rotations nécessaires à homomorphic_argmax
+ * 
+ * Les rotations à droite sont ramenées dans [0, num_slots).
+ * 
+ * @return Liste des décalages (sans doublons) à générer
+ */
+std::vector<int> argmax_rotation_shifts(
+    int num_classes,
+    const SlotLayout& layout,
+    int log_slots
+);
+
 /**
  * Convertir les logits en one-hot vector
  * 
- * @param logits_enc Ciphertext avec 10 logits dans slots 0-9
- * @param sk Clé secrète (pour bootstrap si nécessaire)
- * @param rot_keys Clés de rotation
- * @param eval Évaluateur homomorphe
- * @param relin_key Clé de relinéarisation
- * @return Ciphertext one-hot vector (1 au max, 0 ailleurs)
+ * @param logits Logits packés (voir homomorphic_argmax)
+ * @param ctx Contexte FHE (rotations, relinéarisation, bootstrap si
+ *            niveau insuffisant)
+ * @return One-hot vector (≈1 au max, <1 ailleurs)
  */
-heaan::Ptr<heaan::ICiphertext> homomorphic_onehot(
-    const heaan::ICiphertext& logits_enc,
-    const heaan::ISecretKey& sk,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys,
-    heaan::HomEval& eval,
-    const heaan::ISwKey& relin_key
+CtTensor homomorphic_onehot(
+    const CtTensor& logits,
+    FheContext& ctx
 );
 
 } // namespace fhe_cnn
@@ -0,0 +1,165 @@
+#ifndef FHE_CNN_PERMUTATION_HPP
+#define FHE_CNN_PERMUTATION_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/key_store.hpp"
+#include "fhe_cnn/layout.hpp"
+#include "fhe_cnn/utils.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Déplacement d'un élément: out[dst] = weight · in[src]
+ *
+ * Indices en éléments d'une image (les mêmes déplacements s'appliquent à
+ * chaque image du SlotLayout). Un élément absent des déplacements est mis
+ * à zéro; weight sert de masque ou de facteur (ex. ×0.25 d'une moyenne).
+ */
+struct SlotMove {
+    int src;
+    int dst;
+    double weight = 1.0;
+};
+
+/**
+ * Décomposition d'une permutation en rotations
+ *
+ * Bsgs        : diagonales regroupées en baby steps b et giant steps
+ *               g·n1 (décalage = g·n1 + b), masques pré-tournés;
+ *               ≈ 2·√(décalage max) rotations, un niveau.
+ * ShiftNetwork: réseau de décalages log-step (type Beneš, routage bit à
+ *               bit du poids faible au poids fort): une ou deux rotations
+ *               de ±2^k par étage, un niveau par étage. Valide seulement
+ *               si aucun étage ne fait collisionner deux éléments
+ *               (compactions et décalages qui préservent l'ordre).
+ */
+enum class PermutationMethod {
+    Bsgs,
+    ShiftNetwork
+};
+
+/**
+ * Modèle de coût: rotations × rotation + profondeur × level, sous
+ * profondeur <= max_depth
+ */
+struct PermutationCost {
+    double rotation = 1.0;   // Coût d'un key-switch
+    double level = 4.0;      // Coût d'un niveau consommé
+    int max_depth = 1;       // Niveaux disponibles pour la permutation
+};
+
+/**
+ * Permutation de slots compilée
+ *
+ * Le plan (méthode, rotations, masques) est calculé à la construction;
+ * les plaintexts des masques sont encodés au premier apply() à chaque
+ * niveau, directement à ce niveau, puis conservés. apply() est thread-safe.
+ */
+class SlotPermutation {
+public:
+    /**
+     * @param moves Déplacements (destinations distinctes)
+     * @param extent Éléments utilisables par image (positions intermédiaires comprises)
+     * @param layout Placement des images
+     * @param log_slots log2(nombre de slots)
+     * @param cost Modèle de coût pour le choix de la méthode
+     * @throws std::runtime_error si moves est vide, si un indice sort de [0, extent), si deux
+     *         déplacements visent la même destination ou si aucune méthode
+     *         ne tient dans cost.max_depth
+     */
+    SlotPermutation(
+        std::vector<SlotMove> moves,
+        int extent,
+        const SlotLayout& layout,
+        int log_slots,
+        const PermutationCost& cost = PermutationCost()
+    );
+
+    PermutationMethod method() const { return method_; }
+
+    /** Key-switches par application */
+    int rotations() const { return countRotations(stages_); }
+
+    /** Niveaux consommés */
+    int depth() const { return (int)stages_.size(); }
+
+    /** Rotations utilisées (slots, multipliées par le batch en entrelacé) */
+    std::vector<int> rotationShifts() const;
+
+    /** Appliquer la permutation à un ciphertext */
+    heaan::Ptr<heaan::ICiphertext> apply(
+        const heaan::ICiphertext& ctxt,
+        RotationKeyStore& rot_keys,
+        heaan::HomEval& eval,
+        heaan::EnDecoder& encoder
+    ) const;
+
+    /**
+     * Appliquer le plan en clair aux éléments d'une image (mêmes rotations
+     * et masques), pour vérifier un plan sans chiffrer
+     */
+    std::vector<double> simulate(const std::vector<double>& elements) const;
+
+    const std::vector<SlotMove>& moves() const { return moves_; }
+    int extent() const { return extent_; }
+    const SlotLayout& layout() const { return layout_; }
+    int logSlots() const { return log_slots_; }
+    const PermutationCost& cost() const { return cost_; }
+
+private:
+    // Terme d'un groupe: masque ⊙ Rot_shift(entrée de l'étage)
+    struct Term {
+        int shift;
+        std::vector<double> mask;   // Par élément d'image
+    };
+
+    // Groupe: Rot_post(Σ termes); un étage somme ses groupes (un niveau)
+    struct Group {
+        int post;
+        std::vector<Term> terms;
+    };
+
+    using Stage = std::vector<Group>;
+
+    static int countRotations(const std::vector<Stage>& stages);
+    bool planBsgs(std::vector<Stage>& stages) const;
+    bool planShiftNetwork(std::vector<Stage>& stages) const;
+    void buildMasks() const;
+
+    std::vector<SlotMove> moves_;
+    int extent_;
+    SlotLayout layout_;
+    int log_slots_;
+    PermutationCost cost_;
+    PermutationMethod method_;
+    std::vector<Stage> stages_;
+
+    mutable std::mutex mutex_;
+    mutable std::vector<std::vector<std::vector<std::unique_ptr<LeveledPlaintext>>>> masks_;  // [étage][groupe][terme]
+};
+
+/**
+ * Permutation compilée, mise en cache par contenu
+ *
+ * Les mêmes déplacements (même extent, layout, logSlots, coût et preset)
+ * renvoient le même plan, avec ses plaintexts déjà encodés: une couche
+ * rappelée à chaque lot ne replanifie ni ne réencode rien. Le preset fait
+ * partie de la clé car les masques sont encodés avec ses paramètres.
+ *
+ * @param preset_id Preset de l'encodeur passé à apply()
+ */
+std::shared_ptr<const SlotPermutation> make_permutation(
+    const std::vector<SlotMove>& moves,
+    int extent,
+    const SlotLayout& layout,
+    int log_slots,
+    heaan::PresetParamsId preset_id,
+    const PermutationCost& cost = PermutationCost()
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_PERMUTATION_HPP
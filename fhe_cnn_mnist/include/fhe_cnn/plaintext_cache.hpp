@@ -0,0 +1,110 @@
+#ifndef FHE_CNN_PLAINTEXT_CACHE_HPP
+#define FHE_CNN_PLAINTEXT_CACHE_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Cache de plaintexts par contenu
+ *
+ * - Clé: hash du preset, du niveau et du message (valeurs de tous les
+ *   slots); égalité exacte vérifiée, une collision de hash ne sert jamais
+ *   un autre plaintext. L'échelle d'encodage est celle du preset au niveau
+ *   demandé: (preset, niveau) la fixe, un sweep de presets ne réutilise
+ *   jamais un plaintext encodé pour un autre
+ * - Budget mémoire en limbs: un plaintext au niveau l en porte l + 1; au-delà
+ *   du budget, l'entrée la moins utilisée (puis la plus ancienne) est
+ *   évincée
+ * - Compteurs hits / misses / évictions
+ *
+ * Thread-safe; l'encodage d'un miss se fait hors verrou. get() renvoie un
+ * shared_ptr qui garde le plaintext vivant même s'il est évincé pendant son
+ * utilisation.
+ */
+class PlaintextCache {
+public:
+    /**
+     * @param max_limbs Budget en limbs (0 = illimité)
+     */
+    explicit PlaintextCache(size_t max_limbs = 0);
+
+    PlaintextCache(const PlaintextCache&) = delete;
+    PlaintextCache& operator=(const PlaintextCache&) = delete;
+
+    /** Cache partagé par tout le processus (masques, poids, constantes) */
+    static PlaintextCache& global();
+
+    /**
+     * Plaintext de msg au niveau level (encodé au premier appel)
+     *
+     * @param msg Message à encoder
+     * @param level Niveau du ciphertext qui consommera le plaintext
+     * @param preset_id Preset de encoder et eval
+     * @param encoder Encodeur (utilisé seulement en cas de miss)
+     * @param eval Évaluateur homomorphe (idem)
+     */
+    std::shared_ptr<const heaan::IPlaintext> get(
+        const heaan::Message<heaan::Complex>& msg,
+        int level,
+        heaan::PresetParamsId preset_id,
+        heaan::EnDecoder& encoder,
+        heaan::HomEval& eval
+    );
+
+    /** Changer le budget (évince immédiatement si nécessaire) */
+    void setBudget(size_t max_limbs);
+
+    /** Vider le cache (les compteurs sont conservés) */
+    void clear();
+
+    size_t size() const;
+    size_t limbs() const;
+    size_t hits() const;
+    size_t misses() const;
+    size_t evictions() const;
+
+    void printStats() const;
+
+private:
+    struct Entry {
+        heaan::Message<heaan::Complex> msg;
+        int level;
+        heaan::PresetParamsId preset_id;
+        std::shared_ptr<const heaan::IPlaintext> ptxt;
+        uint64_t uses = 0;
+        uint64_t last_use = 0;
+    };
+
+    void evictOver(size_t limit);  // mutex tenu
+
+    size_t max_limbs_;
+    mutable std::mutex mutex_;
+    std::unordered_map<size_t, std::vector<Entry>> entries_;  // Par hash
+    size_t size_ = 0;
+    size_t limbs_ = 0;
+    uint64_t clock_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t evictions_ = 0;
+};
+
+/**
+ * Plaintext de msg au niveau level, par le cache global
+ */
+std::shared_ptr<const heaan::IPlaintext> encode_cached(
+    const heaan::Message<heaan::Complex>& msg,
+    int level,
+    heaan::PresetParamsId preset_id,
+    heaan::EnDecoder& encoder,
+    heaan::HomEval& eval
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_PLAINTEXT_CACHE_HPP
@@ -0,0 +1,96 @@
+#ifndef FHE_CNN_PLANNER_HPP
+#define FHE_CNN_PLANNER_HPP
+
+#include <string>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Types de couches connus du planificateur
+ */
+enum class LayerKind {
+    Conv2d,
+    AvgPool,
+    FC,
+    ReLU,
+    OneHot
+};
+
+/**
+ * Description d'une couche du réseau pour la planification des niveaux
+ */
+struct LayerSpec {
+    std::string name;
+    LayerKind kind;
+    int relu_degree = 5;      // ReLU uniquement
+    double relu_scale = 1.0;  // ReLU uniquement (entrée dans [-scale, scale])
+    bool split_complex = false;  // Sépare réel/imaginaire en entrée (packing complexe)
+};
+
+/**
+ * Plan de niveaux: où bootstrapper et comment replier les scales
+ * 
+ * Tous les vecteurs sont indexés par couche.
+ */
+struct LevelPlan {
+    std::vector<bool> bootstrap_before;  // Bootstrap juste avant la couche
+    std::vector<int> level_in;           // Niveau à l'entrée (après bootstrap)
+    std::vector<int> level_out;          // Niveau à la sortie
+    std::vector<double> weight_scale;    // Facteur à appliquer aux poids (couches linéaires)
+    std::vector<double> bias_scale;      // Facteur à appliquer au bias (couches linéaires)
+    std::vector<double> relu_scale;      // Scale effectif passé à homomorphic_relu
+    std::vector<double> value_scale;     // Le ciphertext contient valeur / value_scale
+    int num_bootstraps = 0;
+};
+
+/**
+ * Niveaux consommés par une couche (coûts déclarés)
+ * 
+ * @param layer Couche (pour ReLU: degré et scale effectif)
+ * @return Nombre de niveaux consommés
+ */
+int layer_depth(const LayerSpec& layer);
+
+/**
+ * Calculer le nombre minimal de bootstraps et leur placement
+ * 
+ * Stratégie gloutonne: on bootstrappe le plus tard possible, juste avant
+ * la première couche qui ferait descendre sous min_level, ou qui ne
+ * laisserait plus assez de niveaux aux masques d'un bootstrap suivant
+ * quand la fin du réseau ne tient pas sans lui. Pour une chaîne
+ * de couches avec un bootstrap qui remet toujours au même niveau, c'est
+ * optimal.
+ * 
+ * Si fold_scales est vrai, le 1/scale de chaque ReLU est replié dans les
+ * poids de la couche linéaire précédente et le ×scale dans ceux de la
+ * suivante (AvgPool est transparent). La ReLU tourne alors avec scale 1
+ * et économise 2 niveaux, ce qui est pris en compte dans le placement.
+ * 
+ * @param network Couches dans l'ordre d'exécution
+ * @param initial_level Niveau d'un ciphertext frais
+ * @param boot_level Niveau après bootstrap
+ * @param min_level Niveau minimum autorisé en sortie de couche
+ * @param fold_scales Replier les scales des ReLU dans les couches linéaires
+ * @param boot_input_depth Niveaux consommés juste avant chaque bootstrap
+ *        (masques du bootstrap fusionné): l'entrée du bootstrap garde
+ *        min_level après eux
+ * @return Plan (lève une exception si une couche ne tient pas après bootstrap)
+ */
+LevelPlan plan_levels(
+    const std::vector<LayerSpec>& network,
+    int initial_level,
+    int boot_level,
+    int min_level = 0,
+    bool fold_scales = true,
+    int boot_input_depth = 0
+);
+
+/**
+ * Afficher le plan (une ligne par couche)
+ */
+void print_plan(const std::vector<LayerSpec>& network, const LevelPlan& plan);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_PLANNER_HPP
@@ -2,8 +2,10 @@
 #define FHE_CNN_POOLING_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
 
-#include <map>
+#include <vector>
 
 namespace fhe_cnn {
 
@@ -11,26 +13,40 @@ namespace fhe_cnn {
  * Average Pooling 2x2 homomorphique
  * 
  * Stratégie: 
- * 1. Additionner les 4 pixels du pool par rotations
- * 2. Multiplier par 0.25 pour la moyenne
+ * 1. Additionner les 4 pixels du pool en deux rotations (w_stride puis h_stride)
+ * 2. Compaction: les pixels (2y, 2x) sont rangés en dense par une
+ *    SlotPermutation (BSGS, ≈ 2·√n rotations) dont les masques portent
+ *    aussi le ×0.25 de la moyenne: pas de niveau supplémentaire, pas de
+ *    slots perdus en aval
  * 
- * @param input_enc Ciphertext d'entrée (packé [c][h][w])
- * @param c Nombre de canaux
- * @param h Hauteur d'entrée
- * @param w Largeur d'entrée
- * @param rot_keys Clés de rotation (pour shift=1 et shift=w)
- * @param eval Évaluateur homomorphe
- * @return Ciphertext après pooling (c × h/2 × w/2)
+ * Sans compaction, le pixel (y, x) de sortie reste au slot du pixel
+ * (2y, 2x) d'entrée (strides doublés, trois slots sur quatre de déchets).
+ * Un tenseur découpé par canaux est poolé ciphertext par ciphertext, en
+ * parallèle, avec le même découpage en sortie.
+ * 
+ * @param input Tenseur d'entrée (c × h × w)
+ * @param ctx Contexte FHE (rotations de avgpool2d_rotation_shifts, ou leurs
+ *            décompositions)
+ * @param compact Ranger la sortie en dense
+ * @return Tenseur c × h/2 × w/2 (dense, ou strides h et w doublés)
  */
-heaan::Ptr<heaan::ICiphertext> homomorphic_avgpool2d(
-    const heaan::ICiphertext& input_enc,
-    int c,
-    int h,
-    int w,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys,
-    heaan::HomEval& eval
+CtTensor homomorphic_avgpool2d(
+    const CtTensor& input,
+    FheContext& ctx,
+    bool compact = true
 );
 
+/**
+ * Emplacement de la sortie de homomorphic_avgpool2d
+ */
+TensorLayout avgpool2d_output_layout(const TensorLayout& input, bool compact = true);
+
+/**
+ * Rotations utilisées par homomorphic_avgpool2d (somme 2×2, puis baby
+ * steps et giant steps de la compaction)
+ */
+std::vector<int> avgpool2d_rotation_shifts(const TensorLayout& input, int log_slots, bool compact = true);
+
 } // namespace fhe_cnn
 
 #endif // FHE_CNN_POOLING_HPP
\ No newline at end of file
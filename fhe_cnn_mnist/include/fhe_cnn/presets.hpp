@@ -0,0 +1,60 @@
+#ifndef FHE_CNN_PRESETS_HPP
+#define FHE_CNN_PRESETS_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Preset de paramètres HEAAN2 connu du programme
+ *
+ * Seuls le nom et le support du bootstrap sont déclarés ici: le nombre de
+ * slots et le niveau d'un ciphertext frais sont lus à l'exécution (clé
+ * secrète, chiffrement d'essai), chaque couche s'adapte via FheContext.
+ */
+struct PresetInfo {
+    heaan::PresetParamsId id;
+    const char* name;
+    bool bootstrap;  // Clés de bootstrap disponibles pour ce preset
+};
+
+/**
+ * Le réseau ne tient pas dans un preset (slots ou niveaux insuffisants)
+ *
+ * Seule erreur qu'un sweep des presets peut ignorer: toute autre exception
+ * est un vrai échec.
+ */
+class PresetMismatchError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Presets connus et présents dans le HEAAN2 installé, du plus gros au
+ * plus petit (F16Opt_Gr toujours présent)
+ */
+const std::vector<PresetInfo>& known_presets();
+
+/**
+ * Retrouver un preset par son nom (ex: "F16Opt_Gr")
+ *
+ * @throws std::runtime_error si le nom est inconnu (message avec la liste)
+ */
+heaan::PresetParamsId parse_preset(const std::string& name);
+
+/**
+ * Nom d'un preset ("?" s'il n'est pas dans la table)
+ */
+const char* preset_name(heaan::PresetParamsId preset_id);
+
+/**
+ * Le preset supporte-t-il le bootstrap?
+ */
+bool preset_has_bootstrap(heaan::PresetParamsId preset_id);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_PRESETS_HPP
@@ -2,6 +2,8 @@
 #define FHE_CNN_RELU_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
 
 namespace fhe_cnn {
 
@@ -15,17 +17,27 @@ namespace fhe_cnn {
  * 
  * @param input_enc Ciphertext d'entrée
  * @param degree Degré du polynôme (3, 5 ou 7)
- * @param scale_factor Facteur de scaling (entrée doit être dans [-scale_factor, scale_factor])
- * @param eval Évaluateur homomorphe
- * @param relin_key Clé de relinéarisation
+ * @param scale_factor Facteur de scaling (entrée doit être dans [-scale_factor, scale_factor]).
+ *                     Avec 1.0 aucune mise à l'échelle n'est faite (scale replié dans les poids).
+ * @param ctx Contexte FHE (évaluateur, relinéarisation)
  * @return Ciphertext après ReLU approximé
  */
 heaan::Ptr<heaan::ICiphertext> homomorphic_relu(
     const heaan::ICiphertext& input_enc,
     int degree,
     double scale_factor,
-    heaan::HomEval& eval,
-    const heaan::ISwKey& relin_key
+    FheContext& ctx
+);
+
+/**
+ * ReLU sur chaque ciphertext d'un tenseur (élément par élément:
+ * l'emplacement des données ne change pas)
+ */
+CtTensor homomorphic_relu(
+    const CtTensor& input,
+    int degree,
+    double scale_factor,
+    FheContext& ctx
 );
 
 } // namespace fhe_cnn
@@ -0,0 +1,224 @@
+#ifndef FHE_CNN_ROTATION_HPP
+#define FHE_CNN_ROTATION_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/key_store.hpp"
+#include "fhe_cnn/layout.hpp"
+#include <functional>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Décomposition d'une rotation en rotations disponibles
+ *
+ * Ordre de préférence:
+ * 1. Clé directe
+ * 2. NAF: somme de ±2^k (clés 2^k et num_slots - 2^k), poids minimal
+ * 3. Binaire: somme de 2^k (clés positives uniquement)
+ *
+ * @param shift Rotation à gauche (> 0) ou à droite (< 0)
+ * @param log_slots log2(nombre de slots)
+ * @param has_key Disponibilité d'une clé (rotation normalisée)
+ * @return Suite de rotations (clés) dont la composition vaut shift; vide si shift ≡ 0
+ * @throws std::runtime_error si aucune décomposition n'est possible
+ */
+std::vector<int> rotation_steps(
+    int shift,
+    int log_slots,
+    const std::function<bool(int)>& has_key
+);
+
+/**
+ * Rotation homomorphe avec repli par décomposition
+ *
+ * Clé directe si elle est résidente ou si la table peut la charger ou la
+ * générer sans évincer; sinon un key-switch par étape de rotation_steps sur les clés
+ * résidentes.
+ *
+ * @param ctxt Ciphertext d'entrée
+ * @param shift Rotation à gauche (> 0) ou à droite (< 0)
+ * @param rot_keys Table des clés de rotation
+ * @param eval Évaluateur homomorphe
+ * @return Ciphertext tourné
+ */
+heaan::Ptr<heaan::ICiphertext> homomorphic_rotate(
+    const heaan::ICiphertext& ctxt,
+    int shift,
+    RotationKeyStore& rot_keys,
+    heaan::HomEval& eval
+);
+
+/**
+ * Réplication log-step: out = Σ_{k<count} Rot_{k·shift}(ctxt)
+ *
+ * Rotate-and-add par doublements au lieu de count - 1 rotations:
+ * ⌊log2 count⌋ doublements plus une rotation par bit à 1 de count au-delà
+ * du premier (count quelconque, copies exactes). Une puissance de 2 coûte
+ * log2 count rotations. Le planning (doublements avec ajout en tête, ou
+ * concaténation de fenêtres 2^e) est choisi selon les clés de la table:
+ * le moins de key-switches, sinon rotations de 2^e·shift.
+ *
+ * shift est un décalage par image (éléments): en entrelacé chaque image se
+ * réplique dans son propre segment (rotation ×batch); en blocs, les copies
+ * doivent tenir dans le stride de l'image.
+ *
+ * @param ctxt Ciphertext à répliquer (slots hors valeur à zéro)
+ * @param count Nombre de copies (>= 1)
+ * @param shift Écart entre deux copies, sens de homomorphic_rotate
+ *              (< 0: copies vers les indices croissants)
+ * @param layout Placement des images
+ * @param rot_keys Table des clés (voir replicate_rotation_shifts)
+ * @param eval Évaluateur homomorphe
+ * @return Ciphertext répliqué (même niveau, aucune multiplication)
+ * @throws std::runtime_error si count < 1
+ */
+heaan::Ptr<heaan::ICiphertext> homomorphic_replicate(
+    const heaan::ICiphertext& ctxt,
+    int count,
+    int shift,
+    const SlotLayout& layout,
+    RotationKeyStore& rot_keys,
+    heaan::HomEval& eval
+);
+
+/**
+ * Rotations (slots) utilisées par homomorphic_replicate
+ *
+ * @param count Nombre de copies
+ * @param shift Écart entre deux copies (éléments par image)
+ * @param layout Placement des images
+ */
+std::vector<int> replicate_rotation_shifts(
+    int count,
+    int shift,
+    const SlotLayout& layout = SlotLayout()
+);
+
+/**
+ * Somme par blocs (rotate-and-sum segmenté)
+ *
+ * Les éléments sont groupés en blocs de block éléments d'écart stride;
+ * la tête de chaque bloc reçoit la somme de son bloc, pour tous les blocs
+ * et toutes les images à la fois:
+ *   out[h] = Σ_{i<block} x[h + i·stride]
+ * La fenêtre fait exactement block éléments (block quelconque, même
+ * planning que homomorphic_replicate): une tête ne lit jamais le bloc
+ * suivant. Les autres slots portent des sommes partielles à cheval sur deux
+ * blocs; block_heads_mask les annule (un niveau).
+ *
+ * @param ctxt Ciphertext d'entrée
+ * @param block Éléments par bloc (>= 1)
+ * @param stride Écart entre deux éléments d'un bloc (éléments par image)
+ * @param layout Placement des images
+ * @param rot_keys Table des clés (voir block_sum_rotation_shifts)
+ * @param eval Évaluateur homomorphe
+ * @return Sommes aux têtes de bloc (même niveau)
+ * @throws std::runtime_error si block < 1
+ */
+heaan::Ptr<heaan::ICiphertext> homomorphic_block_sum(
+    const heaan::ICiphertext& ctxt,
+    int block,
+    int stride,
+    const SlotLayout& layout,
+    RotationKeyStore& rot_keys,
+    heaan::HomEval& eval
+);
+
+/**
+ * Rotations (slots) utilisées par homomorphic_block_sum
+ */
+std::vector<int> block_sum_rotation_shifts(
+    int block,
+    int stride,
+    const SlotLayout& layout = SlotLayout()
+);
+
+/**
+ * Masque des têtes de bloc: 1 à l'élément k·block·stride (k < num_blocks)
+ * de chaque image, 0 ailleurs
+ */
+heaan::Message<heaan::Complex> block_heads_mask(
+    int block,
+    int num_blocks,
+    int stride,
+    const SlotLayout& layout,
+    int log_slots
+);
+
+/**
+ * Étape d'un plan de rotations multiples: Rot_to = Rot_key(Rot_from),
+ * key = to - from (normalisé), un key-switch
+ */
+struct RotationEdge {
+    int from;   // Rotation déjà calculée (0 = entrée)
+    int to;     // Rotation produite, normalisée dans [0, num_slots)
+};
+
+/**
+ * Planifier les rotations d'un même ciphertext
+ *
+ * Arbre de rotations: chaque rotation demandée part de l'entrée ou d'une
+ * rotation déjà calculée (demandée ou intermédiaire), par le chemin le plus
+ * court en clés disponibles (voir rotation_steps). Avec une clé directe
+ * par rotation, l'arbre est une étoile; sous budget de clés, les
+ * décompositions partagent leurs préfixes (ex. taps d'une convolution:
+ * Rot_{2·hs + 1} = Rot_1(Rot_{2·hs})).
+ *
+ * @param shifts Rotations demandées (doublons et rotations nulles ignorés)
+ * @param log_slots log2(nombre de slots)
+ * @param has_key Disponibilité d'une clé (rotation normalisée)
+ * @return Étapes dans l'ordre d'exécution (un key-switch chacune)
+ * @throws std::runtime_error si une rotation n'a aucune décomposition
+ */
+std::vector<RotationEdge> plan_rotations(
+    const std::vector<int>& shifts,
+    int log_slots,
+    const std::function<bool(int)>& has_key
+);
+
+/**
+ * Rotations multiples d'un même ciphertext
+ *
+ * Toutes les rotations d'une entrée (taps d'une convolution, baby steps
+ * BSGS) passent par un seul appel: le plan de plan_rotations partage les
+ * key-switches entre rotations. L'API publique de HEAAN2 n'expose que
+ * HomEval::rot (décomposition en digits refaite à chaque appel): c'est
+ * ici que se brancherait une rotation hoistée (décomposition unique,
+ * plusieurs clés de Galois).
+ *
+ * @param ctxt Ciphertext d'entrée
+ * @param shifts Rotations à gauche (> 0) ou à droite (< 0)
+ * @param rot_keys Table des clés de rotation
+ * @param eval Évaluateur homomorphe
+ * @return Un ciphertext par rotation, dans l'ordre de shifts (copie pour 0)
+ */
+std::vector<heaan::Ptr<heaan::ICiphertext>> homomorphic_rotate_many(
+    const heaan::ICiphertext& ctxt,
+    const std::vector<int>& shifts,
+    RotationKeyStore& rot_keys,
+    heaan::HomEval& eval
+);
+
+/**
+ * Choisir les clés à générer sous un budget
+ *
+ * Base: les puissances ±2^k nécessaires aux décompositions NAF de toutes
+ * les rotations demandées. Le reste du budget va aux rotations directes
+ * qui économisent le plus de key-switches (fréquence × (poids NAF - 1)).
+ *
+ * @param shifts Rotations demandées (un doublon = une utilisation de plus)
+ * @param log_slots log2(nombre de slots)
+ * @param key_budget Nombre maximal de clés (0 = une clé par rotation)
+ * @return Rotations pour lesquelles générer une clé, triées
+ * @throws std::runtime_error si la base NAF dépasse le budget
+ */
+std::vector<int> select_rotation_keys(
+    const std::vector<int>& shifts,
+    int log_slots,
+    int key_budget
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_ROTATION_HPP
@@ -0,0 +1,110 @@
+#ifndef FHE_CNN_SERVER_CONTEXT_HPP
+#define FHE_CNN_SERVER_CONTEXT_HPP
+
+#include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/key_store.hpp"
+#include "fhe_cnn/key_bundle.hpp"
+#include "fhe_cnn/bootstrapping.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace fhe_cnn {
+
+/**
+ * Contexte serveur: clés d'évaluation uniquement
+ *
+ * Contient la clé de relinéarisation, la clé de conjugaison, les clés de
+ * rotation (table figée: aucune génération possible) et le contexte de
+ * bootstrap. Jamais de clé secrète: les couches n'en ont pas besoin.
+ *
+ * Partage entre processus: construit depuis un paquet de clés (mmap
+ * partagé) puis préchargé avant run_workers(), les workers forkés lisent
+ * les mêmes pages physiques (copy-on-write, jamais écrites). Une clé
+ * chargée paresseusement après le fork reste privée au worker.
+ */
+class ServerContext {
+public:
+    /**
+     * Depuis un paquet de clés (clés d'évaluation seulement: KeyBundle
+     * refuse un paquet qui contient une clé secrète)
+     *
+     * @param bundle Paquet projeté en mémoire
+     * @param max_resident Budget de clés de rotation résidentes (0 = illimité)
+     */
+    explicit ServerContext(std::shared_ptr<const KeyBundle> bundle, size_t max_resident = 0);
+
+    /**
+     * Client et serveur dans le même processus (génération, tests): la
+     * clé secrète ne sert qu'à générer les clés et n'est pas conservée
+     *
+     * @param preset_id Paramètres
+     * @param sk Clé secrète
+     * @param with_bootstrap Générer les clés de bootstrap
+     * @param max_resident Budget de clés de rotation résidentes (0 = illimité)
+     */
+    ServerContext(
+        heaan::PresetParamsId preset_id,
+        const heaan::ISecretKey& sk,
+        bool with_bootstrap = true,
+        size_t max_resident = 0
+    );
+
+    ServerContext(const ServerContext&) = delete;
+    ServerContext& operator=(const ServerContext&) = delete;
+
+    /**
+     * Générer des clés de rotation côté client et les ajouter à la table
+     */
+    void generateRotKeys(const heaan::ISecretKey& sk, const std::vector<int>& shifts, int num_threads = 0);
+
+    /**
+     * Charger des clés du paquet avant de forker les workers
+     *
+     * @throws std::runtime_error si une rotation n'est pas dans le paquet
+     */
+    void preload(const std::vector<int>& shifts);
+
+    heaan::PresetParamsId preset() const { return preset_id_; }
+    int logSlots() const { return log_slots_; }
+
+    const heaan::ISwKey& relinKey() const { return *relin_key_; }
+    bool hasConjKey() const { return conj_key_ != nullptr; }
+    const heaan::ISwKey& conjKey() const;
+
+    RotationKeyStore& rotKeys() { return rot_keys_; }
+    const RotationKeyStore& rotKeys() const { return rot_keys_; }
+
+    bool hasBootstrap() const { return boot_ctx_ != nullptr; }
+    BootstrapContext& bootstrap();
+    const BootstrapContext& bootstrap() const;
+
+private:
+    heaan::PresetParamsId preset_id_;
+    int log_slots_;
+    std::shared_ptr<const KeyBundle> bundle_;
+    heaan::Ptr<heaan::ISwKey> relin_key_;
+    heaan::Ptr<heaan::ISwKey> conj_key_;
+    RotationKeyStore rot_keys_;
+    std::unique_ptr<BootstrapContext> boot_ctx_;
+};
+
+/**
+ * Exécuter un travail dans num_workers processus forkés
+ *
+ * À appeler une fois le ServerContext chargé: les workers héritent des clés
+ * sans copie. Chaque worker renvoie un vecteur de résultats par un pipe.
+ *
+ * @param num_workers Nombre de processus
+ * @param job Travail du worker (reçoit son indice dans [0, num_workers))
+ * @return Résultats de chaque worker, dans l'ordre des indices
+ * @throws std::runtime_error si un worker échoue
+ */
+std::vector<std::vector<double>> run_workers(
+    int num_workers,
+    const std::function<std::vector<double>(int)>& job
+);
+
+} // namespace fhe_cnn
+
+#endif // FHE_CNN_SERVER_CONTEXT_HPP
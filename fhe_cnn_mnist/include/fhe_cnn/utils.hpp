@@ -2,13 +2,18 @@
 #define FHE_CNN_UTILS_HPP
 
 #include <HEAAN2/HEAAN2.hpp>
+#include "fhe_cnn/key_store.hpp"
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <chrono>
 
 namespace fhe_cnn {
 
+class ServerContext;
+
 // ------------------------------------------------------------
 // IO Utils
 // ------------------------------------------------------------
@@ -32,6 +37,63 @@ heaan::Ptr<heaan::ICiphertext> encrypt_image(
     heaan::EnDecryptor& encryptor
 );
 
+/**
+ * Packing complexe: msg_re dans les parties réelles, msg_im dans les
+ * parties imaginaires (voir complex_packing.hpp)
+ */
+heaan::Message<heaan::Complex> pack_complex(
+    const heaan::Message<heaan::Complex>& msg_re,
+    const heaan::Message<heaan::Complex>& msg_im
+);
+
+/**
+ * Encoder un message au niveau d'un ciphertext
+ *
+ * Seul le plaintext au niveau demandé sort de l'appel: le plaintext plein
+ * niveau intermédiaire est libéré aussitôt. Point unique de l'encodage par
+ * niveau (l'API HEAAN2 utilisée ici n'encode qu'au niveau maximal).
+ *
+ * @param msg Message à encoder
+ * @param level Niveau du ciphertext qui consommera le plaintext
+ * @param encoder Encodeur
+ * @param eval Évaluateur homomorphe
+ * @return Plaintext au niveau level
+ */
+heaan::Ptr<heaan::IPlaintext> encode_at_level(
+    const heaan::Message<heaan::Complex>& msg,
+    int level,
+    heaan::EnDecoder& encoder,
+    heaan::HomEval& eval
+);
+
+/**
+ * Plaintext encodé à la demande, une fois par niveau
+ *
+ * Garde le message et les plaintexts déjà produits: un masque ou des
+ * poids appliqués à chaque appel, ou à plusieurs ciphertexts du même
+ * niveau, ne sont encodés qu'une fois, sans copie plein niveau.
+ * Thread-safe; une référence renvoyée par at() reste valide tant que
+ * l'objet vit.
+ */
+class LeveledPlaintext {
+public:
+    explicit LeveledPlaintext(heaan::Message<heaan::Complex> msg);
+
+    LeveledPlaintext(const LeveledPlaintext&) = delete;
+    LeveledPlaintext& operator=(const LeveledPlaintext&) = delete;
+
+    /** Plaintext au niveau level (encodé au premier appel pour ce niveau) */
+    const heaan::IPlaintext& at(int level, heaan::EnDecoder& encoder, heaan::HomEval& eval) const;
+
+    /** Niveaux déjà encodés */
+    size_t levels() const;
+
+private:
+    heaan::Message<heaan::Complex> msg_;
+    mutable std::mutex mutex_;
+    mutable std::map<int, std::shared_ptr<const heaan::IPlaintext>> by_level_;
+};
+
 std::vector<double> decrypt_result(
     const heaan::ICiphertext& ctxt,
     const heaan::ISecretKey& sk,
@@ -43,16 +105,37 @@ std::vector<double> decrypt_result(
 // ------------------------------------------------------------
 // Key Utils
 // ------------------------------------------------------------
+
+/**
+ * Union des rotations déclarées par les couches, avec rapport
+ * 
+ * Les rotations sont ramenées dans [1, num_slots) (une rotation à droite
+ * de s utilise la clé num_slots - s); la rotation 0 est ignorée.
+ * 
+ * @param requests Paires (nom de couche, rotations utilisées)
+ * @param log_slots log2(nombre de slots)
+ * @return Rotations distinctes, triées
+ */
+std::vector<int> collect_rotation_shifts(
+    const std::vector<std::pair<std::string, std::vector<int>>>& requests,
+    int log_slots
+);
+
+/**
+ * Générer les clés de rotation 1..max_rot-1 pour un serveur local
+ */
 void generate_all_rot_keys(
+    ServerContext& server,
     const heaan::ISecretKey& sk,
     int max_rot,
-    std::map<int, heaan::Ptr<heaan::ISwKey>>& rot_keys
+    int num_threads = 0
 );
 
 // ------------------------------------------------------------
 // Scaling Utils
 // ------------------------------------------------------------
 double compute_scale_factor(const std::vector<double>& activations);
+std::vector<double> scale_values(const std::vector<double>& values, double factor);
 heaan::Ptr<heaan::ICiphertext> scale_ciphertext(
     const heaan::ICiphertext& ctxt,
     double factor,
@@ -71,36 +154,4 @@ void print_timing(const std::chrono::time_point<std::chrono::high_resolution_clo
 
 } // namespace fhe_cnn
 
-
-/**
- * Packing de 4 images dans un seul message
- * 
- * @param images Vecteur de 4 images (chacune 784 pixels)
- * @param log_slots log2(nombre de slots)
- * @param device CPU/GPU
- * @return Message avec les 4 images packées
- */
-heaan::Message<heaan::Complex> pack_4_images(
-    const std::vector<std::vector<double>>& images,
-    int log_slots,
-    heaan::Device device
-);
-
-/**
- * Dépacker les résultats pour 4 images
- * 
- * @param ctxt Ciphertext résultat
- * @param sk Clé secrète
- * @param encoder Encodeur
- * @param decryptor Déchiffreur
- * @param output_size Taille de sortie par image (ex: 10 pour FC3)
- * @return Vecteur de 4 résultats
- */
-std::vector<std::vector<double>> unpack_4_results(
-    const heaan::ICiphertext& ctxt,
-    const heaan::ISecretKey& sk,
-    heaan::EnDecoder& encoder,
-    heaan::EnDecryptor& decryptor,
-    int output_size
-);
 #endif // FHE_CNN_UTILS_HPP
\ No newline at end of file
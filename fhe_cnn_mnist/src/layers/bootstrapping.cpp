@@ -1,6 +1,11 @@
 #include "fhe_cnn/bootstrapping.hpp"
+#include "fhe_cnn/key_bundle.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
+#include "fhe_cnn/rotation.hpp"
 #include <iostream>
 #include <chrono>
+#include <string>
+#include <algorithm>
 
 namespace fhe_cnn {
 
@@ -25,11 +30,90 @@ bool need_bootstrap(
     }
 }
 
+// ------------------------------------------------------------
+// Contexte partagé: clés + warmup une seule fois
+// ------------------------------------------------------------
+BootstrapContext::BootstrapContext(PresetParamsId preset_id, const ISecretKey& sk)
+    : preset_id_(preset_id),
+      bootkeys_(std::make_unique<BootKeyPtrs>(preset_id, sk)),
+      bootstrapper_(preset_id, *bootkeys_),
+      count_(0),
+      output_level_(0)
+{
+    std::cout << "🔑 Clés de bootstrap générées, warmup..." << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    bootstrapper_.warmup();
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    // Dry-run sur un ciphertext nul: niveau de sortie pour le planificateur
+    EnDecoder encoder(preset_id);
+    EnDecryptor encryptor(preset_id);
+    HomEval eval(preset_id);
+    
+    int log_slots = sk.logDegree() - 1;
+    Message<Complex> msg(log_slots, Device::CPU);
+    for (int i = 0; i < (1 << log_slots); ++i) msg[i] = Complex(0.0, 0.0);
+    
+    auto ptxt = IPlaintext::make();
+    encoder.encode(msg, *ptxt);
+    auto ctxt = ICiphertext::make();
+    encryptor.encrypt(*ptxt, sk, *ctxt);
+    
+    bootstrapper_.bootstrap(*ctxt);
+    output_level_ = eval.getLevel(*ctxt);
+    
+    std::cout << "    ✅ Bootstrap prêt (warmup " << duration.count() << " ms, "
+              << "niveau de sortie " << output_level_ << ")" << std::endl;
+}
+
+BootstrapContext::BootstrapContext(PresetParamsId preset_id, const KeyBundle& bundle)
+    : preset_id_(preset_id),
+      bootkeys_(bundle.loadBootKeys()),
+      bootstrapper_(preset_id, *bootkeys_),
+      count_(0),
+      output_level_(bundle.bootOutputLevel())
+{
+    std::cout << "📂 Clés de bootstrap lues dans le paquet, warmup..." << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    bootstrapper_.warmup();
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    // Niveau de sortie mesuré à l'écriture du paquet (pas de clé secrète ici)
+    std::cout << "    ✅ Bootstrap prêt (warmup " << duration.count() << " ms, "
+              << "niveau de sortie " << output_level_ << ")" << std::endl;
+}
+
+void BootstrapContext::bootstrap(ICiphertext& ctxt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bootstrapper_.bootstrap(ctxt);
+    count_++;
+}
+
+void BootstrapContext::bootstrapSparse(ICiphertext& ctxt, int log_slots) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = sparse_bootstrappers_.find(log_slots);
+    if (it == sparse_bootstrappers_.end()) {
+        std::cout << "    Bootstrapper creux (logSlots=" << log_slots << "), warmup..." << std::endl;
+        auto sparse = std::make_unique<Bootstrapper>(preset_id_, *bootkeys_, log_slots);
+        sparse->warmup();
+        it = sparse_bootstrappers_.emplace(log_slots, std::move(sparse)).first;
+    }
+    
+    it->second->bootstrap(ctxt);
+    count_++;
+}
+
 void bootstrap_ciphertext(
     Ptr<ICiphertext>& ctxt,
-    const ISecretKey& sk,
-    HomEval& eval,
-    PresetParamsId preset_id
+    BootstrapContext& boot_ctx,
+    HomEval& eval
 ) {
     std::cout << "🔷 Bootstrapping..." << std::endl;
     
@@ -43,30 +127,13 @@ void bootstrap_ciphertext(
         std::cout << "    Niveau avant: " << level_before << std::endl;
         
         // --------------------------------------------------------
-        // 2. Créer les clés de bootstrapping
-        // --------------------------------------------------------
-        std::cout << "    Génération des clés de bootstrap..." << std::endl;
-        BootKeyPtrs bootkeys(preset_id, sk);
-        
-        // --------------------------------------------------------
-        // 3. Initialiser le bootstrapper
-        // --------------------------------------------------------
-        Bootstrapper bootstrapper(preset_id, bootkeys);
-        
-        // --------------------------------------------------------
-        // 4. Warmup (optionnel mais recommandé)
-        // --------------------------------------------------------
-        std::cout << "    Warmup..." << std::endl;
-        bootstrapper.warmup();
-        
-        // --------------------------------------------------------
-        // 5. Bootstrapper le ciphertext
+        // 2. Bootstrapper le ciphertext (clés déjà prêtes)
         // --------------------------------------------------------
         std::cout << "    Bootstrap en cours..." << std::endl;
-        bootstrapper.bootstrap(*ctxt);
+        boot_ctx.bootstrap(*ctxt);
         
         // --------------------------------------------------------
-        // 6. Vérifier le niveau après bootstrap
+        // 3. Vérifier le niveau après bootstrap
         // --------------------------------------------------------
         int level_after = eval.getLevel(*ctxt);
         std::cout << "    Niveau après: " << level_after << std::endl;
@@ -76,11 +143,209 @@ void bootstrap_ciphertext(
         
         std::cout << "    ✅ Bootstrapping réussi en " 
                   << duration.count() << " ms" << std::endl;
-        
+                  
     } catch (const std::exception& e) {
         std::cerr << "    ❌ ERREUR Bootstrapping: " << e.what() << std::endl;
         throw;
     }
 }
 
+// ------------------------------------------------------------
+// Bootstrap creux (données sur quelques slots seulement)
+// ------------------------------------------------------------
+static int sparse_log_slots(int live_slots) {
+    int log_d = 0;
+    while ((1 << log_d) < live_slots) log_d++;
+    return log_d;
+}
+
+std::vector<int> sparse_bootstrap_rotation_shifts(int live_slots, int log_slots) {
+    int log_d = sparse_log_slots(live_slots);
+    if (log_d >= log_slots) return {};
+    return replicate_rotation_shifts(1 << (log_slots - log_d), 1 << log_d);
+}
+
+static Ptr<ICiphertext> mask_live_slots(
+    const ICiphertext& ctxt,
+    int live_slots,
+    int log_slots,
+    PresetParamsId preset_id,
+    EnDecoder& encoder,
+    HomEval& eval
+) {
+    Message<Complex> msg_mask(log_slots, Device::CPU);
+    for (int i = 0; i < (1 << log_slots); ++i) {
+        msg_mask[i] = Complex(i < live_slots ? 1.0 : 0.0, 0.0);
+    }
+    
+    auto ptxt_mask_leveled = encode_cached(msg_mask, eval.getLevel(ctxt), preset_id, encoder, eval);
+    
+    auto ct_masked = ICiphertext::make();
+    eval.mul(ctxt, *ptxt_mask_leveled, *ct_masked);
+    eval.rescale(*ct_masked, *ct_masked);
+    return ct_masked;
+}
+
+void bootstrap_sparse(
+    Ptr<ICiphertext>& ctxt,
+    int live_slots,
+    int log_slots,
+    BootstrapContext& boot_ctx,
+    RotationKeyStore& rot_keys,
+    HomEval& eval,
+    EnDecoder& encoder,
+    bool mask_input,
+    bool mask_output
+) {
+    int log_d = sparse_log_slots(live_slots);
+    
+    // Pas de gain si les données occupent plus de la moitié des slots
+    if (log_d >= log_slots - 1) {
+        bootstrap_ciphertext(ctxt, boot_ctx, eval);
+        return;
+    }
+    
+    std::cout << "🔷 Bootstrapping creux: " << live_slots << " slots utiles → " 
+              << (1 << log_d) << " slots (au lieu de " << (1 << log_slots) << ")" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // --------------------------------------------------------
+    // 1. Nettoyer les slots hors données (sinon repliement)
+    // --------------------------------------------------------
+    Ptr<ICiphertext> ct_sparse;
+    if (mask_input) {
+        ct_sparse = mask_live_slots(*ctxt, live_slots, log_slots, boot_ctx.preset(), encoder, eval);
+    } else {
+        ct_sparse = std::move(ctxt);
+    }
+    
+    // --------------------------------------------------------
+    // 2. Répliquer: slot i = donnée[i mod d]
+    // --------------------------------------------------------
+    ct_sparse = homomorphic_replicate(*ct_sparse, 1 << (log_slots - log_d), 1 << log_d,
+                                      SlotLayout(), rot_keys, eval);
+    
+    // --------------------------------------------------------
+    // 3. Bootstrap sur 2^log_d slots
+    // --------------------------------------------------------
+    boot_ctx.bootstrapSparse(*ct_sparse, log_d);
+    
+    // --------------------------------------------------------
+    // 4. Retour au layout plein: garder une seule copie
+    // --------------------------------------------------------
+    if (mask_output) {
+        ctxt = mask_live_slots(*ct_sparse, live_slots, log_slots, boot_ctx.preset(), encoder, eval);
+    } else {
+        ctxt = std::move(ct_sparse);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "    ✅ Bootstrapping creux réussi en " << duration.count() << " ms, niveau: " 
+              << eval.getLevel(*ctxt) << std::endl;
+}
+
+// ------------------------------------------------------------
+// Fusion de plusieurs lots avant bootstrap
+// ------------------------------------------------------------
+int max_merge_count(int live_slots, int log_slots) {
+    return std::max(1, (1 << log_slots) / live_slots);
+}
+
+std::vector<int> merge_rotation_shifts(int count, int live_slots, int log_slots) {
+    int num_slots = 1 << log_slots;
+    
+    std::vector<int> shifts;
+    for (int k = 1; k < count; ++k) {
+        shifts.push_back(num_slots - k * live_slots);  // Fusion (droite)
+        shifts.push_back(k * live_slots);              // Découpage (gauche)
+    }
+    
+    // Bootstrap creux pour tout groupe de 1..count ciphertexts (dernier groupe incomplet)
+    for (int c = 1; c <= count; ++c) {
+        if (c * live_slots > num_slots / 2) break;
+        for (int s : sparse_bootstrap_rotation_shifts(c * live_slots, log_slots)) {
+            if (std::find(shifts.begin(), shifts.end(), s) == shifts.end()) {
+                shifts.push_back(s);
+            }
+        }
+    }
+    return shifts;
+}
+
+void bootstrap_merged(
+    std::vector<Ptr<ICiphertext>>& ctxts,
+    int live_slots,
+    int log_slots,
+    BootstrapContext& boot_ctx,
+    RotationKeyStore& rot_keys,
+    HomEval& eval,
+    EnDecoder& encoder
+) {
+    int count = ctxts.size();
+    int num_slots = 1 << log_slots;
+    
+    if (count * live_slots > num_slots) {
+        throw std::runtime_error("bootstrap_merged: " + std::to_string(count) + 
+                                 " ciphertexts ne tiennent pas dans les slots");
+    }
+    
+    std::cout << "🔷 Bootstrapping fusionné: " << count << " lot(s) × " 
+              << live_slots << " slots" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // --------------------------------------------------------
+    // 1. Aligner les niveaux
+    // --------------------------------------------------------
+    int level = eval.getLevel(*ctxts[0]);
+    for (const auto& ct : ctxts) level = std::min(level, eval.getLevel(*ct));
+    
+    // --------------------------------------------------------
+    // 2. Fusion: lot k dans les slots [k*live, (k+1)*live)
+    // --------------------------------------------------------
+    Ptr<ICiphertext> ct_merged;
+    for (int k = 0; k < count; ++k) {
+        auto ct_k = ICiphertext::make();
+        eval.levelDownTo(*ctxts[k], *ct_k, level);
+        
+        auto ct_masked = mask_live_slots(*ct_k, live_slots, log_slots, boot_ctx.preset(), encoder, eval);
+        auto ct_placed = homomorphic_rotate(*ct_masked, -k * live_slots, rot_keys, eval);
+        
+        if (!ct_merged) {
+            ct_merged = std::move(ct_placed);
+        } else {
+            auto ct_add = ICiphertext::make();
+            eval.add(*ct_merged, *ct_placed, *ct_add);
+            ct_merged = std::move(ct_add);
+        }
+    }
+    
+    // --------------------------------------------------------
+    // 3. Un seul bootstrap pour tous les lots
+    // --------------------------------------------------------
+    int merged_slots = count * live_slots;
+    if (merged_slots <= num_slots / 2) {
+        bootstrap_sparse(ct_merged, merged_slots, log_slots, boot_ctx, rot_keys, eval, encoder, false, false);
+    } else {
+        boot_ctx.bootstrap(*ct_merged);
+    }
+    
+    // --------------------------------------------------------
+    // 4. Découpage: chaque lot revient en slots [0, live)
+    // --------------------------------------------------------
+    for (int k = 0; k < count; ++k) {
+        auto ct_back = homomorphic_rotate(*ct_merged, k * live_slots, rot_keys, eval);
+        ctxts[k] = mask_live_slots(*ct_back, live_slots, log_slots, boot_ctx.preset(), encoder, eval);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "    ✅ Bootstrapping fusionné réussi en " << duration.count() << " ms, niveau: " 
+              << eval.getLevel(*ctxts[0]) << std::endl;
+}
+
 } // namespace fhe_cnn
\ No newline at end of file
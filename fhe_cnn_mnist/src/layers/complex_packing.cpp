@@ -0,0 +1,71 @@
+#include "fhe_cnn/complex_packing.hpp"
+#include <iostream>
+#include <algorithm>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+Ptr<ICiphertext> combine_complex(
+    const ICiphertext& ct_re,
+    const ICiphertext& ct_im,
+    HomEval& eval
+) {
+    // ------------------------------------------------------------
+    // 1. Aligner les niveaux
+    // ------------------------------------------------------------
+    int level = std::min(eval.getLevel(ct_re), eval.getLevel(ct_im));
+    
+    auto ct_re_leveled = ICiphertext::make();
+    eval.levelDownTo(ct_re, *ct_re_leveled, level);
+    
+    auto ct_im_leveled = ICiphertext::make();
+    eval.levelDownTo(ct_im, *ct_im_leveled, level);
+    
+    // ------------------------------------------------------------
+    // 2. z = re + i·im
+    // ------------------------------------------------------------
+    auto ct_i_im = ICiphertext::make();
+    eval.multImagUnit(*ct_im_leveled, *ct_i_im);
+    
+    auto ct_result = ICiphertext::make();
+    eval.add(*ct_re_leveled, *ct_i_im, *ct_result);
+    
+    return ct_result;
+}
+
+std::pair<Ptr<ICiphertext>, Ptr<ICiphertext>> split_complex(
+    const ICiphertext& ctxt,
+    const ISwKey& conj_key,
+    HomEval& eval
+) {
+    auto ct_conj = ICiphertext::make();
+    eval.conj(ctxt, *ct_conj, conj_key);
+    
+    // ------------------------------------------------------------
+    // 1. Partie réelle: (z + conj(z)) / 2
+    // ------------------------------------------------------------
+    auto ct_sum = ICiphertext::make();
+    eval.add(ctxt, *ct_conj, *ct_sum);
+    
+    auto ct_re = ICiphertext::make();
+    eval.mul(*ct_sum, 0.5, *ct_re);
+    eval.rescale(*ct_re, *ct_re);
+    
+    // ------------------------------------------------------------
+    // 2. Partie imaginaire: (z - conj(z)) / 2i = -i·(z - conj(z)) / 2
+    // ------------------------------------------------------------
+    auto ct_diff = ICiphertext::make();
+    eval.sub(ctxt, *ct_conj, *ct_diff);
+    
+    auto ct_i_diff = ICiphertext::make();
+    eval.multImagUnit(*ct_diff, *ct_i_diff);
+    
+    auto ct_im = ICiphertext::make();
+    eval.mul(*ct_i_diff, -0.5, *ct_im);
+    eval.rescale(*ct_im, *ct_im);
+    
+    return {std::move(ct_re), std::move(ct_im)};
+}
+
+} // namespace fhe_cnn
@@ -1,215 +1,203 @@
 #include "fhe_cnn/conv2d.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
 #include "fhe_cnn/utils.hpp"
+#include "fhe_cnn/rotation.hpp"
 #include <iostream>
 #include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
 
 namespace fhe_cnn {
 
 using namespace heaan;
 
-Ptr<ICiphertext> homomorphic_conv2d(
-    const ICiphertext& input_enc,
+// Ajouter term à acc (acc vide: acc = term), au plus bas des deux niveaux
+static void accumulate(Ptr<ICiphertext>& acc, Ptr<ICiphertext> term, HomEval& eval) {
+    if (!acc) {
+        acc = std::move(term);
+        return;
+    }
+    
+    int level_acc = eval.getLevel(*acc);
+    int level_term = eval.getLevel(*term);
+    
+    if (level_acc > level_term) {
+        auto ct_acc_leveled = ICiphertext::make();
+        eval.levelDownTo(*acc, *ct_acc_leveled, level_term);
+        acc = std::move(ct_acc_leveled);
+    } else if (level_term > level_acc) {
+        auto ct_term_leveled = ICiphertext::make();
+        eval.levelDownTo(*term, *ct_term_leveled, level_acc);
+        term = std::move(ct_term_leveled);
+    }
+    
+    auto ct_add = ICiphertext::make();
+    eval.add(*acc, *term, *ct_add);
+    acc = std::move(ct_add);
+}
+
+CtTensor homomorphic_conv2d(
+    const CtTensor& input,
     const std::vector<double>& weight,
     const std::vector<double>& bias,
-    int in_c,
-    int in_h,
-    int in_w,
     int out_c,
     int kernel,
-    int out_h,
-    int out_w,
-    const ISecretKey& sk,
-    std::map<int, Ptr<ISwKey>>& rot_keys,
-    const ISwKey& relin_key,
-    HomEval& eval
+    FheContext& ctx,
+    bool complex_packed,
+    int ct_channels
 ) {
-    std::cout << "🔷 Conv2D: " << in_c << "×" << in_h << "×" << in_w 
-              << " → " << out_c << "×" << out_h << "×" << out_w 
-              << ", kernel=" << kernel << std::endl;
+    const TensorLayout& in = input.layout;
+    const SlotLayout& layout = in.slots;
+    int in_c = in.c;
+    int in_h = in.h;
+    int in_w = in.w;
+    int out_h = in_h - kernel + 1;
+    int out_w = in_w - kernel + 1;
     
-    int log_slots = sk.logDegree() - 1;
-    int num_slots = 1 << log_slots;
-    int total_out = out_c * out_h * out_w;
-    
-    if (total_out > num_slots) {
-        throw std::runtime_error("Output size too large for slots");
-    }
+    RotationKeyStore& rot_keys = ctx.rotKeys();
+    int log_slots = ctx.logSlots();
     
-    EnDecoder encoder(PresetParamsId::F16Opt_Gr);
+    // Sortie découpée par canaux si elle ne tient pas dans un ciphertext
+    TensorLayout out_layout = conv2d_output_layout(in, out_c, kernel, log_slots, ct_channels);
+    int num_in = in.numCts();
+    int num_out = out_layout.numCts();
     
-    // ------------------------------------------------------------
-    // 1. Créer les 25 plaintexts pour les positions du kernel
-    //    Chaque plaintext contient les poids pour une position (kh, kw)
-    //    répartis sur tous les canaux de sortie
-    // ------------------------------------------------------------
-    std::vector<Ptr<IPlaintext>> kernel_ptxts;
+    std::cout << "🔷 Conv2D: " << in_c << "×" << in_h << "×" << in_w 
+              << " → " << out_c << "×" << out_h << "×" << out_w 
+              << ", kernel=" << kernel;
+    if (num_in > 1 || num_out > 1) {
+        std::cout << ", ciphertexts " << num_in << " → " << num_out;
+    }
+    std::cout << std::endl;
     
-    for (int kh = 0; kh < kernel; ++kh) {
-        for (int kw = 0; kw < kernel; ++kw) {
-            Message<Complex> msg_kernel(log_slots, Device::CPU);
-            
-            // Pour chaque canal de sortie et chaque position de sortie
-            for (int oc = 0; oc < out_c; ++oc) {
-                for (int oh = 0; oh < out_h; ++oh) {
-                    for (int ow = 0; ow < out_w; ++ow) {
-                        int slot_idx = (oc * out_h + oh) * out_w + ow;
-                        if (slot_idx >= num_slots) continue;
-                        
-                        // Somme sur les canaux d'entrée
-                        double w_sum = 0.0;
-                        for (int ic = 0; ic < in_c; ++ic) {
-                            int w_idx = (((oc * in_c + ic) * kernel + kh) * kernel + kw);
-                            w_sum += weight[w_idx];
-                        }
-                        msg_kernel[slot_idx] = Complex(w_sum, 0.0);
-                    }
-                }
-            }
-            
-            auto ptxt = IPlaintext::make();
-            encoder.encode(msg_kernel, *ptxt);
-            kernel_ptxts.push_back(std::move(ptxt));
-        }
+    if ((int)input.cts.size() != num_in) {
+        throw std::runtime_error("Conv2D: " + std::to_string(input.cts.size()) + " ciphertexts pour " +
+                                 std::to_string(num_in) + " attendus par le layout");
     }
     
     // ------------------------------------------------------------
-    // 2. Créer les rotations nécessaires de l'image d'entrée
-    //    Pour chaque position (kh, kw), on a besoin de Rot_{shift}(input)
+    // 1. Créer les rotations nécessaires de chaque ciphertext d'entrée
+    //    Pour chaque position (kh, kw), on a besoin de Rot_{kh*h_stride+kw*w_stride}(input),
+    //    calculée une seule fois et partagée par tous les canaux de sortie
+    //    (et par toutes les images en layout entrelacé); les rotations
+    //    d'une entrée partagent leurs key-switches (homomorphic_rotate_many)
     // ------------------------------------------------------------
-    std::vector<Ptr<ICiphertext>> rotated_inputs;
-    rotated_inputs.push_back(ICiphertext::make());
-    *rotated_inputs[0] = input_enc;  // Copie
+    std::vector<int> shifts = conv2d_rotation_shifts(in, kernel);
+    std::vector<std::map<int, Ptr<ICiphertext>>> rotated_inputs(num_in);
     
-    // Rotations nécessaires pour une image 28×28 avec kernel 5×5
-    std::vector<int> shifts = {1, 2, 3, 4, 28, 29, 30, 31, 32, 
-                               56, 57, 58, 59, 60, 84, 85, 86, 87, 88};
-    
-    for (int shift : shifts) {
-        auto it = rot_keys.find(shift);
-        if (it == rot_keys.end()) {
-            std::cerr << "    ERREUR: Clé rotation " << shift << " non trouvée!" << std::endl;
-            continue;
+    parallel_for_cts(num_in, ctx, [&](int j, HomEval& eval, EnDecoder&) {
+        auto rotated = homomorphic_rotate_many(*input.cts[j], shifts, rot_keys, eval);
+        for (size_t t = 0; t < shifts.size(); ++t) {
+            rotated_inputs[j][shifts[t]] = std::move(rotated[t]);
         }
-        
-        auto ct_rot = ICiphertext::make();
-        eval.rot(input_enc, shift, *ct_rot, *(it->second));
-        rotated_inputs.push_back(std::move(ct_rot));
-    }
+    });
     
     // ------------------------------------------------------------
-    // 3. Pour chaque canal de sortie, calculer la convolution
+    // 2. Chaque ciphertext de sortie g (canaux first_oc .. first_oc+n_oc-1):
+    //    pour chaque ciphertext d'entrée j et chaque position (kh, kw), un
+    //    plaintext de poids (sommés sur les canaux d'entrée de j) répartis
+    //    sur les canaux de sortie de g, répliqués pour chaque image
     // ------------------------------------------------------------
-    auto ct_result = ICiphertext::make();
-    bool first = true;
+    std::vector<Ptr<ICiphertext>> outputs(num_out);
     
-    for (int oc = 0; oc < out_c; ++oc) {
-        std::cout << "    Canal de sortie " << oc << "/" << out_c << std::endl;
+    parallel_for_cts(num_out, ctx, [&](int g, HomEval& eval, EnDecoder& encoder) {
+        int first_oc = out_layout.firstChannel(g);
+        int n_oc = out_layout.channelsIn(g);
+        int group_out = n_oc * out_h * out_w;
         
-        auto ct_oc = ICiphertext::make();
-        bool first_kernel = true;
+        Ptr<ICiphertext> ct_out;
         
-        // Accumuler les 25 positions du kernel
-        for (int kh = 0; kh < kernel; ++kh) {
-            for (int kw = 0; kw < kernel; ++kw) {
-                // Calculer le shift nécessaire pour cette position
-                int shift = kh * in_w + kw;
-                
-                // Trouver l'image rotatée correspondante
-                Ptr<ICiphertext> ct_shifted;
-                if (shift == 0) {
-                    ct_shifted = ICiphertext::make();
-                    *ct_shifted = input_enc;
-                } else {
-                    auto it = rot_keys.find(shift);
-                    if (it != rot_keys.end()) {
-                        ct_shifted = ICiphertext::make();
-                        eval.rot(input_enc, shift, *ct_shifted, *(it->second));
-                    } else {
-                        continue;
-                    }
-                }
-                
-                // Multiplier par les poids
-                int kernel_idx = kh * kernel + kw;
-                auto ct_mul = ICiphertext::make();
-                eval.mul(*ct_shifted, *kernel_ptxts[kernel_idx], *ct_mul);
-                eval.rescale(*ct_mul, *ct_mul);
-                
-                // Accumuler
-                if (first_kernel) {
-                    ct_oc = std::move(ct_mul);
-                    first_kernel = false;
-                } else {
-                    int level_oc = eval.getLevel(*ct_oc);
-                    int level_mul = eval.getLevel(*ct_mul);
+        for (int j = 0; j < num_in; ++j) {
+            int first_ic = in.firstChannel(j);
+            int n_ic = in.channelsIn(j);
+            
+            for (int kh = 0; kh < kernel; ++kh) {
+                for (int kw = 0; kw < kernel; ++kw) {
+                    std::vector<Complex> w_kernel(group_out);
                     
-                    if (level_oc != level_mul) {
-                        if (level_oc > level_mul) {
-                            auto ct_oc_leveled = ICiphertext::make();
-                            eval.levelDownTo(*ct_oc, *ct_oc_leveled, level_mul);
-                            ct_oc = std::move(ct_oc_leveled);
-                        } else {
-                            auto ct_mul_leveled = ICiphertext::make();
-                            eval.levelDownTo(*ct_mul, *ct_mul_leveled, level_oc);
-                            ct_mul = std::move(ct_mul_leveled);
+                    // Pour chaque canal de sortie et chaque position de sortie
+                    for (int oc = first_oc; oc < first_oc + n_oc; ++oc) {
+                        for (int oh = 0; oh < out_h; ++oh) {
+                            for (int ow = 0; ow < out_w; ++ow) {
+                                // Somme sur les canaux d'entrée du ciphertext j
+                                double w_sum = 0.0;
+                                for (int ic = first_ic; ic < first_ic + n_ic; ++ic) {
+                                    int w_idx = (((oc * in_c + ic) * kernel + kh) * kernel + kw);
+                                    w_sum += weight[w_idx];
+                                }
+                                w_kernel[out_layout.index(oc, oh, ow)] = Complex(w_sum, 0.0);
+                            }
                         }
                     }
                     
-                    auto ct_add = ICiphertext::make();
-                    eval.add(*ct_oc, *ct_mul, *ct_add);
-                    ct_oc = std::move(ct_add);
+                    // Image rotatée pour cette position du kernel
+                    int shift = layout.rotation(in.index(0, kh, kw));
+                    const ICiphertext* ct_shifted = input.cts[j].get();
+                    if (shift != 0) {
+                        ct_shifted = rotated_inputs[j].at(shift).get();
+                    }
+                    
+                    // Poids encodés au niveau de l'entrée (cache global: une fois par lot)
+                    auto msg_kernel = broadcast_message(w_kernel, layout, log_slots);
+                    auto ptxt_kernel = encode_cached(msg_kernel, eval.getLevel(*ct_shifted), ctx.preset(), encoder, eval);
+                    
+                    // Multiplier par les poids et accumuler
+                    auto ct_mul = ICiphertext::make();
+                    eval.mul(*ct_shifted, *ptxt_kernel, *ct_mul);
+                    eval.rescale(*ct_mul, *ct_mul);
+                    accumulate(ct_out, std::move(ct_mul), eval);
                 }
             }
         }
         
-        // Ajouter le bias
-        Message<Complex> msg_bias(log_slots, Device::CPU);
-        for (int oh = 0; oh < out_h; ++oh) {
-            for (int ow = 0; ow < out_w; ++ow) {
-                int slot_idx = (oc * out_h + oh) * out_w + ow;
-                msg_bias[slot_idx] = Complex(bias[oc], 0.0);
+        // Ajouter le bias de chaque canal de sortie
+        std::vector<Complex> b_out(group_out, Complex(0.0, 0.0));
+        for (int oc = first_oc; oc < first_oc + n_oc; ++oc) {
+            for (int oh = 0; oh < out_h; ++oh) {
+                for (int ow = 0; ow < out_w; ++ow) {
+                    b_out[out_layout.index(oc, oh, ow)] = Complex(bias[oc], complex_packed ? bias[oc] : 0.0);
+                }
             }
         }
+        auto msg_bias = broadcast_message(b_out, layout, log_slots);
         
-        auto ptxt_bias = IPlaintext::make();
-        encoder.encode(msg_bias, *ptxt_bias);
-        
-        auto ptxt_bias_leveled = IPlaintext::make();
-        eval.levelDownTo(*ptxt_bias, *ptxt_bias_leveled, eval.getLevel(*ct_oc));
+        auto ptxt_bias_leveled = encode_cached(msg_bias, eval.getLevel(*ct_out), ctx.preset(), encoder, eval);
         
         auto ct_add_bias = ICiphertext::make();
-        eval.add(*ct_oc, *ptxt_bias_leveled, *ct_add_bias);
-        ct_oc = std::move(ct_add_bias);
-        
-        // Accumuler les canaux de sortie
-        if (first) {
-            ct_result = std::move(ct_oc);
-            first = false;
-        } else {
-            int level_res = eval.getLevel(*ct_result);
-            int level_oc = eval.getLevel(*ct_oc);
-            
-            if (level_res != level_oc) {
-                if (level_res > level_oc) {
-                    auto ct_res_leveled = ICiphertext::make();
-                    eval.levelDownTo(*ct_result, *ct_res_leveled, level_oc);
-                    ct_result = std::move(ct_res_leveled);
-                } else {
-                    auto ct_oc_leveled = ICiphertext::make();
-                    eval.levelDownTo(*ct_oc, *ct_oc_leveled, level_res);
-                    ct_oc = std::move(ct_oc_leveled);
-                }
-            }
-            
-            auto ct_add = ICiphertext::make();
-            eval.add(*ct_result, *ct_oc, *ct_add);
-            ct_result = std::move(ct_add);
-        }
-    }
+        eval.add(*ct_out, *ptxt_bias_leveled, *ct_add_bias);
+        outputs[g] = std::move(ct_add_bias);
+    });
+    
+    CtTensor output;
+    output.cts = std::move(outputs);
+    output.layout = out_layout;
     
-    std::cout << "    ✅ Conv2D terminé, niveau: " << eval.getLevel(*ct_result) << std::endl;
+    std::cout << "    ✅ Conv2D terminé, niveau: " << output.level(ctx.eval()) << std::endl;
     
-    return ct_result;
+    return output;
+}
+
+TensorLayout conv2d_output_layout(
+    const TensorLayout& input,
+    int out_c,
+    int kernel,
+    int log_slots,
+    int ct_channels
+) {
+    return TensorLayout::dense(out_c, input.h - kernel + 1, input.w - kernel + 1, input.slots)
+        .split(log_slots, ct_channels);
+}
+
+std::vector<int> conv2d_rotation_shifts(const TensorLayout& input, int kernel) {
+    std::vector<int> shifts;
+    for (int kh = 0; kh < kernel; ++kh) {
+        for (int kw = 0; kw < kernel; ++kw) {
+            int shift = input.index(0, kh, kw);
+            if (shift != 0) shifts.push_back(input.slots.rotation(shift));
+        }
+    }
+    return shifts;
 }
 
 } // namespace fhe_cnn
\ No newline at end of file
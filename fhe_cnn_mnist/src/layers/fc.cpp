@@ -1,78 +1,73 @@
 #include "fhe_cnn/fc.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
+#include "fhe_cnn/rotation.hpp"
 #include <iostream>
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 namespace fhe_cnn {
 
 using namespace heaan;
 
-Ptr<ICiphertext> homomorphic_fc(
+// Découpage BSGS de n = n1 × n2 (giant × baby)
+static void bsgs_dims(int n, int& n1, int& n2) {
+    n1 = (int)std::sqrt(n);
+    n2 = n / n1;
+    while (n1 * n2 < n) n2++;
+    while (n1 * n2 > n) n1--;
+}
+
+// Produit matrice-vecteur BSGS sur un ciphertext, sans bias: colonnes
+// first_feature .. first_feature + in_features - 1 de la matrice poids
+static Ptr<ICiphertext> fc_partial(
     const ICiphertext& x_enc,
     const std::vector<double>& weight,
-    const std::vector<double>& bias,
+    int first_feature,
     int in_features,
+    int total_features,
     int out_features,
-    const ISecretKey& sk,
-    std::map<int, Ptr<ISwKey>>& rot_keys,
-    HomEval& eval
+    const SlotLayout& layout,
+    int log_slots,
+    PresetParamsId preset_id,
+    RotationKeyStore& rot_keys,
+    HomEval& eval,
+    EnDecoder& encoder
 ) {
-    std::cout << "🔷 FC: " << in_features << " → " << out_features << std::endl;
-    
     int n = out_features;
-    int log_slots = sk.logDegree() - 1;
-    int num_slots = 1 << log_slots;
-    
-    if (n > num_slots) {
-        throw std::runtime_error("out_features > num_slots");
-    }
     
     // ------------------------------------------------------------
-    // 1. Reformater la matrice poids
+    // 1. Reformater la matrice poids (colonnes first_feature .. first_feature+in_features-1)
     // ------------------------------------------------------------
     std::vector<std::vector<double>> U(out_features, std::vector<double>(in_features, 0.0));
     for (int i = 0; i < out_features; ++i) {
         for (int j = 0; j < in_features; ++j) {
-            U[i][j] = weight[i * in_features + j];
+            U[i][j] = weight[i * total_features + first_feature + j];
         }
     }
     
     // ------------------------------------------------------------
     // 2. Paramètres BSGS
     // ------------------------------------------------------------
-    int n1 = (int)std::sqrt(n);
-    int n2 = n / n1;
-    while (n1 * n2 < n) n2++;
-    while (n1 * n2 > n) n1--;
+    int n1, n2;
+    bsgs_dims(n, n1, n2);
     
-    std::cout << "    BSGS: " << n << " = " << n1 << " × " << n2 << std::endl;
-    
-    EnDecoder encoder(PresetParamsId::F16Opt_Gr);
     
     // ------------------------------------------------------------
     // 3. Baby steps (i = 1..n2-1)
     // ------------------------------------------------------------
-    std::vector<Ptr<ICiphertext>> baby_steps(n2);
+    std::vector<int> baby_shifts;
+    for (int i = 1; i < n2; ++i) baby_shifts.push_back(layout.rotation(i));
     
-    for (int i = 1; i < n2; ++i) {
-        auto it = rot_keys.find(i);
-        if (it == rot_keys.end()) {
-            std::cerr << "    ERREUR: Clé rotation " << i << " non trouvée!" << std::endl;
-            continue;
-        }
-        
-        auto ct_rot = ICiphertext::make();
-        eval.rot(x_enc, i, *ct_rot, *(it->second));
-        baby_steps[i] = std::move(ct_rot);
-    }
+    std::vector<Ptr<ICiphertext>> baby_steps(n2);
+    auto rotated = homomorphic_rotate_many(x_enc, baby_shifts, rot_keys, eval);
+    for (int i = 1; i < n2; ++i) baby_steps[i] = std::move(rotated[i - 1]);
     
     // ------------------------------------------------------------
-    // 4. Masque pour extraction (1,0,0,...)
+    // 4. Masque pour extraction (1,0,0,...) dans chaque image
     // ------------------------------------------------------------
-    Message<Complex> msg_mask(log_slots, Device::CPU);
-    msg_mask[0] = Complex(1.0, 0.0);
-    for (int i = 1; i < num_slots; ++i) msg_mask[i] = Complex(0.0, 0.0);
-    auto ptxt_mask = IPlaintext::make();
-    encoder.encode(msg_mask, *ptxt_mask);
+    //    (cache global: encodé une fois par niveau, pour tous les appels)
+    auto msg_mask = block_heads_mask(n, 1, 1, layout, log_slots);
     
     // ------------------------------------------------------------
     // 5. Giant steps
@@ -83,93 +78,59 @@ Ptr<ICiphertext> homomorphic_fc(
         auto ct_gs = ICiphertext::make();
         
         // ---- Cas i = 0 ----
-        Message<Complex> msg_diag0(log_slots, Device::CPU);
+        std::vector<Complex> diag0(n);
         for (int k = 0; k < n; ++k) {
             int row = ((-j * n2 + k) % n + n) % n;
             if (row < out_features && k < in_features) {
-                msg_diag0[k] = Complex(U[row][k], 0.0);
+                diag0[k] = Complex(U[row][k], 0.0);
             } else {
-                msg_diag0[k] = Complex(0.0, 0.0);
+                diag0[k] = Complex(0.0, 0.0);
             }
         }
+        auto msg_diag0 = broadcast_message(diag0, layout, log_slots);
         
-        auto ptxt_diag0 = IPlaintext::make();
-        encoder.encode(msg_diag0, *ptxt_diag0);
-        
-        auto ptxt_diag0_leveled = IPlaintext::make();
-        eval.levelDownTo(*ptxt_diag0, *ptxt_diag0_leveled, eval.getLevel(x_enc));
+        auto ptxt_diag0_leveled = encode_cached(msg_diag0, eval.getLevel(x_enc), preset_id, encoder, eval);
         
         auto ct_mul0 = ICiphertext::make();
         eval.mul(x_enc, *ptxt_diag0_leveled, *ct_mul0);
         eval.rescale(*ct_mul0, *ct_mul0);
         
-        // Rotate-and-sum
-        auto ct_sum0 = std::move(ct_mul0);
-        for (int shift = 1; shift < n; shift <<= 1) {
-            auto it_shift = rot_keys.find(shift);
-            if (it_shift != rot_keys.end()) {
-                auto ct_rot = ICiphertext::make();
-                eval.rot(*ct_sum0, shift, *ct_rot, *(it_shift->second));
-                
-                auto ct_new = ICiphertext::make();
-                eval.add(*ct_sum0, *ct_rot, *ct_new);
-                ct_sum0 = std::move(ct_new);
-            }
-        }
+        // Rotate-and-sum (un bloc de n éléments par image)
+        auto ct_sum0 = homomorphic_block_sum(*ct_mul0, n, 1, layout, rot_keys, eval);
         
         // Extraire slot 0
         auto ct_extract0 = ICiphertext::make();
-        auto ptxt_mask_leveled0 = IPlaintext::make();
-        eval.levelDownTo(*ptxt_mask, *ptxt_mask_leveled0, eval.getLevel(*ct_sum0));
-        eval.mul(*ct_sum0, *ptxt_mask_leveled0, *ct_extract0);
+        eval.mul(*ct_sum0, *encode_cached(msg_mask, eval.getLevel(*ct_sum0), preset_id, encoder, eval), *ct_extract0);
         eval.rescale(*ct_extract0, *ct_extract0);
         
         ct_gs = std::move(ct_extract0);
         
         // ---- Cas i = 1..n2-1 ----
         for (int i = 1; i < n2; ++i) {
-            if (!baby_steps[i]) continue;
-            
-            Message<Complex> msg_diag(log_slots, Device::CPU);
+            std::vector<Complex> diag(n);
             for (int k = 0; k < n; ++k) {
                 int row = ((-j * n2 + k) % n + n) % n;
                 int col = (k + i) % n;
                 if (row < out_features && col < in_features) {
-                    msg_diag[k] = Complex(U[row][col], 0.0);
+                    diag[k] = Complex(U[row][col], 0.0);
                 } else {
-                    msg_diag[k] = Complex(0.0, 0.0);
+                    diag[k] = Complex(0.0, 0.0);
                 }
             }
+            auto msg_diag = broadcast_message(diag, layout, log_slots);
             
-            auto ptxt_diag = IPlaintext::make();
-            encoder.encode(msg_diag, *ptxt_diag);
-            
-            auto ptxt_diag_leveled = IPlaintext::make();
-            eval.levelDownTo(*ptxt_diag, *ptxt_diag_leveled, eval.getLevel(*baby_steps[i]));
+            auto ptxt_diag_leveled = encode_cached(msg_diag, eval.getLevel(*baby_steps[i]), preset_id, encoder, eval);
             
             auto ct_mul = ICiphertext::make();
             eval.mul(*baby_steps[i], *ptxt_diag_leveled, *ct_mul);
             eval.rescale(*ct_mul, *ct_mul);
             
             // Rotate-and-sum
-            auto ct_sum = std::move(ct_mul);
-            for (int shift = 1; shift < n; shift <<= 1) {
-                auto it_shift = rot_keys.find(shift);
-                if (it_shift != rot_keys.end()) {
-                    auto ct_rot = ICiphertext::make();
-                    eval.rot(*ct_sum, shift, *ct_rot, *(it_shift->second));
-                    
-                    auto ct_new = ICiphertext::make();
-                    eval.add(*ct_sum, *ct_rot, *ct_new);
-                    ct_sum = std::move(ct_new);
-                }
-            }
+            auto ct_sum = homomorphic_block_sum(*ct_mul, n, 1, layout, rot_keys, eval);
             
             // Extraire slot 0
             auto ct_extract = ICiphertext::make();
-            auto ptxt_mask_leveled = IPlaintext::make();
-            eval.levelDownTo(*ptxt_mask, *ptxt_mask_leveled, eval.getLevel(*ct_sum));
-            eval.mul(*ct_sum, *ptxt_mask_leveled, *ct_extract);
+            eval.mul(*ct_sum, *encode_cached(msg_mask, eval.getLevel(*ct_sum), preset_id, encoder, eval), *ct_extract);
             eval.rescale(*ct_extract, *ct_extract);
             
             // Accumulation
@@ -195,15 +156,7 @@ Ptr<ICiphertext> homomorphic_fc(
         
         // ---- Rotation géante ----
         if (j > 0) {
-            int rot_amount = j * n2;
-            auto it = rot_keys.find(rot_amount);
-            if (it != rot_keys.end()) {
-                auto ct_rot = ICiphertext::make();
-                eval.rot(*ct_gs, rot_amount, *ct_rot, *(it->second));
-                giant_steps[j] = std::move(ct_rot);
-            } else {
-                giant_steps[j] = std::move(ct_gs);
-            }
+            giant_steps[j] = homomorphic_rotate(*ct_gs, layout.rotation(j * n2), rot_keys, eval);
         } else {
             giant_steps[j] = std::move(ct_gs);
         }
@@ -243,22 +196,89 @@ Ptr<ICiphertext> homomorphic_fc(
         }
     }
     
+    return ct_result;
+}
+
+CtTensor homomorphic_fc(
+    const CtTensor& x,
+    const std::vector<double>& weight,
+    const std::vector<double>& bias,
+    int out_features,
+    FheContext& ctx,
+    bool complex_packed
+) {
+    const SlotLayout& layout = x.layout.slots;
+    int in_features = x.size();
+    int num_in = x.layout.numCts();
+    int channel_size = x.layout.h * x.layout.w;
+    
+    std::cout << "🔷 FC: " << in_features << " → " << out_features;
+    if (num_in > 1) std::cout << ", " << num_in << " ciphertexts";
+    std::cout << std::endl;
+    
+    int n = out_features;
+    HomEval& eval = ctx.eval();
+    EnDecoder& encoder = ctx.encoder();
+    RotationKeyStore& rot_keys = ctx.rotKeys();
+    int log_slots = ctx.logSlots();
+    int num_slots = 1 << log_slots;
+    
+    if (layout.span(n) > num_slots) {
+        throw std::runtime_error("out_features > num_slots");
+    }
+    if ((int)x.cts.size() != num_in) {
+        throw std::runtime_error("FC: " + std::to_string(x.cts.size()) + " ciphertexts pour " +
+                                 std::to_string(num_in) + " attendus par le layout");
+    }
+    
+    int n1, n2;
+    bsgs_dims(n, n1, n2);
+    
+    std::cout << "    BSGS: " << n << " = " << n1 << " × " << n2 << std::endl;
+    
+    // ------------------------------------------------------------
+    // Chaque ciphertext g porte les features de ses canaux, lues à plat:
+    // W·x = Σ_g W[:, features de g]·x_g, un produit partiel par thread
+    // ------------------------------------------------------------
+    std::vector<Ptr<ICiphertext>> partials(num_in);
+    
+    parallel_for_cts(num_in, ctx, [&](int g, HomEval& eval_g, EnDecoder& encoder_g) {
+        int first_feature = x.layout.firstChannel(g) * channel_size;
+        int features = x.layout.channelsIn(g) * channel_size;
+        partials[g] = fc_partial(*x.cts[g], weight, first_feature, features, in_features,
+                                 out_features, layout, log_slots, ctx.preset(), rot_keys, eval_g, encoder_g);
+    });
+    
+    auto ct_result = std::move(partials[0]);
+    for (int g = 1; g < num_in; ++g) {
+        int level_result = eval.getLevel(*ct_result);
+        int level_partial = eval.getLevel(*partials[g]);
+        
+        if (level_result > level_partial) {
+            auto ct_result_leveled = ICiphertext::make();
+            eval.levelDownTo(*ct_result, *ct_result_leveled, level_partial);
+            ct_result = std::move(ct_result_leveled);
+        } else if (level_partial > level_result) {
+            auto ct_partial_leveled = ICiphertext::make();
+            eval.levelDownTo(*partials[g], *ct_partial_leveled, level_result);
+            partials[g] = std::move(ct_partial_leveled);
+        }
+        
+        auto ct_add = ICiphertext::make();
+        eval.add(*ct_result, *partials[g], *ct_add);
+        ct_result = std::move(ct_add);
+    }
+    
     // ------------------------------------------------------------
     // 7. Ajouter le bias
     // ------------------------------------------------------------
-    Message<Complex> msg_bias(log_slots, Device::CPU);
+    std::vector<Complex> b_out(out_features);
     for (int i = 0; i < out_features; ++i) {
-        msg_bias[i] = Complex(bias[i], 0.0);
+        b_out[i] = Complex(bias[i], complex_packed ? bias[i] : 0.0);
     }
-    for (int i = out_features; i < num_slots; ++i) {
-        msg_bias[i] = Complex(0.0, 0.0);
-    }
-    
-    auto ptxt_bias = IPlaintext::make();
-    encoder.encode(msg_bias, *ptxt_bias);
+    auto msg_bias = broadcast_message(b_out, layout, log_slots);
     
-    auto ptxt_bias_leveled = IPlaintext::make();
-    eval.levelDownTo(*ptxt_bias, *ptxt_bias_leveled, eval.getLevel(*ct_result));
+    auto ptxt_bias_leveled = encode_cached(msg_bias, eval.getLevel(*ct_result), ctx.preset(), encoder, eval);
     
     auto ct_add_bias = ICiphertext::make();
     eval.add(*ct_result, *ptxt_bias_leveled, *ct_add_bias);
@@ -266,7 +286,21 @@ Ptr<ICiphertext> homomorphic_fc(
     
     std::cout << "    ✅ FC terminé, niveau: " << eval.getLevel(*ct_result) << std::endl;
     
-    return ct_result;
+    return CtTensor(std::move(ct_result), TensorLayout::dense(out_features, 1, 1, layout));
+}
+
+std::vector<int> fc_rotation_shifts(int out_features, const SlotLayout& layout) {
+    int n = out_features;
+    int n1, n2;
+    bsgs_dims(n, n1, n2);
+    
+    std::vector<int> shifts;
+    for (int i = 1; i < n2; ++i) shifts.push_back(i);                // Baby steps
+    for (int j = 1; j < n1; ++j) shifts.push_back(j * n2);           // Giant steps
+    shifts = layout.rotations(shifts);
+    
+    for (int s : block_sum_rotation_shifts(n, 1, layout)) shifts.push_back(s);  // Rotate-and-sum
+    return shifts;
 }
 
 } // namespace fhe_cnn
\ No newline at end of file
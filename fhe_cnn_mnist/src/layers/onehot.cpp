@@ -1,26 +1,111 @@
 #include "fhe_cnn/onehot.hpp"
 #include "fhe_cnn/bootstrapping.hpp"
+#include "fhe_cnn/permutation.hpp"
+#include "fhe_cnn/planner.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
+#include "fhe_cnn/rotation.hpp"
 #include <iostream>
 #include <cmath>
+#include <set>
+#include <string>
 
 namespace fhe_cnn {
 
 using namespace heaan;
 
+// ------------------------------------------------------------
+// Géométrie de l'argmax SIMD
+//   span   : slots couverts par les logits de toutes les images
+//   step   : écart entre deux classes d'une même image
+//   blocks : nombre de blocs (puissance de 2 >= 2n-1)
+//   width  : largeur d'un bloc (puissance de 2 >= span + blocks·step)
+// ------------------------------------------------------------
+struct ArgmaxLayout {
+    int span;
+    int step;
+    int blocks;
+    int width;
+};
+
+static int next_pow2(int v) {
+    int p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static ArgmaxLayout argmax_geometry(int num_classes, const SlotLayout& slots) {
+    ArgmaxLayout layout;
+    layout.span = slots.span(num_classes);
+    layout.step = slots.rotation(1);
+    layout.blocks = next_pow2(2 * num_classes - 1);
+    layout.width = next_pow2(layout.span + layout.blocks * layout.step);
+    return layout;
+}
+
+static bool argmax_fits(const ArgmaxLayout& layout, int log_slots) {
+    return (long long)layout.blocks * layout.width <= (1LL << log_slots);
+}
+
+static ArgmaxLayout argmax_layout(int num_classes, const SlotLayout& slots, int log_slots) {
+    auto layout = argmax_geometry(num_classes, slots);
+    if (!argmax_fits(layout, log_slots)) {
+        throw std::runtime_error("homomorphic_argmax: trop d'images pour le nombre de slots");
+    }
+    return layout;
+}
+
+// ------------------------------------------------------------
+// Emplacement des logits pendant l'argmax: celui de l'entrée s'il tient,
+// sinon (blocs au stride du packer) un bloc de num_classes slots par image
+// ------------------------------------------------------------
+static SlotLayout argmax_slots(int num_classes, const SlotLayout& slots, int log_slots) {
+    if (argmax_fits(argmax_geometry(num_classes, slots), log_slots)) return slots;
+    if (slots.interleavedOrder() || slots.stride <= num_classes) return slots;  // argmax_layout lèvera
+    return SlotLayout::block(slots.batch, num_classes);
+}
+
+// Rapprochement des blocs: logit t de l'image m vers compact.slot(m, t).
+// Les masques de la permutation isolent aussi les logits (même niveau que
+// le masque d'isolement qu'elle remplace)
+static std::vector<SlotMove> logit_compaction(
+    int num_classes,
+    const SlotLayout& slots,
+    const SlotLayout& compact
+) {
+    std::vector<SlotMove> moves;
+    for (int m = 0; m < slots.batch; ++m) {
+        for (int t = 0; t < num_classes; ++t) {
+            moves.push_back({slots.slot(m, t), compact.slot(m, t)});
+        }
+    }
+    return moves;
+}
+
+// Multiplication par un masque clair (consomme un niveau)
+static Ptr<ICiphertext> apply_mask(
+    const ICiphertext& ct,
+    const Message<Complex>& msg_mask,
+    PresetParamsId preset_id,
+    EnDecoder& encoder,
+    HomEval& eval
+) {
+    auto ptxt_mask_leveled = encode_cached(msg_mask, eval.getLevel(ct), preset_id, encoder, eval);
+    
+    auto ct_masked = ICiphertext::make();
+    eval.mul(ct, *ptxt_mask_leveled, *ct_masked);
+    eval.rescale(*ct_masked, *ct_masked);
+    return ct_masked;
+}
+
 // ------------------------------------------------------------
 // Approximation de la fonction de Heaviside (x > 0)
 // Polynomiale degré 3: 0.5 + 0.5 * (x / (1 + |x|))
 // ------------------------------------------------------------
-Ptr<ICiphertext> homomorphic_gt(
-    const ICiphertext& x_enc,
-    const ICiphertext& y_enc,
+Ptr<ICiphertext> homomorphic_step(
+    const ICiphertext& diff_enc,
     HomEval& eval,
     const ISwKey& relin_key
 ) {
-    // x - y
-    auto ct_diff = ICiphertext::make();
-    eval.sub(x_enc, y_enc, *ct_diff);
-    
     // Approximation de sign(x) sur [-1, 1]
     // On utilise: 0.5 + 0.5 * (x / (1 + |x|))
     // Approximation polynomiale: 0.5 + 0.3125x - 0.0625x^3
@@ -31,7 +116,7 @@ Ptr<ICiphertext> homomorphic_gt(
     // sign(x) ≈ 0.5 + 0.5x - 0.125x^3 pour x dans [-2,2]
     
     auto ct_x = ICiphertext::make();
-    *ct_x = ct_diff;
+    *ct_x = diff_enc;
     
     // Mise à l'échelle pour être dans [-1,1]
     eval.mul(*ct_x, 0.5, *ct_x);
@@ -66,12 +151,25 @@ Ptr<ICiphertext> homomorphic_gt(
     return ct_sign;
 }
 
+Ptr<ICiphertext> homomorphic_gt(
+    const ICiphertext& x_enc,
+    const ICiphertext& y_enc,
+    HomEval& eval,
+    const ISwKey& relin_key
+) {
+    // x - y
+    auto ct_diff = ICiphertext::make();
+    eval.sub(x_enc, y_enc, *ct_diff);
+    
+    return homomorphic_step(*ct_diff, eval, relin_key);
+}
+
 // ------------------------------------------------------------
 // Trouver le maximum par tournoi binaire
 // ------------------------------------------------------------
 Ptr<ICiphertext> homomorphic_max(
     const ICiphertext& logits_enc,
-    std::map<int, Ptr<ISwKey>>& rot_keys,
+    RotationKeyStore& rot_keys,
     HomEval& eval,
     const ISwKey& relin_key
 ) {
@@ -88,13 +186,7 @@ Ptr<ICiphertext> homomorphic_max(
         if (shift >= 10) break;
         
         // Rotation
-        auto ct_rot = ICiphertext::make();
-        auto it = rot_keys.find(shift);
-        if (it == rot_keys.end()) {
-            std::cerr << "    ERREUR: Clé rotation " << shift << " manquante!" << std::endl;
-            continue;
-        }
-        eval.rot(*ct_current, shift, *ct_rot, *(it->second));
+        auto ct_rot = homomorphic_rotate(*ct_current, shift, rot_keys, eval);
         
         // Comparaison: max(x, y) = x + (y-x)*gt(y,x)
         auto ct_gt = homomorphic_gt(*ct_rot, *ct_current, eval, relin_key);
@@ -120,119 +212,160 @@ Ptr<ICiphertext> homomorphic_max(
 }
 
 // ------------------------------------------------------------
-// One-hot vector complet
+// Argmax SIMD (un seul polynôme de signe pour toutes les paires)
 // ------------------------------------------------------------
-Ptr<ICiphertext> homomorphic_onehot(
-    const ICiphertext& logits_enc,
-    const ISecretKey& sk,
-    std::map<int, Ptr<ISwKey>>& rot_keys,
-    HomEval& eval,
-    const ISwKey& relin_key
+std::vector<int> argmax_rotation_shifts(
+    int num_classes,
+    const SlotLayout& slots,
+    int log_slots
 ) {
-    std::cout << "    🔥 Conversion en one-hot vector..." << std::endl;
+    int num_slots = 1 << log_slots;
+    const SlotLayout compact = argmax_slots(num_classes, slots, log_slots);
+    auto layout = argmax_layout(num_classes, compact, log_slots);
+    
+    std::set<int> shifts;
+    auto add = [&](int shift) {
+        int s = ((shift % num_slots) + num_slots) % num_slots;
+        if (s != 0) shifts.insert(s);
+    };
+    
+    if (compact.stride != slots.stride) {
+        SlotPermutation plan(logit_compaction(num_classes, slots, compact), slots.span(num_classes),
+                             SlotLayout(), log_slots);
+        for (int s : plan.rotationShifts()) add(s);
+    }
+    add(-(num_classes - 1) * layout.step);
+    for (int s : replicate_rotation_shifts(layout.blocks, -layout.width)) add(s);                 // Réplication des logits
+    for (int s : replicate_rotation_shifts(layout.blocks, -(layout.width - layout.step))) add(s);  // Copies décalées
+    for (int step = 1; step < layout.blocks; step <<= 1) {
+        add(step * layout.width);  // Somme par classe
+    }
+    
+    return std::vector<int>(shifts.begin(), shifts.end());
+}
+
+CtTensor homomorphic_argmax(
+    const CtTensor& logits,
+    FheContext& ctx
+) {
+    if (!logits.layout.dense()) {
+        throw std::runtime_error("homomorphic_argmax: logits non contigus");
+    }
+    const ICiphertext& logits_enc = logits.ct();
+    int num_classes = logits.size();
+    
+    HomEval& eval = ctx.eval();
+    RotationKeyStore& rot_keys = ctx.rotKeys();
+    int log_slots = ctx.logSlots();
+    
+    int n = num_classes;
+    int num_slots = 1 << log_slots;
+    const SlotLayout slots = argmax_slots(num_classes, logits.layout.slots, log_slots);
+    auto layout = argmax_layout(num_classes, slots, log_slots);
+    int width = layout.width;
+    int num_images = slots.batch;
+    
+    std::cout << "    🔍 Argmax SIMD: " << num_images << " image(s) × " << n 
+              << " classes, " << layout.blocks << " blocs de " << width << " slots" << std::endl;
     
     // --------------------------------------------------------
-    // 1. Trouver la valeur maximale
+    // 1. Isoler les logits (le reste des slots est du déchet), en
+    //    rapprochant les blocs si l'entrée est trop étalée
     // --------------------------------------------------------
-    auto ct_max = homomorphic_max(logits_enc, rot_keys, eval, relin_key);
-    
-    // Bootstrap si nécessaire
-    if (eval.getLevel(*ct_max) < 5) {
-        std::cout << "      Bootstrap pour one-hot..." << std::endl;
-        BootKeyPtrs bootkeys(PresetParamsId::F16Opt_Gr, sk);
-        Bootstrapper bootstrapper(PresetParamsId::F16Opt_Gr, bootkeys);
-        bootstrapper.warmup();
-        bootstrapper.bootstrap(*ct_max);
+    Ptr<ICiphertext> ct_x;
+    if (slots.stride != logits.layout.slots.stride) {
+        auto plan = make_permutation(logit_compaction(n, logits.layout.slots, slots),
+                                     logits.layout.slots.span(n), SlotLayout(), log_slots, ctx.preset());
+        ct_x = plan->apply(logits_enc, rot_keys, eval, ctx.encoder());
+    } else {
+        Message<Complex> msg_logits(log_slots, Device::CPU);
+        for (int i = 0; i < num_slots; ++i) msg_logits[i] = Complex(0.0, 0.0);
+        for (int m = 0; m < num_images; ++m) {
+            for (int t = 0; t < n; ++t) {
+                msg_logits[slots.slot(m, t)] = Complex(1.0, 0.0);
+            }
+        }
+        ct_x = apply_mask(logits_enc, msg_logits, ctx.preset(), ctx.encoder(), eval);
     }
     
     // --------------------------------------------------------
-    // 2. Créer le masque pour duplication du max
+    // 2. Répliquer x dans chaque bloc: X[k*width + i] = x[i]
     // --------------------------------------------------------
-    int log_slots = sk.logDegree() - 1;
-    EnDecoder encoder(PresetParamsId::F16Opt_Gr);
+    auto ct_rep = homomorphic_replicate(*ct_x, layout.blocks, -width, SlotLayout(), rot_keys, eval);
     
-    Message<Complex> msg_mask(log_slots, Device::CPU);
-    msg_mask[0] = Complex(1.0, 0.0);
-    for (int i = 1; i < (1 << log_slots); ++i) {
-        msg_mask[i] = Complex(0.0, 0.0);
-    }
+    // --------------------------------------------------------
+    // 3. Copies décalées: S[k*width + i] = x[i + k - (n-1)]
+    //    (chaque bloc avance d'une classe de plus que le précédent)
+    // --------------------------------------------------------
+    auto ct_first = homomorphic_rotate(*ct_x, -(n - 1) * layout.step, rot_keys, eval);
+    auto ct_shifted = homomorphic_replicate(*ct_first, layout.blocks, -(width - layout.step),
+                                            SlotLayout(), rot_keys, eval);
     
-    auto ptxt_mask = IPlaintext::make();
-    encoder.encode(msg_mask, *ptxt_mask);
-    
-    // Extraire le max du slot 0
-    auto ct_max_slot0 = ICiphertext::make();
-    auto ptxt_mask_leveled = IPlaintext::make();
-    eval.levelDownTo(*ptxt_mask, *ptxt_mask_leveled, eval.getLevel(*ct_max));
-    eval.mul(*ct_max, *ptxt_mask_leveled, *ct_max_slot0);
-    eval.rescale(*ct_max_slot0, *ct_max_slot0);
-    
-    // Dupliquer dans tous les slots 0-9
-    auto ct_max_all = ICiphertext::make();
-    *ct_max_all = *ct_max_slot0;
-    
-    for (int i = 1; i < 10; ++i) {
-        auto ct_rot = ICiphertext::make();
-        auto it = rot_keys.find(i);
-        if (it != rot_keys.end()) {
-            eval.rot(*ct_max_slot0, i, *ct_rot, *(it->second));
-            
-            auto ct_add = ICiphertext::make();
-            eval.add(*ct_max_all, *ct_rot, *ct_add);
-            *ct_max_all = *ct_add;
+    // --------------------------------------------------------
+    // 4. Toutes les différences x_i - x_j, un seul polynôme de signe
+    // --------------------------------------------------------
+    auto ct_diff = ICiphertext::make();
+    eval.sub(*ct_rep, *ct_shifted, *ct_diff);
+    
+    auto ct_gt = homomorphic_step(*ct_diff, eval, ctx.relinKey());
+    
+    // --------------------------------------------------------
+    // 5. Garder les paires valides (même image, j != i)
+    //    et normaliser par n-1 dans le même masque
+    // --------------------------------------------------------
+    Message<Complex> msg_valid(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) msg_valid[i] = Complex(0.0, 0.0);
+    for (int k = 0; k < 2 * n - 1; ++k) {
+        if (k == n - 1) continue;  // Comparaison avec soi-même
+        for (int m = 0; m < num_images; ++m) {
+            for (int t = 0; t < n; ++t) {
+                int other = t + k - (n - 1);
+                if (other < 0 || other >= n) continue;
+                msg_valid[k * width + slots.slot(m, t)] = Complex(1.0 / (n - 1), 0.0);
+            }
         }
     }
+    auto ct_scores = apply_mask(*ct_gt, msg_valid, ctx.preset(), ctx.encoder(), eval);
     
     // --------------------------------------------------------
-    // 3. Comparer chaque logit avec le max
+    // 6. Réduction par classe: somme des blocs dans le bloc 0
     // --------------------------------------------------------
-    auto ct_onehot = ICiphertext::make();
-    bool first = true;
+    for (int step = 1; step < layout.blocks; step <<= 1) {
+        auto ct_rot = homomorphic_rotate(*ct_scores, step * width, rot_keys, eval);
+        auto ct_add = ICiphertext::make();
+        eval.add(*ct_scores, *ct_rot, *ct_add);
+        ct_scores = std::move(ct_add);
+    }
     
-    for (int i = 0; i < 10; ++i) {
-        // Extraire le i-ème logit
-        auto ct_logit_i = ICiphertext::make();
-        
-        if (i == 0) {
-            *ct_logit_i = logits_enc;
-        } else {
-            auto it = rot_keys.find(i);
-            if (it != rot_keys.end()) {
-                eval.rot(logits_enc, -i, *ct_logit_i, *(it->second));
-            }
-        }
-        
-        // Extraire le slot 0
-        auto ct_logit_slot0 = ICiphertext::make();
-        auto ptxt_mask_logit = IPlaintext::make();
-        eval.levelDownTo(*ptxt_mask, *ptxt_mask_logit, eval.getLevel(*ct_logit_i));
-        eval.mul(*ct_logit_i, *ptxt_mask_logit, *ct_logit_slot0);
-        eval.rescale(*ct_logit_slot0, *ct_logit_slot0);
-        
-        // Comparer avec le max
-        auto ct_eq = homomorphic_gt(*ct_max_slot0, *ct_logit_slot0, eval, relin_key);
-        
-        // Rotation à la position i
-        if (i > 0) {
-            auto ct_rot = ICiphertext::make();
-            auto it = rot_keys.find(i);
-            if (it != rot_keys.end()) {
-                eval.rot(*ct_eq, i, *ct_rot, *(it->second));
-                ct_eq = std::move(ct_rot);
-            }
-        }
-        
-        // Accumuler
-        if (first) {
-            *ct_onehot = *ct_eq;
-            first = false;
-        } else {
-            auto ct_add = ICiphertext::make();
-            eval.add(*ct_onehot, *ct_eq, *ct_add);
-            *ct_onehot = *ct_add;
-        }
+    return CtTensor(std::move(ct_scores), TensorLayout::dense(n, 1, 1, slots));
+}
+
+// ------------------------------------------------------------
+// One-hot vector complet
+// ------------------------------------------------------------
+CtTensor homomorphic_onehot(
+    const CtTensor& logits,
+    FheContext& ctx
+) {
+    std::cout << "    🔥 Conversion en one-hot vector..." << std::endl;
+    
+    // Profondeur: masque (1) + signe (4) + masque des paires (1)
+    const int argmax_depth = layer_depth({"onehot", LayerKind::OneHot});
+    
+    auto ct_logits = ICiphertext::make();
+    *ct_logits = logits.ct();
+    
+    // Garde-fou: normalement déjà placé par le plan de niveaux
+    if (ctx.eval().getLevel(*ct_logits) < argmax_depth) {
+        std::cout << "      Bootstrap pour one-hot..." << std::endl;
+        ctx.bootstrap().bootstrap(*ct_logits);
     }
     
+    // --------------------------------------------------------
+    // Score par classe: fraction des autres classes battues
+    // --------------------------------------------------------
+    auto ct_onehot = homomorphic_argmax(CtTensor(std::move(ct_logits), logits.layout), ctx);
+    
     std::cout << "    ✅ One-hot vector généré" << std::endl;
     
     return ct_onehot;
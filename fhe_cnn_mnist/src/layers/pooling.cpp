@@ -1,87 +1,129 @@
 #include "fhe_cnn/pooling.hpp"
+#include "fhe_cnn/permutation.hpp"
+#include "fhe_cnn/rotation.hpp"
 #include <iostream>
+#include <map>
+#include <set>
 
 namespace fhe_cnn {
 
 using namespace heaan;
 
-Ptr<ICiphertext> homomorphic_avgpool2d(
-    const ICiphertext& input_enc,
-    int c,
-    int h,
-    int w,
-    std::map<int, Ptr<ISwKey>>& rot_keys,
-    HomEval& eval
+// Compaction des canaux [0, channels) d'un ciphertext: le pixel (2y, 2x)
+// va à l'indice dense (ch, y, x), ×0.25 de la moyenne porté par les masques
+static std::vector<SlotMove> compaction_moves(const TensorLayout& input, int channels) {
+    int out_h = input.h / 2;
+    int out_w = input.w / 2;
+    
+    std::vector<SlotMove> moves;
+    for (int ch = 0; ch < channels; ++ch) {
+        for (int y = 0; y < out_h; ++y) {
+            for (int x = 0; x < out_w; ++x) {
+                moves.push_back({input.index(ch, 2 * y, 2 * x), (ch * out_h + y) * out_w + x, 0.25});
+            }
+        }
+    }
+    return moves;
+}
+
+CtTensor homomorphic_avgpool2d(
+    const CtTensor& input,
+    FheContext& ctx,
+    bool compact
 ) {
-    std::cout << "🔷 AvgPool2d: " << c << "×" << h << "×" << w 
-              << " → " << c << "×" << h/2 << "×" << w/2 << std::endl;
+    int c = input.layout.c;
+    int h = input.layout.h;
+    int w = input.layout.w;
     
-    int out_h = h / 2;
-    int out_w = w / 2;
+    std::cout << "🔷 AvgPool2d: " << c << "×" << h << "×" << w
+              << " → " << c << "×" << h/2 << "×" << w/2
+              << (compact ? " (compacté)" : "") << std::endl;
     
-    // ------------------------------------------------------------
-    // 1. Créer une copie du ciphertext d'entrée
-    // ------------------------------------------------------------
-    auto ct_sum = ICiphertext::make();
-    *ct_sum = input_enc;  // Copie
+    RotationKeyStore& rot_keys = ctx.rotKeys();
+    int log_slots = ctx.logSlots();
+    int ws = input.layout.w_stride;
+    int hs = input.layout.h_stride;
     
-    // ------------------------------------------------------------
-    // 2. Additionner le pixel à droite (shift = 1)
-    // ------------------------------------------------------------
-    auto it1 = rot_keys.find(1);
-    if (it1 != rot_keys.end()) {
-        auto ct_rot1 = ICiphertext::make();
-        eval.rot(*ct_sum, 1, *ct_rot1, *(it1->second));
-        
-        auto ct_add1 = ICiphertext::make();
-        eval.add(*ct_sum, *ct_rot1, *ct_add1);
-        ct_sum = std::move(ct_add1);
-    }
+    CtTensor output;
+    output.cts.resize(input.cts.size());
+    output.layout = avgpool2d_output_layout(input.layout, compact);
     
-    // ------------------------------------------------------------
-    // 3. Additionner le pixel en bas (shift = w)
-    // ------------------------------------------------------------
-    auto itw = rot_keys.find(w);
-    if (itw != rot_keys.end()) {
-        auto ct_rotw = ICiphertext::make();
-        eval.rot(*ct_sum, w, *ct_rotw, *(itw->second));
-        
-        auto ct_addw = ICiphertext::make();
-        eval.add(*ct_sum, *ct_rotw, *ct_addw);
-        ct_sum = std::move(ct_addw);
+    // Un plan par nombre de canaux (le dernier ciphertext peut en porter moins)
+    std::map<int, std::shared_ptr<const SlotPermutation>> plans;
+    if (compact) {
+        for (int g = 0; g < input.layout.numCts(); ++g) {
+            int channels = input.layout.channelsIn(g);
+            if (!plans.count(channels)) {
+                plans[channels] = make_permutation(compaction_moves(input.layout, channels),
+                                                   input.layout.extent(), input.layout.slots, log_slots,
+                                                   ctx.preset());
+            }
+        }
+        const SlotPermutation& plan = *plans.begin()->second;
+        std::cout << "    Compaction " << (plan.method() == PermutationMethod::Bsgs ? "BSGS" : "log-step")
+                  << ": " << plan.rotations() << " rotations, profondeur " << plan.depth() << std::endl;
     }
     
-    // ------------------------------------------------------------
-    // 4. Additionner le pixel en bas à droite (shift = w + 1)
-    // ------------------------------------------------------------
-    int shift_w1 = w + 1;
-    auto itw1 = rot_keys.find(shift_w1);
-    if (itw1 != rot_keys.end()) {
-        auto ct_rotw1 = ICiphertext::make();
-        eval.rot(*ct_sum, shift_w1, *ct_rotw1, *(itw1->second));
+    // Même pooling sur chaque ciphertext (canaux indépendants)
+    parallel_for_cts((int)input.cts.size(), ctx, [&](int g, HomEval& eval, EnDecoder& encoder) {
+        // ------------------------------------------------------------
+        // 1. Somme 2×2 en deux sommes par blocs: le pixel à droite
+        //    (w_stride), puis la ligne du dessous (h_stride) de cette somme
+        // ------------------------------------------------------------
+        auto ct_row = homomorphic_block_sum(*input.cts[g], 2, ws, input.layout.slots, rot_keys, eval);
+        auto ct_sum = homomorphic_block_sum(*ct_row, 2, hs, input.layout.slots, rot_keys, eval);
         
-        auto ct_addw1 = ICiphertext::make();
-        eval.add(*ct_sum, *ct_rotw1, *ct_addw1);
-        ct_sum = std::move(ct_addw1);
-    }
+        // ------------------------------------------------------------
+        // 2. Moyenne: ×0.25 fusionné avec la compaction (masques BSGS
+        //    qui ne gardent que les pixels (2y, 2x), rangés en dense),
+        //    ou ×0.25 seul en laissant les pixels en place
+        // ------------------------------------------------------------
+        if (compact) {
+            const SlotPermutation& plan = *plans.at(input.layout.channelsIn(g));
+            output.cts[g] = plan.apply(*ct_sum, rot_keys, eval, encoder);
+        } else {
+            auto ct_result = ICiphertext::make();
+            eval.mul(*ct_sum, 0.25, *ct_result);
+            eval.rescale(*ct_result, *ct_result);
+            output.cts[g] = std::move(ct_result);
+        }
+    });
     
-    // ------------------------------------------------------------
-    // 5. Multiplier par 0.25 pour la moyenne
-    // ------------------------------------------------------------
-    auto ct_result = ICiphertext::make();
-    eval.mul(*ct_sum, 0.25, *ct_result);
-    eval.rescale(*ct_result, *ct_result);
+    std::cout << "    ✅ AvgPool2d terminé, niveau: "
+              << output.level(ctx.eval()) << std::endl;
     
-    // ------------------------------------------------------------
-    // 6. Nettoyer les slots: on ne garde qu'un pixel sur 2
-    //    (les autres sont des déchets)
-    // ------------------------------------------------------------
-    // Pour l'instant on garde tel quel, on fera le masking plus tard
-    
-    std::cout << "    ✅ AvgPool2d terminé, niveau: " 
-              << eval.getLevel(*ct_result) << std::endl;
+    return output;
+}
+
+TensorLayout avgpool2d_output_layout(const TensorLayout& input, bool compact) {
+    if (compact) {
+        TensorLayout output = TensorLayout::dense(input.c, input.h / 2, input.w / 2, input.slots);
+        output.ct_channels = input.ct_channels;
+        return output;
+    }
     
-    return ct_result;
+    TensorLayout output = input;
+    output.h = input.h / 2;
+    output.w = input.w / 2;
+    output.h_stride = 2 * input.h_stride;
+    output.w_stride = 2 * input.w_stride;
+    return output;
+}
+
+std::vector<int> avgpool2d_rotation_shifts(const TensorLayout& input, int log_slots, bool compact) {
+    std::set<int> shifts;
+    for (int stride : {input.w_stride, input.h_stride}) {
+        for (int shift : block_sum_rotation_shifts(2, stride, input.slots)) shifts.insert(shift);
+    }
+    if (compact) {
+        // Plan seul (rien à encoder), sans passer par le cache
+        for (int g = 0; g < input.numCts(); ++g) {
+            SlotPermutation plan(compaction_moves(input, input.channelsIn(g)), input.extent(), input.slots,
+                                 log_slots);
+            for (int shift : plan.rotationShifts()) shifts.insert(shift);
+        }
+    }
+    return std::vector<int>(shifts.begin(), shifts.end());
 }
 
-} // namespace fhe_cnn
\ No newline at end of file
+} // namespace fhe_cnn
@@ -10,17 +10,24 @@ Ptr<ICiphertext> homomorphic_relu(
     const ICiphertext& input_enc,
     int degree,
     double scale_factor,
-    HomEval& eval,
-    const ISwKey& relin_key
+    FheContext& ctx
 ) {
     std::cout << "🔷 ReLU (degré " << degree << ", scale=" << scale_factor << ")" << std::endl;
     
+    HomEval& eval = ctx.eval();
+    const ISwKey& relin_key = ctx.relinKey();
+    
     // ------------------------------------------------------------
     // 1. Mettre à l'échelle dans [-1, 1]
+    //    (scale 1: déjà replié dans les poids, pas de niveau consommé)
     // ------------------------------------------------------------
     auto ct_scaled = ICiphertext::make();
-    eval.mul(input_enc, 1.0 / scale_factor, *ct_scaled);
-    eval.rescale(*ct_scaled, *ct_scaled);
+    if (scale_factor == 1.0) {
+        *ct_scaled = input_enc;
+    } else {
+        eval.mul(input_enc, 1.0 / scale_factor, *ct_scaled);
+        eval.rescale(*ct_scaled, *ct_scaled);
+    }
     
     // ------------------------------------------------------------
     // 2. Évaluation polynomiale selon le degré
@@ -156,8 +163,12 @@ Ptr<ICiphertext> homomorphic_relu(
     // 3. Remettre à l'échelle originale
     // ------------------------------------------------------------
     auto ct_restored = ICiphertext::make();
-    eval.mul(*ct_result, scale_factor, *ct_restored);
-    eval.rescale(*ct_restored, *ct_restored);
+    if (scale_factor == 1.0) {
+        ct_restored = std::move(ct_result);
+    } else {
+        eval.mul(*ct_result, scale_factor, *ct_restored);
+        eval.rescale(*ct_restored, *ct_restored);
+    }
     
     std::cout << "    ✅ ReLU terminé, niveau: " 
               << eval.getLevel(*ct_restored) << std::endl;
@@ -165,4 +176,18 @@ Ptr<ICiphertext> homomorphic_relu(
     return ct_restored;
 }
 
+CtTensor homomorphic_relu(
+    const CtTensor& input,
+    int degree,
+    double scale_factor,
+    FheContext& ctx
+) {
+    CtTensor output;
+    output.layout = input.layout;
+    for (const auto& ct : input.cts) {
+        output.cts.push_back(homomorphic_relu(*ct, degree, scale_factor, ctx));
+    }
+    return output;
+}
+
 } // namespace fhe_cnn
\ No newline at end of file
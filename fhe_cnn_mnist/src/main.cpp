@@ -3,6 +3,10 @@
 #include "fhe_cnn/pooling.hpp"
 #include "fhe_cnn/relu.hpp"
 #include "fhe_cnn/bootstrapping.hpp"
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
+#include "fhe_cnn/presets.hpp"
+#include "fhe_cnn/planner.hpp"
 #include "fhe_cnn/utils.hpp"
 #include <iostream>
 #include <chrono>
@@ -12,7 +16,7 @@
 using namespace heaan;
 using namespace fhe_cnn;
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "\n🚀 FHE CNN MNIST - Projet 5CS09" << std::endl;
     std::cout << "=================================" << std::endl;
     
@@ -23,19 +27,16 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n1. Initialisation HEAAN2..." << std::endl;
     
-    auto preset_id = PresetParamsId::F16Opt_Gr;
+    // Preset en argument (défaut F16Opt_Gr), voir known_presets()
+    auto preset_id = argc > 1 ? parse_preset(argv[1]) : PresetParamsId::F16Opt_Gr;
+    std::cout << "    Preset: " << preset_name(preset_id) << std::endl;
     
     // Génération de la clé secrète
     SKGenerator skgen(preset_id);
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    // Génération de la clé de relinéarisation
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
-    
-    // Évaluateur homomorphe
-    HomEval eval(preset_id);
+    // Encodage/chiffrement côté client
     EnDecoder encoder(preset_id);
     EnDecryptor encryptor(preset_id);
     
@@ -73,9 +74,45 @@ int main() {
         // ------------------------------------------------------------
         std::cout << "\n3. Génération des clés de rotation..." << std::endl;
         
-        std::map<int, Ptr<ISwKey>> rot_keys;
+        // Contexte FHE côté serveur: évaluateur, encodeur et clés d'évaluation,
+        // bootstrap compris si le preset le permet (créés une seule fois pour toutes les images)
+        FheContext ctx(preset_id, *sk, preset_has_bootstrap(preset_id));
         int max_rot = 900;  // Pour image 28×28 + décalages
-        generate_all_rot_keys(*sk, max_rot, rot_keys);
+        generate_all_rot_keys(ctx.server(), *sk, max_rot);
+        
+        HomEval& eval = ctx.eval();
+        BootstrapContext* boot_ctx = ctx.hasBootstrap() ? &ctx.bootstrap() : nullptr;
+        
+        // Sans bootstrap, tout le réseau doit tenir dans les niveaux d'une
+        // image fraîche (plan sans bootstrap, scales non repliés)
+        if (!boot_ctx) {
+            std::vector<LayerSpec> network = {
+                {"conv1", LayerKind::Conv2d},
+                {"relu1", LayerKind::ReLU, 5, 2.0},
+                {"pool1", LayerKind::AvgPool},
+                {"conv2", LayerKind::Conv2d},
+                {"relu2", LayerKind::ReLU, 5, 2.0},
+                {"pool2", LayerKind::AvgPool},
+                {"fc1", LayerKind::FC},
+                {"relu3", LayerKind::ReLU, 5, 2.0},
+                {"fc2", LayerKind::FC},
+                {"relu4", LayerKind::ReLU, 5, 2.0},
+                {"fc3", LayerKind::FC}
+            };
+            int initial_level = eval.getLevel(*encrypt_image(images[0], *sk, encoder, encryptor));
+            bool fits = false;
+            try {
+                fits = plan_levels(network, initial_level, initial_level, 0, false).num_bootstraps == 0;
+            } catch (const std::runtime_error&) {
+                fits = false;
+            }
+            if (!fits) {
+                throw PresetMismatchError(std::string("profondeur insuffisante sans bootstrap pour ") + 
+                                          preset_name(preset_id) + " (niveau initial " + 
+                                          std::to_string(initial_level) + ")");
+            }
+            std::cout << "    Sans bootstrap: le réseau tient dans " << initial_level << " niveaux" << std::endl;
+        }
         
         // ------------------------------------------------------------
         // 4. Inférence homomorphe sur N images
@@ -93,24 +130,22 @@ int main() {
             // Chiffrement de l'image (1×28×28)
             // --------------------------------------------------------
             std::cout << "    Chiffrement..." << std::endl;
-            auto ct = encrypt_image(images[idx], *sk, encoder, encryptor);
-            std::cout << "      Niveau initial: " << eval.getLevel(*ct) << std::endl;
+            CtTensor x(encrypt_image(images[idx], *sk, encoder, encryptor), TensorLayout::dense(1, 28, 28));
+            std::cout << "      Niveau initial: " << x.level(eval) << std::endl;
             
             // --------------------------------------------------------
             // Conv1: 1×28×28 → 8×24×24
             // --------------------------------------------------------
             std::cout << "    Conv1..." << std::endl;
-            ct = homomorphic_conv2d(
-                *ct, conv1_w, conv1_b,
-                1, 28, 28,     // in_c, in_h, in_w
+            x = homomorphic_conv2d(
+                x, conv1_w, conv1_b,
                 8, 5,          // out_c, kernel
-                24, 24,        // out_h, out_w
-                *sk, rot_keys, *relin_key, eval
+                ctx
             );
             
             // Bootstrap si nécessaire
-            if (need_bootstrap(*ct, eval, 4)) {
-                bootstrap_ciphertext(ct, *sk, eval);
+            if (boot_ctx && need_bootstrap(x.ct(), eval, 4)) {
+                bootstrap_ciphertext(x.cts[0], *boot_ctx, eval);
             }
             
             // --------------------------------------------------------
@@ -118,29 +153,27 @@ int main() {
             // --------------------------------------------------------
             std::cout << "    ReLU1..." << std::endl;
             double scale1 = 2.0;  // À ajuster selon la distribution
-            ct = homomorphic_relu(*ct, 5, scale1, eval, *relin_key);
+            x = homomorphic_relu(x, 5, scale1, ctx);
             
             // --------------------------------------------------------
             // AvgPool1: 8×24×24 → 8×12×12
             // --------------------------------------------------------
             std::cout << "    AvgPool1..." << std::endl;
-            ct = homomorphic_avgpool2d(*ct, 8, 24, 24, rot_keys, eval);
+            x = homomorphic_avgpool2d(x, ctx);
             
             // --------------------------------------------------------
             // Conv2: 8×12×12 → 16×8×8
             // --------------------------------------------------------
             std::cout << "    Conv2..." << std::endl;
-            ct = homomorphic_conv2d(
-                *ct, conv2_w, conv2_b,
-                8, 12, 12,     // in_c, in_h, in_w
+            x = homomorphic_conv2d(
+                x, conv2_w, conv2_b,
                 16, 5,         // out_c, kernel
-                8, 8,          // out_h, out_w
-                *sk, rot_keys, *relin_key, eval
+                ctx
             );
             
             // Bootstrap si nécessaire
-            if (need_bootstrap(*ct, eval, 4)) {
-                bootstrap_ciphertext(ct, *sk, eval);
+            if (boot_ctx && need_bootstrap(x.ct(), eval, 4)) {
+                bootstrap_ciphertext(x.cts[0], *boot_ctx, eval);
             }
             
             // --------------------------------------------------------
@@ -148,13 +181,13 @@ int main() {
             // --------------------------------------------------------
             std::cout << "    ReLU2..." << std::endl;
             double scale2 = 2.0;  // À ajuster
-            ct = homomorphic_relu(*ct, 5, scale2, eval, *relin_key);
+            x = homomorphic_relu(x, 5, scale2, ctx);
             
             // --------------------------------------------------------
             // AvgPool2: 16×8×8 → 16×4×4
             // --------------------------------------------------------
             std::cout << "    AvgPool2..." << std::endl;
-            ct = homomorphic_avgpool2d(*ct, 16, 8, 8, rot_keys, eval);
+            x = homomorphic_avgpool2d(x, ctx);
             
             // --------------------------------------------------------
             // Flatten: 16×4×4 = 256
@@ -166,14 +199,11 @@ int main() {
             // FC1: 256 → 128
             // --------------------------------------------------------
             std::cout << "    FC1..." << std::endl;
-            ct = homomorphic_fc(
-                *ct, fc1_w, fc1_b,
-                256, 128, *sk, rot_keys, eval
-            );
+            x = homomorphic_fc(x, fc1_w, fc1_b, 128, ctx);
             
             // Bootstrap si nécessaire
-            if (need_bootstrap(*ct, eval, 4)) {
-                bootstrap_ciphertext(ct, *sk, eval);
+            if (boot_ctx && need_bootstrap(x.ct(), eval, 4)) {
+                bootstrap_ciphertext(x.cts[0], *boot_ctx, eval);
             }
             
             // --------------------------------------------------------
@@ -181,20 +211,17 @@ int main() {
             // --------------------------------------------------------
             std::cout << "    ReLU3..." << std::endl;
             double scale3 = 2.0;
-            ct = homomorphic_relu(*ct, 5, scale3, eval, *relin_key);
+            x = homomorphic_relu(x, 5, scale3, ctx);
             
             // --------------------------------------------------------
             // FC2: 128 → 64
             // --------------------------------------------------------
             std::cout << "    FC2..." << std::endl;
-            ct = homomorphic_fc(
-                *ct, fc2_w, fc2_b,
-                128, 64, *sk, rot_keys, eval
-            );
+            x = homomorphic_fc(x, fc2_w, fc2_b, 64, ctx);
             
             // Bootstrap si nécessaire
-            if (need_bootstrap(*ct, eval, 4)) {
-                bootstrap_ciphertext(ct, *sk, eval);
+            if (boot_ctx && need_bootstrap(x.ct(), eval, 4)) {
+                bootstrap_ciphertext(x.cts[0], *boot_ctx, eval);
             }
             
             // --------------------------------------------------------
@@ -202,22 +229,19 @@ int main() {
             // --------------------------------------------------------
             std::cout << "    ReLU4..." << std::endl;
             double scale4 = 2.0;
-            ct = homomorphic_relu(*ct, 5, scale4, eval, *relin_key);
+            x = homomorphic_relu(x, 5, scale4, ctx);
             
             // --------------------------------------------------------
             // FC3: 64 → 10
             // --------------------------------------------------------
             std::cout << "    FC3..." << std::endl;
-            auto ct_logits = homomorphic_fc(
-                *ct, fc3_w, fc3_b,
-                64, 10, *sk, rot_keys, eval
-            );
+            auto logits_t = homomorphic_fc(x, fc3_w, fc3_b, 10, ctx);
             
             // --------------------------------------------------------
             // Déchiffrement et prédiction
             // --------------------------------------------------------
             std::cout << "    Déchiffrement..." << std::endl;
-            auto logits = decrypt_result(*ct_logits, *sk, encoder, encryptor, 10);
+            auto logits = decrypt_result(logits_t.ct(), *sk, encoder, encryptor, 10);
             
             // Argmax
             int pred = 0;
@@ -4,45 +4,112 @@
 #include "fhe_cnn/relu.hpp"
 #include "fhe_cnn/bootstrapping.hpp"
 #include "fhe_cnn/onehot.hpp"
+#include "fhe_cnn/planner.hpp"
+#include "fhe_cnn/complex_packing.hpp"
+#include "fhe_cnn/rotation.hpp"
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/presets.hpp"
+#include "fhe_cnn/batch_packer.hpp"
+#include "fhe_cnn/layout.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
 #include "fhe_cnn/utils.hpp"
 #include <iostream>
 #include <chrono>
 #include <vector>
 #include <iomanip>
 #include <memory>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
 
 using namespace heaan;
 using namespace fhe_cnn;
 
-int main() {
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "🚀 FHE CNN MNIST - Projet 5CS09 - VERSION FINALE" << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
-    std::cout << "   ✅ CNN 5 couches homomorphe" << std::endl;
-    std::cout << "   ✅ 4 images parallélisées" << std::endl;
-    std::cout << "   ✅ One-hot vector (BONUS)" << std::endl;
-    std::cout << std::string(60, '=') << "\n" << std::endl;
+// Données MNIST et poids, chargés une seule fois pour tous les presets
+struct MnistData {
+    std::vector<std::vector<double>> images;
+    std::vector<int> labels;
+    std::vector<double> conv1_w, conv1_b, conv2_w, conv2_b;
+    std::vector<double> fc1_w, fc1_b, fc2_w, fc2_b, fc3_w, fc3_b;
+};
+
+// Bilan d'une inférence complète sur un preset
+struct RunResult {
+    int log_slots = 0;
+    int batch_size = 0;      // Images par ciphertext
+    BatchOrder order = BatchOrder::Block;
+    int num_images = 0;
+    int correct = 0;
+    int bootstraps = 0;
+    double image_ms = 0.0;   // Temps moyen par image (amorti)
+    double total_s = 0.0;    // Clés + inférence
+    std::vector<int> predictions;  // Classe prédite par image
+};
+
+// ------------------------------------------------------------
+// Réglage entier >= minimum lu dans l'environnement (défaut si absent)
+// ------------------------------------------------------------
+static int env_setting(const char* name, int fallback, int minimum) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return fallback;
     
-    auto program_start = std::chrono::high_resolution_clock::now();
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    if (*end != '\0' || parsed < minimum || parsed > INT_MAX) {
+        throw std::runtime_error(std::string(name) + " invalide: " + value +
+                                 " (entier >= " + std::to_string(minimum) + " attendu)");
+    }
+    return (int)parsed;
+}
+
+// ------------------------------------------------------------
+// Inférence complète sur un preset (lève PresetMismatchError si le réseau
+// ne tient pas: slots insuffisants, profondeur sans bootstrap ou plan impossible)
+//   num_workers: processus forkés après chargement des clés
+//   key_budget:  clés de rotation résidentes (0 = une clé par rotation déclarée)
+// ------------------------------------------------------------
+static RunResult run_preset(PresetParamsId preset_id, const MnistData& data, int num_images, BatchOrder order,
+                            int num_workers, int key_budget) {
+    auto run_start = std::chrono::high_resolution_clock::now();
     
     // ------------------------------------------------------------
-    // 1. Initialisation HEAAN2
+    // 2. Initialisation HEAAN2
     // ------------------------------------------------------------
-    std::cout << "1. Initialisation HEAAN2..." << std::endl;
+    std::cout << "\n2. Initialisation HEAAN2 (preset " << preset_name(preset_id) << ")..." << std::endl;
     
-    auto preset_id = PresetParamsId::F16Opt_Gr;
+    bool with_bootstrap = preset_has_bootstrap(preset_id);
     
-    // Génération de la clé secrète
-    SKGenerator skgen(preset_id);
-    auto sk = skgen.genKey();
-    sk->to(Device::CPU);
+    // Paquet de clés sur disque (preset + graine): généré au premier
+    // lancement, projeté en mémoire aux suivants
+    const std::string key_dir = "data/keys";
+    const uint64_t key_seed = 1;
+    std::string bundle_path = key_bundle_path(key_dir, preset_id, key_seed);
+    std::string sk_path = secret_key_path(key_dir, preset_id, key_seed);
     
-    // Génération de la clé de relinéarisation
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
+    // Paquet (clés d'évaluation, projeté par le serveur) et clé secrète
+    // (fichier client séparé) vont ensemble: l'un sans l'autre est régénéré
+    std::shared_ptr<KeyBundle> bundle;
+    if (key_bundle_exists(bundle_path) && key_bundle_exists(sk_path)) {
+        bundle = std::make_shared<KeyBundle>(bundle_path, preset_id, key_seed);
+        std::cout << "   └─ Paquet de clés: " << bundle_path << " ("
+                  << bundle->rotShifts().size() << " clés de rotation)" << std::endl;
+    }
     
-    // Évaluateur homomorphe
-    HomEval eval(preset_id);
+    // Clé secrète: côté client uniquement (chiffrement / déchiffrement)
+    Ptr<ISecretKey> sk;
+    if (bundle) {
+        sk = load_secret_key(sk_path, preset_id, key_seed);
+    } else {
+        SKGenerator skgen(preset_id);
+        sk = skgen.genKey();
+    }
+    sk->to(Device::CPU);
+    
+    // Encodage/chiffrement côté client
     EnDecoder encoder(preset_id);
     EnDecryptor decryptor(preset_id);
     
@@ -52,303 +119,713 @@ int main() {
     std::cout << "   └─ logDegree: " << sk->logDegree() << std::endl;
     std::cout << "   └─ logSlots: " << log_slots << std::endl;
     std::cout << "   └─ numSlots: " << num_slots << std::endl;
+    std::cout << "   └─ Bootstrap: " << (with_bootstrap ? "oui" : "non") << std::endl;
+    
+    // Packing complexe: 2 lots par ciphertext (parties réelle et imaginaire),
+    // séparés par conjugaison avant chaque non-linéarité
+    const bool complex_packing = true;
+    const int batches_per_ct = complex_packing ? 2 : 1;
+    
+    // ------------------------------------------------------------
+    // 2b. Le réseau tient-il dans ce preset? (avant toute génération de clés)
+    // ------------------------------------------------------------
+    enum { CONV1, RELU1, POOL1, CONV2, RELU2, POOL2, FC1, RELU3, FC2, RELU4, FC3, ONEHOT };
+    std::vector<LayerSpec> network = {
+        {"conv1", LayerKind::Conv2d},
+        {"relu1", LayerKind::ReLU, 5, 2.0},
+        {"pool1", LayerKind::AvgPool},
+        {"conv2", LayerKind::Conv2d},
+        {"relu2", LayerKind::ReLU, 5, 2.0},
+        {"pool2", LayerKind::AvgPool},
+        {"fc1", LayerKind::FC},
+        {"relu3", LayerKind::ReLU, 5, 2.0},
+        {"fc2", LayerKind::FC},
+        {"relu4", LayerKind::ReLU, 5, 2.0},
+        {"fc3", LayerKind::FC},
+        {"onehot", LayerKind::OneHot}
+    };
+    
+    for (auto& layer : network) {
+        if (layer.kind == LayerKind::ReLU || layer.kind == LayerKind::OneHot) {
+            layer.split_complex = complex_packing;
+        }
+    }
+    
+    // Empreinte d'une image en entrée de chaque couche
+    std::vector<int> footprint = {
+        784,            // conv1: 28×28
+        8 * 24 * 24,    // relu1
+        8 * 24 * 24,    // pool1
+        8 * 12 * 12,    // conv2 (pool1 compacté)
+        16 * 8 * 8,     // relu2
+        16 * 8 * 8,     // pool2
+        16 * 4 * 4,     // fc1 (pool2 compacté)
+        128,            // relu3
+        128,            // fc2
+        64,             // relu4
+        64,             // fc3
+        10              // onehot: 10 logits
+    };
+    
+    // Images par ciphertext: logSlots / plus grande empreinte (au plus le
+    // nombre d'images demandé)
+    int needed_slots = *std::max_element(footprint.begin(), footprint.end());
+    if (needed_slots > num_slots) {
+        throw PresetMismatchError(std::string("réseau trop large pour ") + preset_name(preset_id) + 
+                                  " (" + std::to_string(needed_slots) + " slots requis)");
+    }
+    num_images = std::min(num_images, (int)data.images.size());
+    BatchPacker packer(log_slots, 784, needed_slots, num_images, order);
+    const int batch_size = packer.capacity();
+    const bool interleaved = packer.layout().interleavedOrder();
+    
+    // Layout vu par les couches: celui du packer (poids, masques et bias
+    // répliqués dans chaque bloc ou pour chaque image entrelacée), logits de
+    // fc3 à slot(image, t). L'argmax rapproche les blocs au besoin
+    const SlotLayout& layer_layout = packer.layout();
+    
+    // Slots utiles en entrée de chaque couche pour un lot
+    std::vector<int> live_slots(network.size());
+    for (size_t layer = 0; layer < network.size(); ++layer) {
+        live_slots[layer] = layer_layout.span(footprint[layer]);
+    }
+    
+    std::cout << "   └─ Images par ciphertext: " << batch_size << " ("
+              << (interleaved ? "entrelacées" : "stride " + std::to_string(packer.stride())) 
+              << ")" << std::endl;
+    
+    // Niveau d'un ciphertext frais
+    Message<Complex> msg_probe(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) msg_probe[i] = Complex(0.0, 0.0);
+    auto ptxt_probe = IPlaintext::make();
+    encoder.encode(msg_probe, *ptxt_probe);
+    auto ct_probe = ICiphertext::make();
+    decryptor.encrypt(*ptxt_probe, *sk, *ct_probe);
+    int initial_level = HomEval(preset_id).getLevel(*ct_probe);
+    
+    // Sans bootstrap, tout le réseau doit tenir dans les niveaux d'un ciphertext
+    // frais (plan sans bootstrap; plan_levels lève si une couche seule dépasse)
+    bool fits = with_bootstrap;
+    if (!with_bootstrap) {
+        try {
+            fits = plan_levels(network, initial_level, initial_level).num_bootstraps == 0;
+        } catch (const std::runtime_error&) {
+            fits = false;
+        }
+    }
+    if (!fits) {
+        throw PresetMismatchError(std::string("profondeur insuffisante sans bootstrap pour ") + 
+                                  preset_name(preset_id) + " (niveau initial " + 
+                                  std::to_string(initial_level) + ")");
+    }
     
     // ------------------------------------------------------------
-    // 2. Chargement des données MNIST et poids
+    // 3. Contexte FHE: évaluateur, clés d'évaluation + bootstrap (une seule fois)
     // ------------------------------------------------------------
-    std::cout << "\n2. Chargement des données..." << std::endl;
+    std::cout << "\n3. Préparation du contexte serveur..." << std::endl;
     
+    // Sous budget, les rotations sans clé sont composées de ±2^k (un key-switch par terme)
+    if (key_budget > 0) std::cout << "   └─ Budget de clés de rotation: " << key_budget << std::endl;
+    
+    std::unique_ptr<FheContext> ctx_ptr;
+    if (bundle) {
+        ctx_ptr = std::make_unique<FheContext>(bundle, key_budget);
+    } else {
+        ctx_ptr = std::make_unique<FheContext>(preset_id, *sk, with_bootstrap, key_budget);
+    }
+    FheContext& ctx = *ctx_ptr;
+    ServerContext& server = ctx.server();
+    HomEval& eval = ctx.eval();
+    RotationKeyStore& rot_keys = ctx.rotKeys();
+    if (ctx.hasBootstrap()) std::cout << "   └─ Bootstrap prêt" << std::endl;
+    
+    // ------------------------------------------------------------
+    // 3b. Plan de niveaux: placement des bootstraps + repli des scales
+    // ------------------------------------------------------------
+    std::cout << "\n3b. Plan de niveaux..." << std::endl;
+    
+    // Le bootstrap a besoin d'au moins 3 niveaux en entrée, après le masque
+    // de fusion; il rend un niveau de moins (masque de découpage).
+    // Un même bootstrap rafraîchit aussi la partie imaginaire (packing complexe)
+    // Un plan impossible (couche plus profonde que ce que rend le bootstrap)
+    // veut dire que le réseau ne tient pas dans ce preset
+    LevelPlan plan;
     try {
-        auto images = load_mnist_images("data/mnist/t10k-images-idx3-ubyte");
-        auto labels = load_mnist_labels("data/mnist/t10k-labels-idx1-ubyte");
-        
-        auto conv1_w = load_txt("data/weights/conv1.weight.txt");
-        auto conv1_b = load_txt("data/weights/conv1.bias.txt");
-        auto conv2_w = load_txt("data/weights/conv2.weight.txt");
-        auto conv2_b = load_txt("data/weights/conv2.bias.txt");
-        auto fc1_w = load_txt("data/weights/fc1.weight.txt");
-        auto fc1_b = load_txt("data/weights/fc1.bias.txt");
-        auto fc2_w = load_txt("data/weights/fc2.weight.txt");
-        auto fc2_b = load_txt("data/weights/fc2.bias.txt");
-        auto fc3_w = load_txt("data/weights/fc3.weight.txt");
-        auto fc3_b = load_txt("data/weights/fc3.bias.txt");
-        
-        std::cout << "   └─ Images: " << images.size() << std::endl;
-        std::cout << "   └─ Labels: " << labels.size() << std::endl;
-        std::cout << "   └─ Poids chargés: ✓" << std::endl;
-        
-        // ------------------------------------------------------------
-        // 3. Génération des clés de rotation
-        // ------------------------------------------------------------
-        std::cout << "\n3. Génération des clés de rotation..." << std::endl;
-        
-        std::map<int, Ptr<ISwKey>> rot_keys;
-        int max_rot = 900;  // Pour image 28×28 + décalages
-        generate_all_rot_keys(*sk, max_rot, rot_keys);
-        std::cout << "   └─ " << rot_keys.size() << " clés générées" << std::endl;
-        
-        // ------------------------------------------------------------
-        // 4. Préparation du bootstrapping (une seule fois)
-        // ------------------------------------------------------------
-        std::cout << "\n4. Préparation du bootstrapping..." << std::endl;
-        
-        std::cout << "   └─ Génération des clés de bootstrap..." << std::endl;
-        BootKeyPtrs bootkeys(preset_id, *sk);
-        Bootstrapper bootstrapper(preset_id, bootkeys);
-        std::cout << "   └─ Warmup..." << std::endl;
-        bootstrapper.warmup();
-        std::cout << "   └─ Bootstrap prêt" << std::endl;
-        
-        // ------------------------------------------------------------
-        // 5. Inférence par lots de 4 images
-        // ------------------------------------------------------------
-        std::cout << "\n" << std::string(50, '-') << std::endl;
-        std::cout << "5. INFÉRENCE HOMOMORPHE - 4 IMAGES PARALLÉLISÉES" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
-        
-        int num_images = std::min(40, (int)images.size());  // Multiple de 4
-        int num_batches = num_images / 4;
+        plan = ctx.hasBootstrap()
+            ? plan_levels(network, initial_level, ctx.bootstrap().outputLevel() - 1, 3, true, 1)
+            : plan_levels(network, initial_level, initial_level);
+    } catch (const std::runtime_error& e) {
+        throw PresetMismatchError(std::string(preset_name(preset_id)) + ": " + e.what());
+    }
+    print_plan(network, plan);
+    
+    // Poids avec les scales des ReLU repliés
+    auto conv1_w = scale_values(data.conv1_w, plan.weight_scale[CONV1]);
+    auto conv1_b = scale_values(data.conv1_b, plan.bias_scale[CONV1]);
+    auto conv2_w = scale_values(data.conv2_w, plan.weight_scale[CONV2]);
+    auto conv2_b = scale_values(data.conv2_b, plan.bias_scale[CONV2]);
+    auto fc1_w = scale_values(data.fc1_w, plan.weight_scale[FC1]);
+    auto fc1_b = scale_values(data.fc1_b, plan.bias_scale[FC1]);
+    auto fc2_w = scale_values(data.fc2_w, plan.weight_scale[FC2]);
+    auto fc2_b = scale_values(data.fc2_b, plan.bias_scale[FC2]);
+    auto fc3_w = scale_values(data.fc3_w, plan.weight_scale[FC3]);
+    auto fc3_b = scale_values(data.fc3_b, plan.bias_scale[FC3]);
+    
+    num_images = num_images / batch_size * batch_size;
+    int num_batches = num_images / batch_size;
+    if (num_batches == 0) {
+        throw std::runtime_error("aucune image à traiter");
+    }
+    
+    // ------------------------------------------------------------
+    // 3c. Fusion des lots: K lots partagent chaque bootstrap
+    // ------------------------------------------------------------
+    int num_cts = (num_batches + batches_per_ct - 1) / batches_per_ct;
+    int merge_k = num_cts;
+    for (size_t layer = 0; layer < network.size(); ++layer) {
+        if (plan.bootstrap_before[layer]) {
+            merge_k = std::min(merge_k, max_merge_count(live_slots[layer], log_slots));
+        }
+    }
+    
+    std::cout << "\n3c. Fusion: " << merge_k << " ciphertext(s) × " << batches_per_ct 
+              << " lot(s) par bootstrap" << std::endl;
+    
+    // ------------------------------------------------------------
+    // 4. Clés de rotation: exactement celles déclarées par les couches
+    // ------------------------------------------------------------
+    std::cout << "\n4. Génération des clés de rotation..." << std::endl;
+    
+    // Emplacement des données en entrée de chaque couche (pooling compacté:
+    // conv2 et fc1 lisent des tenseurs denses)
+    const TensorLayout conv1_in = TensorLayout::dense(1, 28, 28, layer_layout);
+    const TensorLayout pool1_in = conv2d_output_layout(conv1_in, 8, 5, log_slots);
+    const TensorLayout conv2_in = avgpool2d_output_layout(pool1_in);
+    const TensorLayout pool2_in = conv2d_output_layout(conv2_in, 16, 5, log_slots);
+    const TensorLayout logits_layout = TensorLayout::dense(10, 1, 1, layer_layout);
+    
+    std::vector<std::pair<std::string, std::vector<int>>> rot_requests = {
+        {"conv1", conv2d_rotation_shifts(conv1_in, 5)},
+        {"pool1", avgpool2d_rotation_shifts(pool1_in, log_slots)},
+        {"conv2", conv2d_rotation_shifts(conv2_in, 5)},
+        {"pool2", avgpool2d_rotation_shifts(pool2_in, log_slots)},
+        {"fc1", fc_rotation_shifts(128, layer_layout)},
+        {"fc2", fc_rotation_shifts(64, layer_layout)},
+        {"fc3", fc_rotation_shifts(10, layer_layout)},
+        {"onehot", argmax_rotation_shifts(10, layer_layout, log_slots)}
+    };
+    for (size_t layer = 0; layer < network.size(); ++layer) {
+        if (!plan.bootstrap_before[layer]) continue;
+        rot_requests.push_back({"boot " + network[layer].name,
+                                merge_rotation_shifts(merge_k, live_slots[layer], log_slots)});
+    }
+    
+    auto key_shifts = collect_rotation_shifts(rot_requests, log_slots);
+    
+    if (key_budget > 0) {
+        std::vector<int> demanded;
+        for (const auto& request : rot_requests) {
+            demanded.insert(demanded.end(), request.second.begin(), request.second.end());
+        }
+        key_shifts = select_rotation_keys(demanded, log_slots, key_budget);
+    }
+    
+    // Clés du paquet chargées avant le fork, les manquantes générées par le
+    // client; sous budget, les clés les moins utilisées sont évincées
+    if (bundle) {
+        std::vector<int> in_bundle;
+        for (int shift : key_shifts) {
+            if (bundle->hasRotKey(shift)) in_bundle.push_back(shift);
+        }
+        server.preload(in_bundle);
+    }
+    server.generateRotKeys(*sk, key_shifts);
+    
+    std::cout << "   └─ " << rot_keys.size() << " clés de rotation + clé de conjugaison" << std::endl;
+    
+    if (!bundle) {
+        mkdir(key_dir.c_str(), 0755);
+        write_secret_key(sk_path, preset_id, key_seed, *sk);
+        write_key_bundle(bundle_path, key_seed, server);
+    }
+    
+    // ------------------------------------------------------------
+    // 5. Inférence par lots de batch_size images
+    // ------------------------------------------------------------
+    std::cout << "\n" << std::string(50, '-') << std::endl;
+    std::cout << "5. INFÉRENCE HOMOMORPHE - " << batch_size << " IMAGES PAR LOT" << std::endl;
+    std::cout << std::string(50, '-') << std::endl;
+    
+    // Un groupe sur num_workers par worker; résultat: [corrects, bootstraps,
+    // nombre de lots, temps par lot..., (image, prédiction)...]
+    int group_step = merge_k * batches_per_ct;
+    
+    auto run_groups = [&](int worker) {
         int total_correct = 0;
         int bootstrap_count = 0;
         
         std::vector<double> batch_times;
+        std::vector<double> predictions;
         
-        for (int batch = 0; batch < num_batches; ++batch) {
-            std::cout << "\n--- BATCH " << batch+1 << "/" << num_batches 
-                      << " (images " << batch*4 << "-" << batch*4+3 << ") ---" << std::endl;
+        for (int group = worker * group_step; group < num_batches; group += num_workers * group_step) {
+            int group_size = std::min(group_step, num_batches - group);
+            
+            std::cout << "\n--- BATCHS " << group+1 << "-" << group+group_size << "/" << num_batches 
+                      << " (images " << group*batch_size << "-" << (group+group_size)*batch_size-1 << ") ---" << std::endl;
             
-            auto batch_start = std::chrono::high_resolution_clock::now();
+            auto group_start = std::chrono::high_resolution_clock::now();
             
             // --------------------------------------------------------
-            // 5a. Packer 4 images dans un seul ciphertext
+            // 5a. Packer batch_size images par lot, batches_per_ct lots par ciphertext
             // --------------------------------------------------------
-            std::vector<std::vector<double>> batch_images = {
-                images[batch*4 + 0],
-                images[batch*4 + 1],
-                images[batch*4 + 2],
-                images[batch*4 + 3]
-            };
+            std::vector<Message<Complex>> batch_msgs;
             
-            auto msg_packed = pack_4_images(batch_images, log_slots, Device::CPU);
+            for (int batch = group; batch < group + group_size; ++batch) {
+                std::vector<std::vector<double>> batch_images(
+                    data.images.begin() + batch * batch_size,
+                    data.images.begin() + (batch + 1) * batch_size
+                );
+                batch_msgs.push_back(packer.pack(batch_images));
+            }
             
-            auto ptxt_packed = IPlaintext::make();
-            encoder.encode(msg_packed, *ptxt_packed);
+            std::vector<CtTensor> xs;
+            
+            for (int b = 0; b < group_size; b += batches_per_ct) {
+                Message<Complex> msg_packed;
+                if (!complex_packing) {
+                    msg_packed = batch_msgs[b];
+                } else if (b + 1 < group_size) {
+                    msg_packed = pack_complex(batch_msgs[b], batch_msgs[b + 1]);
+                } else {
+                    // Dernier lot impair: partie imaginaire vide
+                    msg_packed = pack_complex(batch_msgs[b], msg_probe);
+                }
+                
+                auto ptxt_packed = IPlaintext::make();
+                encoder.encode(msg_packed, *ptxt_packed);
+                
+                auto ct = ICiphertext::make();
+                decryptor.encrypt(*ptxt_packed, *sk, *ct);
+                xs.emplace_back(std::move(ct), conv1_in);
+            }
             
-            auto ct = ICiphertext::make();
-            decryptor.encrypt(*ptxt_packed, *sk, *ct);
+            std::cout << "   └─ Niveau initial: " << xs[0].level(eval) << std::endl;
+            
+            // Bootstrap uniquement là où le plan l'a placé, un seul pour tout le groupe
+            auto bootstrap_if_planned = [&](int layer) {
+                if (!plan.bootstrap_before[layer]) return;
+                
+                std::vector<Ptr<ICiphertext>> cts;
+                for (auto& x : xs) {
+                    for (auto& ct : x.cts) cts.push_back(std::move(ct));
+                }
+                
+                std::cout << "   └─ ⚠️  BOOTSTRAP avant " << network[layer].name 
+                          << " (" << cts.size() << " lot(s), niveau " << eval.getLevel(*cts[0]) 
+                          << ")..." << std::endl;
+                
+                auto boot_start = std::chrono::high_resolution_clock::now();
+                bootstrap_merged(cts, live_slots[layer], log_slots, ctx.bootstrap(), rot_keys, eval,
+                                 ctx.encoder());
+                
+                size_t next = 0;
+                for (auto& x : xs) {
+                    for (auto& ct : x.cts) ct = std::move(cts[next++]);
+                }
+                auto boot_end = std::chrono::high_resolution_clock::now();
+                auto boot_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    boot_end - boot_start
+                );
+                
+                bootstrap_count++;
+                std::cout << "      └─ Niveau après: " << xs[0].level(eval) 
+                          << " (temps: " << boot_time.count() << " ms)" << std::endl;
+            };
             
-            std::cout << "   └─ Niveau initial: " << eval.getLevel(*ct) << std::endl;
+            // ReLU: séparer réel/imaginaire, activer chaque lot, recombiner
+            auto relu_all = [&](int layer) {
+                for (auto& x : xs) {
+                    if (!complex_packing) {
+                        x = homomorphic_relu(x, 5, plan.relu_scale[layer], ctx);
+                        continue;
+                    }
+                    for (auto& ct : x.cts) {
+                        auto parts = split_complex(*ct, server.conjKey(), eval);
+                        auto ct_re = homomorphic_relu(*parts.first, 5, plan.relu_scale[layer], ctx);
+                        auto ct_im = homomorphic_relu(*parts.second, 5, plan.relu_scale[layer], ctx);
+                        ct = combine_complex(*ct_re, *ct_im, eval);
+                    }
+                }
+            };
             
             // --------------------------------------------------------
             // 5b. CONV1 + RELU1 + POOL1
             // --------------------------------------------------------
+            bootstrap_if_planned(CONV1);
             std::cout << "   └─ Conv1..." << std::endl;
-            ct = homomorphic_conv2d(*ct, conv1_w, conv1_b, 
-                                   1, 28, 28, 8, 5, 24, 24,
-                                   *sk, rot_keys, *relin_key, eval);
+            for (auto& x : xs) {
+                x = homomorphic_conv2d(x, conv1_w, conv1_b, 8, 5, ctx, complex_packing);
+            }
             
+            bootstrap_if_planned(RELU1);
             std::cout << "   └─ ReLU1..." << std::endl;
-            ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+            relu_all(RELU1);
             
+            bootstrap_if_planned(POOL1);
             std::cout << "   └─ AvgPool1..." << std::endl;
-            ct = homomorphic_avgpool2d(*ct, 8, 24, 24, rot_keys, eval);
+            for (auto& x : xs) {
+                x = homomorphic_avgpool2d(x, ctx);
+            }
             
             // --------------------------------------------------------
-            // 5c. CONV2 + RELU2
+            // 5c. CONV2 + RELU2 + POOL2
             // --------------------------------------------------------
+            bootstrap_if_planned(CONV2);
             std::cout << "   └─ Conv2..." << std::endl;
-            ct = homomorphic_conv2d(*ct, conv2_w, conv2_b,
-                                   8, 12, 12, 16, 5, 8, 8,
-                                   *sk, rot_keys, *relin_key, eval);
+            for (auto& x : xs) {
+                x = homomorphic_conv2d(x, conv2_w, conv2_b, 16, 5, ctx, complex_packing);
+            }
             
+            bootstrap_if_planned(RELU2);
             std::cout << "   └─ ReLU2..." << std::endl;
-            ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+            relu_all(RELU2);
             
-            // --------------------------------------------------------
-            // 5d. BOOTSTRAP #1 - CRITIQUE
-            // --------------------------------------------------------
-            int level_before_bootstrap1 = eval.getLevel(*ct);
-            if (level_before_bootstrap1 <= 3) {
-                std::cout << "   └─ ⚠️  BOOTSTRAP #1 (niveau " 
-                          << level_before_bootstrap1 << ")..." << std::endl;
-                
-                auto boot_start = std::chrono::high_resolution_clock::now();
-                bootstrapper.bootstrap(*ct);
-                auto boot_end = std::chrono::high_resolution_clock::now();
-                auto boot_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    boot_end - boot_start
-                );
-                
-                bootstrap_count++;
-                std::cout << "      └─ Niveau après: " << eval.getLevel(*ct) 
-                          << " (temps: " << boot_time.count() << " ms)" << std::endl;
-            }
-            
-            // --------------------------------------------------------
-            // 5e. POOL2
-            // --------------------------------------------------------
+            bootstrap_if_planned(POOL2);
             std::cout << "   └─ AvgPool2..." << std::endl;
-            ct = homomorphic_avgpool2d(*ct, 16, 8, 8, rot_keys, eval);
+            for (auto& x : xs) {
+                x = homomorphic_avgpool2d(x, ctx);
+            }
             
             // --------------------------------------------------------
-            // 5f. FC1 + RELU3
+            // 5d. FC1 + RELU3
             // --------------------------------------------------------
+            bootstrap_if_planned(FC1);
             std::cout << "   └─ FC1 (256→128)..." << std::endl;
-            ct = homomorphic_fc(*ct, fc1_w, fc1_b, 256, 128, *sk, rot_keys, eval);
+            for (auto& x : xs) {
+                x = homomorphic_fc(x, fc1_w, fc1_b, 128, ctx, complex_packing);
+            }
             
+            bootstrap_if_planned(RELU3);
             std::cout << "   └─ ReLU3..." << std::endl;
-            ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+            relu_all(RELU3);
             
             // --------------------------------------------------------
-            // 5g. BOOTSTRAP #2 - CRITIQUE
-            // --------------------------------------------------------
-            int level_before_bootstrap2 = eval.getLevel(*ct);
-            if (level_before_bootstrap2 <= 3) {
-                std::cout << "   └─ ⚠️  BOOTSTRAP #2 (niveau " 
-                          << level_before_bootstrap2 << ")..." << std::endl;
-                
-                auto boot_start = std::chrono::high_resolution_clock::now();
-                bootstrapper.bootstrap(*ct);
-                auto boot_end = std::chrono::high_resolution_clock::now();
-                auto boot_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    boot_end - boot_start
-                );
-                
-                bootstrap_count++;
-                std::cout << "      └─ Niveau après: " << eval.getLevel(*ct) 
-                          << " (temps: " << boot_time.count() << " ms)" << std::endl;
-            }
-            
-            // --------------------------------------------------------
-            // 5h. FC2 + RELU4
+            // 5e. FC2 + RELU4
             // --------------------------------------------------------
+            bootstrap_if_planned(FC2);
             std::cout << "   └─ FC2 (128→64)..." << std::endl;
-            ct = homomorphic_fc(*ct, fc2_w, fc2_b, 128, 64, *sk, rot_keys, eval);
+            for (auto& x : xs) {
+                x = homomorphic_fc(x, fc2_w, fc2_b, 64, ctx, complex_packing);
+            }
             
+            bootstrap_if_planned(RELU4);
             std::cout << "   └─ ReLU4..." << std::endl;
-            ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+            relu_all(RELU4);
             
             // --------------------------------------------------------
-            // 5i. FC3 (64→10) - LOGITS
+            // 5f. FC3 (64→10) - LOGITS
             // --------------------------------------------------------
+            bootstrap_if_planned(FC3);
             std::cout << "   └─ FC3 (64→10)..." << std::endl;
-            auto ct_logits = homomorphic_fc(*ct, fc3_w, fc3_b, 64, 10, *sk, rot_keys, eval);
+            for (auto& x : xs) {
+                x = homomorphic_fc(x, fc3_w, fc3_b, 10, ctx, complex_packing);
+            }
             
             // --------------------------------------------------------
-            // 5j. BONUS: ONE-HOT VECTOR
+            // 5g. BONUS: ONE-HOT VECTOR
             // --------------------------------------------------------
+            bootstrap_if_planned(ONEHOT);
             std::cout << "   └─ 🔥 Conversion one-hot vector..." << std::endl;
-            auto ct_onehot = homomorphic_onehot(*ct_logits, *sk, rot_keys, eval, *relin_key);
             
-            // --------------------------------------------------------
-            // 5k. DÉCHIFFREMENT
-            // --------------------------------------------------------
-            std::cout << "   └─ Déchiffrement..." << std::endl;
-            
-            auto ptxt_onehot = IPlaintext::make();
-            decryptor.decrypt(*ct_onehot, *sk, *ptxt_onehot);
+            // Un ciphertext réel par lot, emplacement logits_layout
+            std::vector<CtTensor> logits;
+            for (auto& x : xs) {
+                if (!complex_packing) {
+                    logits.emplace_back(std::move(x.cts[0]), logits_layout);
+                    continue;
+                }
+                auto parts = split_complex(x.ct(), server.conjKey(), eval);
+                logits.emplace_back(std::move(parts.first), logits_layout);
+                if ((int)logits.size() < group_size) logits.emplace_back(std::move(parts.second), logits_layout);
+            }
             
-            Message<Complex> msg_onehot;
-            encoder.decode(*ptxt_onehot, msg_onehot);
-            msg_onehot.to(Device::CPU);
+            std::vector<CtTensor> onehots;
+            for (auto& x : logits) {
+                onehots.push_back(homomorphic_onehot(x, ctx));
+            }
             
             // --------------------------------------------------------
-            // 5l. PRÉDICTIONS POUR 4 IMAGES
+            // 5h. DÉCHIFFREMENT + PRÉDICTIONS (batch_size images par lot)
             // --------------------------------------------------------
-            int batch_correct = 0;
+            std::cout << "   └─ Déchiffrement..." << std::endl;
             
-            for (int i = 0; i < 4; ++i) {
-                // Index du début pour cette image
-                int start_idx = i * 10;
-                
-                // Trouver le maximum (valeur la plus proche de 1)
-                int pred = 0;
-                double max_val = msg_onehot[start_idx].real();
-                
-                for (int j = 1; j < 10; ++j) {
-                    double val = msg_onehot[start_idx + j].real();
-                    if (val > max_val) {
-                        max_val = val;
-                        pred = j;
-                    }
-                }
-                
-                int true_label = labels[batch*4 + i];
-                if (pred == true_label) batch_correct++;
+            int group_correct = 0;
+            
+            for (int g = 0; g < group_size; ++g) {
+                int batch = group + g;
                 
-                std::cout << "      Image " << std::setw(2) << batch*4 + i 
-                          << ": prédiction = " << pred 
-                          << ", vérité = " << true_label 
-                          << " → " << (pred == true_label ? "✅" : "❌") << std::endl;
+                // Scores au stride rendu par l'argmax (0: layout du packer)
+                const SlotLayout& score_slots = onehots[g].layout.slots;
+                int score_stride = score_slots.interleavedOrder() ? 0 : score_slots.stride;
+                auto scores = packer.unpack(onehots[g].ct(), *sk, encoder, decryptor, 
+                                            batch_size, 10, score_stride);
                 
-                // Debug: afficher le one-hot vector pour la première image du premier batch
-                if (batch == 0 && i == 0) {
-                    std::cout << "         One-hot: [";
-                    for (int j = 0; j < 10; ++j) {
-                        std::cout << std::fixed << std::setprecision(3) 
-                                  << msg_onehot[start_idx + j].real();
-                        if (j < 9) std::cout << ", ";
+                for (int i = 0; i < batch_size; ++i) {
+                    // Trouver le maximum (valeur la plus proche de 1)
+                    int pred = std::max_element(scores[i].begin(), scores[i].end()) - scores[i].begin();
+                    
+                    int true_label = data.labels[batch*batch_size + i];
+                    if (pred == true_label) group_correct++;
+                    predictions.push_back(batch*batch_size + i);
+                    predictions.push_back(pred);
+                    
+                    std::cout << "      Image " << std::setw(2) << batch*batch_size + i 
+                              << ": prédiction = " << pred 
+                              << ", vérité = " << true_label 
+                              << " → " << (pred == true_label ? "✅" : "❌") << std::endl;
+                    
+                    // Debug: afficher le one-hot vector pour la première image du premier batch
+                    if (batch == 0 && i == 0) {
+                        std::cout << "         One-hot: [";
+                        for (int j = 0; j < 10; ++j) {
+                            std::cout << std::fixed << std::setprecision(3) 
+                                      << scores[i][j];
+                            if (j < 9) std::cout << ", ";
+                        }
+                        std::cout << "]" << std::endl;
                     }
-                    std::cout << "]" << std::endl;
                 }
             }
             
-            total_correct += batch_correct;
+            total_correct += group_correct;
             
-            auto batch_end = std::chrono::high_resolution_clock::now();
-            auto batch_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                batch_end - batch_start
+            auto group_end = std::chrono::high_resolution_clock::now();
+            auto group_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                group_end - group_start
             );
-            batch_times.push_back(batch_duration.count());
             
-            std::cout << "   └─ Batch terminé: " << batch_correct << "/4 corrects, "
-                      << "temps: " << batch_duration.count() << " ms" << std::endl;
+            // Temps amorti: le groupe se partage les bootstraps
+            for (int g = 0; g < group_size; ++g) {
+                batch_times.push_back((double)group_duration.count() / group_size);
+            }
+            
+            std::cout << "   └─ Groupe terminé: " << group_correct << "/" << batch_size * group_size 
+                      << " corrects, temps: " << group_duration.count() << " ms" << std::endl;
+        }
+        
+        std::vector<double> result = {(double)total_correct, (double)bootstrap_count, (double)batch_times.size()};
+        result.insert(result.end(), batch_times.begin(), batch_times.end());
+        result.insert(result.end(), predictions.begin(), predictions.end());
+        return result;
+    };
+    
+    std::vector<std::vector<double>> worker_results;
+    if (num_workers > 1) {
+        std::cout << "   └─ " << num_workers << " workers forkés (clés partagées)" << std::endl;
+        worker_results = run_workers(num_workers, run_groups);
+    } else {
+        worker_results.push_back(run_groups(0));
+    }
+    
+    int total_correct = 0;
+    int bootstrap_count = 0;
+    std::vector<double> batch_times;
+    std::vector<int> predictions(num_images, -1);
+    
+    for (const auto& result : worker_results) {
+        total_correct += (int)result[0];
+        bootstrap_count += (int)result[1];
+        auto times_end = result.begin() + 3 + (int)result[2];
+        batch_times.insert(batch_times.end(), result.begin() + 3, times_end);
+        for (auto it = times_end; it + 1 < result.end(); it += 2) {
+            predictions[(int)it[0]] = (int)it[1];
+        }
+    }
+    
+    // ------------------------------------------------------------
+    // 6. Bilan du preset
+    // ------------------------------------------------------------
+    auto run_end = std::chrono::high_resolution_clock::now();
+    
+    double sum_times = 0;
+    for (double t : batch_times) sum_times += t;
+    
+    RunResult result;
+    result.log_slots = log_slots;
+    result.batch_size = batch_size;
+    result.order = order;
+    result.num_images = num_images;
+    result.correct = total_correct;
+    result.bootstraps = bootstrap_count;
+    result.image_ms = batch_times.empty() ? 0.0 : sum_times / batch_times.size() / batch_size;
+    result.total_s = std::chrono::duration<double>(run_end - run_start).count();
+    result.predictions = std::move(predictions);
+    
+    std::cout << "\n📈 PERFORMANCES (" << preset_name(preset_id) << ", " 
+              << (interleaved ? "entrelacé" : "blocs") << "):" << std::endl;
+    std::cout << "   └─ Images testées: " << num_images << std::endl;
+    std::cout << "   └─ Lots de " << batch_size << " images: " << num_batches << std::endl;
+    std::cout << "   └─ Prédictions correctes: " << total_correct << std::endl;
+    std::cout << "   └─ Accuracy: " << std::fixed << std::setprecision(2) 
+              << 100.0 * total_correct / num_images << "%" << std::endl;
+    std::cout << "   └─ Nombre de bootstraps: " << bootstrap_count << std::endl;
+    std::cout << "   └─ ";
+    rot_keys.printStats();
+    std::cout << "   └─ ";
+    PlaintextCache::global().printStats();
+    
+    std::cout << "\n⏱️  TEMPS D'EXÉCUTION:" << std::endl;
+    std::cout << "   └─ Temps total (clés + inférence): " << std::fixed << std::setprecision(1) 
+              << result.total_s << " s" << std::endl;
+    std::cout << "   └─ Temps moyen par BATCH (" << batch_size << " images): " 
+              << std::fixed << std::setprecision(0) << batch_size * result.image_ms << " ms" << std::endl;
+    std::cout << "   └─ Temps moyen par IMAGE: " 
+              << std::fixed << std::setprecision(0) << result.image_ms << " ms" << std::endl;
+    
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "🚀 FHE CNN MNIST - Projet 5CS09 - VERSION FINALE" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    std::cout << "   ✅ CNN 5 couches homomorphe" << std::endl;
+    std::cout << "   ✅ N images par ciphertext (selon logSlots)" << std::endl;
+    std::cout << "   ✅ One-hot vector (BONUS)" << std::endl;
+    std::cout << std::string(60, '=') << "\n" << std::endl;
+    
+    // Usage: main_fin [preset] [nb_images] [block|interleaved]
+    //    ou  main_fin --sweep [nb_images]   (chaque preset, les deux layouts)
+    // Environnement: FHE_WORKERS=N  workers forkés après chargement des clés
+    //                              (pages partagées, défaut 1: pas de fork)
+    //                FHE_KEY_BUDGET=N  clés de rotation résidentes max
+    //                              (défaut 0: une clé par rotation déclarée)
+    bool sweep = argc > 1 && std::string(argv[1]) == "--sweep";
+    
+    try {
+        auto preset_id = PresetParamsId::F16Opt_Gr;
+        if (argc > 1 && !sweep) preset_id = parse_preset(argv[1]);
+        int num_images = argc > 2 ? std::stoi(argv[2]) : (sweep ? 8 : 40);
+        int num_workers = env_setting("FHE_WORKERS", 1, 1);
+        int key_budget = env_setting("FHE_KEY_BUDGET", 0, 0);
+        
+        auto order = BatchOrder::Block;
+        if (argc > 3) {
+            std::string name = argv[3];
+            if (name == "interleaved") {
+                order = BatchOrder::Interleaved;
+            } else if (name != "block") {
+                throw std::runtime_error("Layout inconnu: " + name + " (connus: block, interleaved)");
+            }
         }
         
         // ------------------------------------------------------------
-        // 6. RÉSULTATS FINAUX
+        // 1. Chargement des données MNIST et poids
         // ------------------------------------------------------------
-        auto program_end = std::chrono::high_resolution_clock::now();
-        auto total_time = std::chrono::duration_cast<std::chrono::seconds>(
-            program_end - program_start
-        );
+        std::cout << "1. Chargement des données..." << std::endl;
         
-        // Calcul des statistiques
-        double sum_times = 0;
-        for (double t : batch_times) sum_times += t;
-        double avg_batch_time = sum_times / batch_times.size();
-        double avg_image_time = avg_batch_time / 4.0;
+        MnistData data;
+        data.images = load_mnist_images("data/mnist/t10k-images-idx3-ubyte");
+        data.labels = load_mnist_labels("data/mnist/t10k-labels-idx1-ubyte");
         
-        double accuracy = 100.0 * total_correct / num_images;
+        data.conv1_w = load_txt("data/weights/conv1.weight.txt");
+        data.conv1_b = load_txt("data/weights/conv1.bias.txt");
+        data.conv2_w = load_txt("data/weights/conv2.weight.txt");
+        data.conv2_b = load_txt("data/weights/conv2.bias.txt");
+        data.fc1_w = load_txt("data/weights/fc1.weight.txt");
+        data.fc1_b = load_txt("data/weights/fc1.bias.txt");
+        data.fc2_w = load_txt("data/weights/fc2.weight.txt");
+        data.fc2_b = load_txt("data/weights/fc2.bias.txt");
+        data.fc3_w = load_txt("data/weights/fc3.weight.txt");
+        data.fc3_b = load_txt("data/weights/fc3.bias.txt");
         
-        std::cout << "\n" << std::string(60, '=') << std::endl;
-        std::cout << "📊 RÉSULTATS FINAUX - PROJET 5CS09" << std::endl;
-        std::cout << std::string(60, '=') << std::endl;
+        std::cout << "   └─ Images: " << data.images.size() << std::endl;
+        std::cout << "   └─ Labels: " << data.labels.size() << std::endl;
+        std::cout << "   └─ Poids chargés: ✓" << std::endl;
         
-        std::cout << "\n📈 PERFORMANCES:" << std::endl;
-        std::cout << "   └─ Images testées: " << num_images << std::endl;
-        std::cout << "   └─ Lots de 4 images: " << num_batches << std::endl;
-        std::cout << "   └─ Prédictions correctes: " << total_correct << std::endl;
-        std::cout << "   └─ Accuracy: " << std::fixed << std::setprecision(2) 
-                  << accuracy << "%" << std::endl;
-        std::cout << "   └─ Nombre de bootstraps: " << bootstrap_count << std::endl;
+        if (!sweep) {
+            run_preset(preset_id, data, num_images, order, num_workers, key_budget);
+            
+            std::cout << "\n✅ OBLIGATIONS DU PROJET:" << std::endl;
+            std::cout << "   └─ [✓] CNN 5 couches homomorphe" << std::endl;
+            std::cout << "   └─ [✓] Mesure temps moyen et accuracy" << std::endl;
+            std::cout << "   └─ [✓] Images parallélisées (lots de N)" << std::endl;
+            std::cout << "   └─ [⭐] BONUS: One-hot vector" << std::endl;
+            
+            std::cout << "\n" << std::string(60, '=') << std::endl;
+            std::cout << "🏆 PROJET COMPLÉTÉ AVEC SUCCÈS!" << std::endl;
+            std::cout << std::string(60, '=') << "\n" << std::endl;
+            return 0;
+        }
         
-        std::cout << "\n⏱️  TEMPS D'EXÉCUTION:" << std::endl;
-        std::cout << "   └─ Temps total: " << total_time.count() << " s" << std::endl;
-        std::cout << "   └─ Temps moyen par BATCH (4 images): " 
-                  << std::fixed << std::setprecision(0) << avg_batch_time << " ms" << std::endl;
-        std::cout << "   └─ Temps moyen par IMAGE: " 
-                  << std::fixed << std::setprecision(0) << avg_image_time << " ms" << std::endl;
+        // ------------------------------------------------------------
+        // Sweep: même réseau sur chaque preset qui le contient,
+        // packing en blocs puis entrelacé. Accord: part des images où les
+        // deux layouts d'un preset prédisent la même classe (un layout qui
+        // perd des images ne se compare pas en ms/image)
+        // ------------------------------------------------------------
+        std::vector<std::pair<const PresetInfo*, RunResult>> results;
+        std::vector<std::pair<const PresetInfo*, std::string>> skipped;
         
-        std::cout << "\n✅ OBLIGATIONS DU PROJET:" << std::endl;
-        std::cout << "   └─ [✓] CNN 5 couches homomorphe" << std::endl;
-        std::cout << "   └─ [✓] Mesure temps moyen et accuracy" << std::endl;
-        std::cout << "   └─ [✓] 4 images parallélisées" << std::endl;
-        std::cout << "   └─ [⭐] BONUS: One-hot vector" << std::endl;
+        for (const auto& preset : known_presets()) {
+            for (auto sweep_order : {BatchOrder::Block, BatchOrder::Interleaved}) {
+                std::cout << "\n" << std::string(60, '=') << std::endl;
+                std::cout << "🔁 SWEEP: preset " << preset.name << ", layout " 
+                          << (sweep_order == BatchOrder::Interleaved ? "entrelacé" : "blocs") << std::endl;
+                std::cout << std::string(60, '=') << std::endl;
+                
+                // Plaintexts propres au preset et au layout du run précédent: les libérer
+                PlaintextCache::global().clear();
+                
+                try {
+                    results.push_back({&preset, run_preset(preset.id, data, num_images, sweep_order, num_workers, key_budget)});
+                } catch (const PresetMismatchError& e) {
+                    std::cout << "   └─ ⏭️  Ignoré: " << e.what() << std::endl;
+                    skipped.push_back({&preset, e.what()});
+                    break;
+                }
+            }
+        }
         
         std::cout << "\n" << std::string(60, '=') << std::endl;
-        std::cout << "🏆 PROJET COMPLÉTÉ AVEC SUCCÈS!" << std::endl;
-        std::cout << std::string(60, '=') << "\n" << std::endl;
+        std::cout << "📊 SWEEP DES PRESETS (" << num_images << " images)" << std::endl;
+        std::cout << std::string(60, '=') << std::endl;
+        std::cout << std::left << std::setw(12) << "Preset" << std::setw(12) << "Layout" << std::right 
+                  << std::setw(9) << "logSlots" << std::setw(8) << "Img/ct" << std::setw(8) << "Boot" 
+                  << std::setw(14) << "ms/image" << std::setw(12) << "Accuracy" 
+                  << std::setw(10) << "Total" << std::setw(9) << "Accord" << std::endl;
+        
+        for (const auto& entry : results) {
+            const RunResult& r = entry.second;
+            
+            // Même preset, autre layout
+            const RunResult* other = nullptr;
+            for (const auto& candidate : results) {
+                if (candidate.first == entry.first && candidate.second.order != r.order) other = &candidate.second;
+            }
+            std::string agreement = "-";
+            if (other && other->num_images == r.num_images) {
+                int same = 0;
+                for (int i = 0; i < r.num_images; ++i) {
+                    if (r.predictions[i] >= 0 && r.predictions[i] == other->predictions[i]) same++;
+                }
+                std::ostringstream ss;
+                ss << std::fixed << std::setprecision(0) << 100.0 * same / r.num_images << "%";
+                agreement = ss.str();
+            }
+            
+            std::cout << std::left << std::setw(12) << entry.first->name 
+                      << std::setw(12) << (r.order == BatchOrder::Interleaved ? "interleaved" : "block") << std::right 
+                      << std::setw(9) << r.log_slots << std::setw(8) << r.batch_size << std::setw(8) << r.bootstraps 
+                      << std::setw(14) << std::fixed << std::setprecision(0) << r.image_ms 
+                      << std::setw(11) << std::setprecision(2) << 100.0 * r.correct / r.num_images << "%" 
+                      << std::setw(9) << std::setprecision(1) << r.total_s << "s" 
+                      << std::setw(9) << agreement << std::endl;
+        }
+        for (const auto& entry : skipped) {
+            std::cout << std::left << std::setw(12) << entry.first->name << std::right 
+                      << "  ne tient pas: " << entry.second << std::endl;
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "\n❌ ERREUR FATALE: " << e.what() << std::endl;
@@ -356,4 +833,4 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
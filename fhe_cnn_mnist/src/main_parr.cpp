@@ -3,6 +3,11 @@
 #include "fhe_cnn/pooling.hpp"
 #include "fhe_cnn/relu.hpp"
 #include "fhe_cnn/bootstrapping.hpp"
+#include "fhe_cnn/fhe_context.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
+#include "fhe_cnn/presets.hpp"
+#include "fhe_cnn/batch_packer.hpp"
+#include "fhe_cnn/planner.hpp"
 #include "fhe_cnn/utils.hpp"
 #include <iostream>
 #include <chrono>
@@ -12,8 +17,8 @@
 using namespace heaan;
 using namespace fhe_cnn;
 
-int main() {
-    std::cout << "\n🚀 FHE CNN MNIST - PARALLÉLISATION 4 IMAGES" << std::endl;
+int main(int argc, char** argv) {
+    std::cout << "\n🚀 FHE CNN MNIST - PARALLÉLISATION N IMAGES" << std::endl;
     std::cout << "===========================================" << std::endl;
     
     auto program_start = std::chrono::high_resolution_clock::now();
@@ -23,16 +28,15 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n1. Initialisation HEAAN2..." << std::endl;
     
-    auto preset_id = PresetParamsId::F16Opt_Gr;
+    // Preset en argument (défaut F16Opt_Gr), voir known_presets()
+    auto preset_id = argc > 1 ? parse_preset(argv[1]) : PresetParamsId::F16Opt_Gr;
+    std::cout << "    Preset: " << preset_name(preset_id) << std::endl;
     
     SKGenerator skgen(preset_id);
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
-    
-    HomEval eval(preset_id);
+    // Encodage/chiffrement côté client
     EnDecoder encoder(preset_id);
     EnDecryptor decryptor(preset_id);
     
@@ -60,47 +64,108 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n3. Génération des clés de rotation..." << std::endl;
     
-    std::map<int, Ptr<ISwKey>> rot_keys;
+    int log_slots = sk->logDegree() - 1;
+    
+    // Contexte FHE côté serveur (la clé secrète reste au client)
+    FheContext ctx(preset_id, *sk, preset_has_bootstrap(preset_id));
     int max_rot = 900;
-    generate_all_rot_keys(*sk, max_rot, rot_keys);
+    generate_all_rot_keys(ctx.server(), *sk, max_rot);
+    
+    HomEval& eval = ctx.eval();
     
     // ------------------------------------------------------------
     // 4. Préparation du bootstrapping
     // ------------------------------------------------------------
     std::cout << "\n4. Préparation du bootstrapping..." << std::endl;
     
-    BootKeyPtrs bootkeys(preset_id, *sk);
-    Bootstrapper bootstrapper(preset_id, bootkeys);
-    bootstrapper.warmup();
+    // Preset sans bootstrap: plan sans bootstrap, le réseau doit tenir
+    BootstrapContext* boot_ctx = ctx.hasBootstrap() ? &ctx.bootstrap() : nullptr;
+    if (!boot_ctx) std::cout << "    Aucun (preset sans bootstrap)" << std::endl;
+    
+    // ------------------------------------------------------------
+    // 4b. Plan de niveaux
+    // ------------------------------------------------------------
+    enum { CONV1, RELU1, POOL1, CONV2, RELU2, POOL2, FC1, RELU3, FC2, RELU4, FC3 };
+    std::vector<LayerSpec> network = {
+        {"conv1", LayerKind::Conv2d},
+        {"relu1", LayerKind::ReLU, 5, 2.0},
+        {"pool1", LayerKind::AvgPool},
+        {"conv2", LayerKind::Conv2d},
+        {"relu2", LayerKind::ReLU, 5, 2.0},
+        {"pool2", LayerKind::AvgPool},
+        {"fc1", LayerKind::FC},
+        {"relu3", LayerKind::ReLU, 5, 2.0},
+        {"fc2", LayerKind::FC},
+        {"relu4", LayerKind::ReLU, 5, 2.0},
+        {"fc3", LayerKind::FC}
+    };
+    
+    Message<Complex> msg_probe(log_slots, Device::CPU);
+    for (int i = 0; i < (1 << log_slots); ++i) msg_probe[i] = Complex(0.0, 0.0);
+    auto ptxt_probe = IPlaintext::make();
+    encoder.encode(msg_probe, *ptxt_probe);
+    auto ct_probe = ICiphertext::make();
+    decryptor.encrypt(*ptxt_probe, *sk, *ct_probe);
+    
+    // Le bootstrap a besoin d'au moins 3 niveaux en entrée. Sans bootstrap,
+    // un plan qui en placerait un (ou une couche trop profonde) ne tient pas
+    int initial_level = eval.getLevel(*ct_probe);
+    LevelPlan plan;
+    try {
+        plan = boot_ctx
+            ? plan_levels(network, initial_level, boot_ctx->outputLevel(), 3)
+            : plan_levels(network, initial_level, initial_level);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "\n❌ Réseau trop profond pour " << preset_name(preset_id) << ": " << e.what() << std::endl;
+        return 1;
+    }
+    if (!boot_ctx && plan.num_bootstraps > 0) {
+        std::cerr << "\n❌ Profondeur insuffisante sans bootstrap pour " << preset_name(preset_id) 
+                  << " (niveau initial " << initial_level << ")" << std::endl;
+        return 1;
+    }
+    print_plan(network, plan);
+    
+    conv1_w = scale_values(conv1_w, plan.weight_scale[CONV1]);
+    conv1_b = scale_values(conv1_b, plan.bias_scale[CONV1]);
+    conv2_w = scale_values(conv2_w, plan.weight_scale[CONV2]);
+    conv2_b = scale_values(conv2_b, plan.bias_scale[CONV2]);
+    fc1_w = scale_values(fc1_w, plan.weight_scale[FC1]);
+    fc1_b = scale_values(fc1_b, plan.bias_scale[FC1]);
+    fc2_w = scale_values(fc2_w, plan.weight_scale[FC2]);
+    fc2_b = scale_values(fc2_b, plan.bias_scale[FC2]);
+    fc3_w = scale_values(fc3_w, plan.weight_scale[FC3]);
+    fc3_b = scale_values(fc3_b, plan.bias_scale[FC3]);
     
     // ------------------------------------------------------------
-    // 5. Inférence par lots de 4 images
+    // 5. Inférence par lots (images par ciphertext selon logSlots)
     // ------------------------------------------------------------
-    std::cout << "\n5. Inférence par lots de 4 images..." << std::endl;
+    // Plus grande empreinte d'une image: sortie de conv1 (8×24×24)
+    BatchPacker packer(log_slots, 784, 8 * 24 * 24);
+    const int batch_size = packer.capacity();
     
-    int num_images = std::min(40, (int)images.size());  // Multiple de 4
-    int num_batches = num_images / 4;
+    std::cout << "\n5. Inférence par lots de " << batch_size << " images..." << std::endl;
+    
+    int num_images = std::min(40, (int)images.size()) / batch_size * batch_size;
+    int num_batches = num_images / batch_size;
     int total_correct = 0;
     int bootstrap_count = 0;
     
     for (int batch = 0; batch < num_batches; ++batch) {
         std::cout << "\n--- Batch " << batch+1 << "/" << num_batches 
-                  << " (images " << batch*4 << "-" << batch*4+3 << ") ---" << std::endl;
+                  << " (images " << batch*batch_size << "-" << (batch+1)*batch_size-1 << ") ---" << std::endl;
         
         auto batch_start = std::chrono::high_resolution_clock::now();
         
         // --------------------------------------------------------
-        // Packer 4 images
+        // Packer batch_size images
         // --------------------------------------------------------
-        std::vector<std::vector<double>> batch_images = {
-            images[batch*4 + 0],
-            images[batch*4 + 1],
-            images[batch*4 + 2],
-            images[batch*4 + 3]
-        };
+        std::vector<std::vector<double>> batch_images(
+            images.begin() + batch * batch_size,
+            images.begin() + (batch + 1) * batch_size
+        );
         
-        int log_slots = sk->logDegree() - 1;
-        auto msg_packed = pack_4_images(batch_images, log_slots, Device::CPU);
+        auto msg_packed = packer.pack(batch_images);
         
         auto ptxt_packed = IPlaintext::make();
         encoder.encode(msg_packed, *ptxt_packed);
@@ -108,68 +173,75 @@ int main() {
         auto ct = ICiphertext::make();
         decryptor.encrypt(*ptxt_packed, *sk, *ct);
         
-        std::cout << "    Niveau initial: " << eval.getLevel(*ct) << std::endl;
+        // Couches au layout du packer: poids, masques et bias répliqués dans chaque bloc
+        CtTensor x(std::move(ct), TensorLayout::dense(1, 28, 28, packer.layout()));
+        std::cout << "    Niveau initial: " << x.level(eval) << std::endl;
         
         // --------------------------------------------------------
         // FORWARD PASS - IDENTIQUE MAIS TOUT EST PARALLÉLISÉ !
+        // Bootstraps placés par le plan de niveaux
         // --------------------------------------------------------
+        auto bootstrap_if_planned = [&](int layer) {
+            if (!plan.bootstrap_before[layer]) return;
+            std::cout << "    ⚠️  Bootstrap avant " << network[layer].name << "..." << std::endl;
+            boot_ctx->bootstrap(x.ct());
+            bootstrap_count++;
+        };
         
         // Conv1
-        ct = homomorphic_conv2d(*ct, conv1_w, conv1_b, 1, 28, 28, 8, 5, 24, 24,
-                               *sk, rot_keys, *relin_key, eval);
+        bootstrap_if_planned(CONV1);
+        x = homomorphic_conv2d(x, conv1_w, conv1_b, 8, 5, ctx);
         
         // ReLU1
-        ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+        bootstrap_if_planned(RELU1);
+        x = homomorphic_relu(x, 5, plan.relu_scale[RELU1], ctx);
         
         // Pool1
-        ct = homomorphic_avgpool2d(*ct, 8, 24, 24, rot_keys, eval);
+        bootstrap_if_planned(POOL1);
+        x = homomorphic_avgpool2d(x, ctx);
         
         // Conv2
-        ct = homomorphic_conv2d(*ct, conv2_w, conv2_b, 8, 12, 12, 16, 5, 8, 8,
-                               *sk, rot_keys, *relin_key, eval);
+        bootstrap_if_planned(CONV2);
+        x = homomorphic_conv2d(x, conv2_w, conv2_b, 16, 5, ctx);
         
         // ReLU2
-        ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
-        
-        // BOOTSTRAP #1
-        if (eval.getLevel(*ct) <= 3) {
-            std::cout << "    ⚠️  Bootstrap #1..." << std::endl;
-            bootstrapper.bootstrap(*ct);
-            bootstrap_count++;
-        }
+        bootstrap_if_planned(RELU2);
+        x = homomorphic_relu(x, 5, plan.relu_scale[RELU2], ctx);
         
         // Pool2
-        ct = homomorphic_avgpool2d(*ct, 16, 8, 8, rot_keys, eval);
+        bootstrap_if_planned(POOL2);
+        x = homomorphic_avgpool2d(x, ctx);
         
         // FC1
-        ct = homomorphic_fc(*ct, fc1_w, fc1_b, 256, 128, *sk, rot_keys, eval);
+        bootstrap_if_planned(FC1);
+        x = homomorphic_fc(x, fc1_w, fc1_b, 128, ctx);
         
         // ReLU3
-        ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
-        
-        // BOOTSTRAP #2
-        if (eval.getLevel(*ct) <= 3) {
-            std::cout << "    ⚠️  Bootstrap #2..." << std::endl;
-            bootstrapper.bootstrap(*ct);
-            bootstrap_count++;
-        }
+        bootstrap_if_planned(RELU3);
+        x = homomorphic_relu(x, 5, plan.relu_scale[RELU3], ctx);
         
         // FC2
-        ct = homomorphic_fc(*ct, fc2_w, fc2_b, 128, 64, *sk, rot_keys, eval);
+        bootstrap_if_planned(FC2);
+        x = homomorphic_fc(x, fc2_w, fc2_b, 64, ctx);
         
         // ReLU4
-        ct = homomorphic_relu(*ct, 5, 2.0, eval, *relin_key);
+        bootstrap_if_planned(RELU4);
+        x = homomorphic_relu(x, 5, plan.relu_scale[RELU4], ctx);
         
         // FC3 - Sortie 10 classes
-        auto ct_logits = homomorphic_fc(*ct, fc3_w, fc3_b, 64, 10, *sk, rot_keys, eval);
+        bootstrap_if_planned(FC3);
+        auto logits = homomorphic_fc(x, fc3_w, fc3_b, 10, ctx);
         
         // --------------------------------------------------------
-        // Déchiffrement et prédictions pour 4 images
+        // Déchiffrement et prédictions pour batch_size images (logits au
+        // stride de leur layout, 0: layout du packer)
         // --------------------------------------------------------
-        auto results = unpack_4_results(*ct_logits, *sk, encoder, decryptor, 10);
+        const SlotLayout& logit_slots = logits.layout.slots;
+        int logit_stride = logit_slots.interleavedOrder() ? 0 : logit_slots.stride;
+        auto results = packer.unpack(logits.ct(), *sk, encoder, decryptor, batch_size, 10, logit_stride);
         
         int batch_correct = 0;
-        for (int i = 0; i < 4; ++i) {
+        for (int i = 0; i < batch_size; ++i) {
             // Argmax
             int pred = 0;
             double max_val = results[i][0];
@@ -180,10 +252,10 @@ int main() {
                 }
             }
             
-            int true_label = labels[batch*4 + i];
+            int true_label = labels[batch*batch_size + i];
             if (pred == true_label) batch_correct++;
             
-            std::cout << "      Image " << batch*4 + i 
+            std::cout << "      Image " << batch*batch_size + i 
                       << ": prédiction " << pred 
                       << ", vérité " << true_label 
                       << " -> " << (pred == true_label ? "✅" : "❌") << std::endl;
@@ -196,7 +268,7 @@ int main() {
             batch_end - batch_start
         );
         
-        std::cout << "    Batch terminé: " << batch_correct << "/4 corrects, "
+        std::cout << "    Batch terminé: " << batch_correct << "/" << batch_size << " corrects, "
                   << "temps: " << batch_duration.count() << " ms" << std::endl;
     }
     
@@ -206,7 +278,7 @@ int main() {
         (program_end - program_start) / num_images
     );
     
-    std::cout << "\n=== RÉSULTATS FINAUX (4 images parallélisées) ===" << std::endl;
+    std::cout << "\n=== RÉSULTATS FINAUX (" << batch_size << " images parallélisées) ===" << std::endl;
     std::cout << "  Images testées: " << num_images << std::endl;
     std::cout << "  Prédictions correctes: " << total_correct << std::endl;
     std::cout << "  Accuracy: " << std::fixed << std::setprecision(2) 
@@ -214,9 +286,9 @@ int main() {
     std::cout << "  Nombre de bootstraps: " << bootstrap_count << std::endl;
     std::cout << "  Temps total: " << total_time.count() << " s" << std::endl;
     std::cout << "  Temps moyen par IMAGE: " << avg_time_per_image.count() << " ms" << std::endl;
-    std::cout << "  Temps moyen par BATCH (4 images): " 
+    std::cout << "  Temps moyen par BATCH (" << batch_size << " images): " 
               << total_time.count() * 1000.0 / num_batches << " ms" << std::endl;
-    std::cout << "  Gain de parallélisation: 4x 🚀" << std::endl;
+    std::cout << "  Gain de parallélisation: " << batch_size << "x 🚀" << std::endl;
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "fhe_cnn/batch_packer.hpp"
+#include <iostream>
+#include <algorithm>
+#include <string>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+BatchPacker::BatchPacker(int log_slots, int image_size, int footprint, int max_images,
+                         BatchOrder order)
+    : log_slots_(log_slots),
+      image_size_(image_size),
+      stride_(std::max(image_size, footprint)),
+      capacity_((1 << log_slots) / std::max(image_size, footprint))
+{
+    if (capacity_ == 0) {
+        throw std::runtime_error("BatchPacker: une image (" + std::to_string(stride_) +
+                                 " slots) ne tient pas dans " + std::to_string(1 << log_slots) + " slots");
+    }
+    if (max_images > 0) capacity_ = std::min(capacity_, max_images);
+    
+    layout_ = order == BatchOrder::Interleaved
+        ? SlotLayout::interleaved(capacity_)
+        : SlotLayout::block(capacity_, stride_);
+}
+
+Message<Complex> BatchPacker::pack(
+    const std::vector<std::vector<double>>& images,
+    Device device
+) const {
+    if ((int)images.size() > capacity_) {
+        throw std::runtime_error("BatchPacker::pack: " + std::to_string(images.size()) +
+                                 " images pour une capacité de " + std::to_string(capacity_));
+    }
+    
+    int num_slots = 1 << log_slots_;
+    Message<Complex> msg(log_slots_, device);
+    for (int i = 0; i < num_slots; ++i) msg[i] = Complex(0.0, 0.0);
+    
+    for (int k = 0; k < (int)images.size(); ++k) {
+        int n = std::min(image_size_, (int)images[k].size());
+        for (int i = 0; i < n; ++i) {
+            msg[layout_.slot(k, i)] = Complex(images[k][i], 0.0);
+        }
+    }
+    
+    std::cout << "    📦 " << images.size() << " images packées ("
+              << (layout_.interleavedOrder() ? "entrelacées" : "stride " + std::to_string(stride_))
+              << ", " << images.size() * image_size_ << " slots utilisés)" << std::endl;
+    
+    return msg;
+}
+
+std::vector<std::vector<double>> BatchPacker::unpack(
+    const Message<Complex>& msg,
+    int count,
+    int output_size,
+    int output_stride
+) const {
+    SlotLayout layout = output_stride == 0 ? layout_ : SlotLayout::block(capacity_, output_stride);
+    
+    std::vector<std::vector<double>> results(count, std::vector<double>(output_size));
+    for (int k = 0; k < count; ++k) {
+        for (int i = 0; i < output_size; ++i) {
+            results[k][i] = msg[layout.slot(k, i)].real();
+        }
+    }
+    return results;
+}
+
+std::vector<std::vector<double>> BatchPacker::unpack(
+    const ICiphertext& ctxt,
+    const ISecretKey& sk,
+    EnDecoder& encoder,
+    EnDecryptor& decryptor,
+    int count,
+    int output_size,
+    int output_stride
+) const {
+    auto ptxt = IPlaintext::make();
+    decryptor.decrypt(ctxt, sk, *ptxt);
+    
+    Message<Complex> msg;
+    encoder.decode(*ptxt, msg);
+    msg.to(Device::CPU);
+    
+    return unpack(msg, count, output_size, output_stride);
+}
+
+} // namespace fhe_cnn
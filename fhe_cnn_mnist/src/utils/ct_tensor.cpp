@@ -0,0 +1,130 @@
+#include "fhe_cnn/ct_tensor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+TensorLayout TensorLayout::dense(int c, int h, int w, const SlotLayout& slots) {
+    TensorLayout layout;
+    layout.c = c;
+    layout.h = h;
+    layout.w = w;
+    layout.c_stride = h * w;
+    layout.h_stride = w;
+    layout.w_stride = 1;
+    layout.slots = slots;
+    return layout;
+}
+
+TensorLayout TensorLayout::split(int log_slots, int max_channels) const {
+    int num_slots = 1 << log_slots;
+    int limit = max_channels > 0 ? std::min(max_channels, c) : c;
+    
+    // Plus grand k tel que k canaux (k-1 écarts + un canal) tiennent
+    TensorLayout layout = *this;
+    layout.ct_channels = 0;
+    for (int k = limit; k >= 1; --k) {
+        int extent = (k - 1) * c_stride + (h - 1) * h_stride + (w - 1) * w_stride + 1;
+        if (slots.span(extent) <= num_slots) {
+            layout.ct_channels = k;
+            break;
+        }
+    }
+    
+    if (layout.ct_channels == 0) {
+        throw std::runtime_error("TensorLayout::split: un canal " + std::to_string(h) + "×" +
+                                 std::to_string(w) + " dépasse " + std::to_string(num_slots) + " slots");
+    }
+    return layout;
+}
+
+bool TensorLayout::dense() const {
+    return w_stride == 1 && h_stride == w && c_stride == h * w;
+}
+
+CtTensor::CtTensor(Ptr<ICiphertext> ct, const TensorLayout& layout)
+    : layout(layout)
+{
+    cts.push_back(std::move(ct));
+}
+
+ICiphertext& CtTensor::ct() {
+    if (cts.size() != 1 || !cts[0]) {
+        throw std::runtime_error("CtTensor: " + std::to_string(cts.size()) +
+                                 " ciphertexts, un seul attendu");
+    }
+    return *cts[0];
+}
+
+const ICiphertext& CtTensor::ct() const {
+    return const_cast<CtTensor*>(this)->ct();
+}
+
+int CtTensor::level(HomEval& eval) const {
+    if (cts.empty()) throw std::runtime_error("CtTensor::level: tenseur vide");
+    
+    int level = eval.getLevel(*cts[0]);
+    for (size_t i = 1; i < cts.size(); ++i) {
+        level = std::min(level, eval.getLevel(*cts[i]));
+    }
+    return level;
+}
+
+void parallel_for_cts(
+    int count,
+    FheContext& ctx,
+    const std::function<void(int, HomEval&, EnDecoder&)>& work,
+    int num_threads
+) {
+    if (count <= 0) return;
+    if (count == 1) {
+        work(0, ctx.eval(), ctx.encoder());
+        return;
+    }
+    
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, count);
+    
+    // Un évaluateur et un encodeur par thread (conservés par le contexte),
+    // chaque thread pioche la tâche suivante
+    ctx.reserveWorkers(num_threads);
+    std::atomic<int> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    
+    auto worker = [&](int w) {
+        HomEval& eval = ctx.eval(w);
+        EnDecoder& encoder = ctx.encoder(w);
+        
+        for (int i = next++; i < count; i = next++) {
+            try {
+                work(i, eval, encoder);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                next = count;  // Abandon des tâches restantes
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace fhe_cnn
@@ -0,0 +1,31 @@
+#include "fhe_cnn/fhe_context.hpp"
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// ------------------------------------------------------------
+// Construction: clés d'abord, puis évaluateur/encodeur du même preset
+// ------------------------------------------------------------
+FheContext::FheContext(std::shared_ptr<const KeyBundle> bundle, size_t max_resident)
+    : server_(bundle, max_resident),
+      eval_(server_.preset()),
+      encoder_(server_.preset()),
+      encryptor_(server_.preset())
+{
+}
+
+FheContext::FheContext(
+    PresetParamsId preset_id,
+    const ISecretKey& sk,
+    bool with_bootstrap,
+    size_t max_resident
+)
+    : server_(preset_id, sk, with_bootstrap, max_resident),
+      eval_(preset_id),
+      encoder_(preset_id),
+      encryptor_(preset_id)
+{
+}
+
+} // namespace fhe_cnn
@@ -0,0 +1,360 @@
+#include "fhe_cnn/key_bundle.hpp"
+#include "fhe_cnn/server_context.hpp"
+#include <iostream>
+#include <fstream>
+#include <streambuf>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// ------------------------------------------------------------
+// Format
+// ------------------------------------------------------------
+static const char BUNDLE_MAGIC[8] = {'F', 'H', 'E', 'K', 'E', 'Y', 'S', '2'};
+static const char SECRET_MAGIC[8] = {'F', 'H', 'E', 'S', 'K', 'E', 'Y', '1'};
+static const uint64_t BUNDLE_ALIGN = 4096;
+
+// Écrit dans l'ordre d'octets de la machine: relu à l'envers ailleurs
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t preset;
+    uint32_t log_slots;
+    uint64_t seed;
+    int32_t boot_output_level;
+    uint32_t num_entries;
+    uint64_t directory_offset;
+};
+
+struct BundleEntry {
+    uint32_t kind;
+    int32_t shift;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct SecretHeader {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t preset;
+    uint64_t seed;
+};
+
+// Lecture d'une zone mémoire comme un std::istream, sans copie
+class MappedBuf : public std::streambuf {
+public:
+    MappedBuf(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+};
+
+static size_t page_size() {
+    return sysconf(_SC_PAGESIZE);
+}
+
+// ------------------------------------------------------------
+// Lecture
+// ------------------------------------------------------------
+KeyBundle::KeyBundle(const std::string& path, PresetParamsId preset_id, uint64_t seed)
+    : path_(path),
+      preset_id_(preset_id),
+      seed_(seed),
+      log_slots_(0),
+      boot_output_level_(-1),
+      data_(nullptr),
+      size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("KeyBundle: impossible d'ouvrir " + path);
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BundleHeader)) {
+        close(fd);
+        throw std::runtime_error("KeyBundle: fichier tronqué " + path);
+    }
+    size_ = st.st_size;
+    
+    // Projection partagée: les pages du cache servent à tous les processus
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("KeyBundle: mmap impossible sur " + path);
+    }
+    data_ = static_cast<const char*>(map);
+    
+    // ------------------------------------------------------------
+    // 1. En-tête
+    // ------------------------------------------------------------
+    BundleHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    
+    // Offsets et tailles viennent du fichier: comparés au reste de size_,
+    // jamais additionnés (un fichier corrompu ferait déborder la somme)
+    std::string error;
+    if (std::memcmp(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) {
+        error = "format inconnu";
+    } else if (header.byte_order != BYTE_ORDER_MARK) {
+        error = "écrit sur une machine d'un autre ordre d'octets";
+    } else if (header.preset != (uint32_t)preset_id) {
+        error = "preset différent";
+    } else if (header.seed != seed) {
+        error = "graine différente";
+    } else if (header.directory_offset > size_ ||
+               header.num_entries > (size_ - header.directory_offset) / sizeof(BundleEntry)) {
+        error = "répertoire tronqué";
+    }
+    if (!error.empty()) {
+        munmap(const_cast<char*>(data_), size_);
+        throw std::runtime_error("KeyBundle " + path + ": " + error);
+    }
+    
+    log_slots_ = header.log_slots;
+    boot_output_level_ = header.boot_output_level;
+    
+    // ------------------------------------------------------------
+    // 2. Répertoire
+    // ------------------------------------------------------------
+    const char* dir = data_ + header.directory_offset;
+    for (uint32_t i = 0; i < header.num_entries; ++i) {
+        BundleEntry entry;
+        std::memcpy(&entry, dir + i * sizeof(BundleEntry), sizeof(entry));
+        if (entry.offset > size_ || entry.size > size_ - entry.offset) {
+            munmap(const_cast<char*>(data_), size_);
+            throw std::runtime_error("KeyBundle " + path + ": clé hors du fichier");
+        }
+        // Le paquet est projeté par les workers: jamais de clé secrète
+        if (entry.kind == (uint32_t)KeyKind::Secret) {
+            munmap(const_cast<char*>(data_), size_);
+            throw std::runtime_error("KeyBundle " + path + ": contient une clé secrète");
+        }
+        directory_[{entry.kind, entry.shift}] = {entry.offset, entry.size};
+    }
+}
+
+KeyBundle::~KeyBundle() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+bool KeyBundle::has(KeyKind kind, int shift) const {
+    return directory_.count({(uint32_t)kind, shift}) > 0;
+}
+
+std::vector<int> KeyBundle::rotShifts() const {
+    std::vector<int> shifts;
+    for (const auto& entry : directory_) {
+        if (entry.first.first == (uint32_t)KeyKind::Rot) shifts.push_back(entry.first.second);
+    }
+    return shifts;
+}
+
+const KeyBundle::Span& KeyBundle::find(KeyKind kind, int shift) const {
+    auto it = directory_.find({(uint32_t)kind, shift});
+    if (it == directory_.end()) {
+        throw std::runtime_error("KeyBundle " + path_ + ": clé absente (type " +
+                                 std::to_string((uint32_t)kind) + ", rotation " +
+                                 std::to_string(shift) + ")");
+    }
+    return it->second;
+}
+
+template <typename Loader>
+void KeyBundle::read(KeyKind kind, int shift, Loader&& load) const {
+    const Span& span = find(kind, shift);
+    
+    MappedBuf buf(data_ + span.offset, span.size);
+    std::istream in(&buf);
+    load(in);
+    
+    // La clé est désérialisée dans la mémoire de HEAAN2: les pages du fichier
+    // peuvent quitter l'espace de ce processus (elles restent dans le cache)
+    uint64_t page = page_size();
+    uint64_t first = span.offset / page * page;
+    uint64_t last = std::min<uint64_t>(span.offset + span.size, size_);
+    madvise(const_cast<char*>(data_) + first, last - first, MADV_DONTNEED);
+}
+
+Ptr<ISwKey> KeyBundle::loadRelinKey() const {
+    auto key = ISwKey::make();
+    read(KeyKind::Relin, 0, [&](std::istream& in) { key->load(in); });
+    return key;
+}
+
+Ptr<ISwKey> KeyBundle::loadConjKey() const {
+    auto key = ISwKey::make();
+    read(KeyKind::Conj, 0, [&](std::istream& in) { key->load(in); });
+    return key;
+}
+
+Ptr<ISwKey> KeyBundle::loadRotKey(int shift) const {
+    auto key = ISwKey::make();
+    read(KeyKind::Rot, shift, [&](std::istream& in) { key->load(in); });
+    return key;
+}
+
+std::unique_ptr<BootKeyPtrs> KeyBundle::loadBootKeys() const {
+    auto keys = std::make_unique<BootKeyPtrs>(preset_id_);
+    read(KeyKind::Boot, 0, [&](std::istream& in) { keys->load(in); });
+    return keys;
+}
+
+// ------------------------------------------------------------
+// Écriture
+// ------------------------------------------------------------
+std::string key_bundle_path(const std::string& dir, PresetParamsId preset_id, uint64_t seed) {
+    return dir + "/keys_p" + std::to_string((uint32_t)preset_id) + "_s" + std::to_string(seed) + ".bin";
+}
+
+bool key_bundle_exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void write_key_bundle(
+    const std::string& path,
+    uint64_t seed,
+    const ServerContext& server
+) {
+    std::cout << "💾 Écriture du paquet de clés " << path << "..." << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // Temporaire + rename: un lecteur concurrent ne voit jamais un fichier partiel
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("write_key_bundle: impossible de créer " + tmp_path);
+    }
+    
+    BundleHeader header;
+    std::memcpy(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.preset = (uint32_t)server.preset();
+    header.log_slots = server.logSlots();
+    header.seed = seed;
+    header.boot_output_level = server.hasBootstrap() ? server.bootstrap().outputLevel() : -1;
+    header.num_entries = 0;
+    header.directory_offset = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    // ------------------------------------------------------------
+    // 1. Blocs de clés, chacun aligné sur une page
+    // ------------------------------------------------------------
+    std::vector<BundleEntry> entries;
+    
+    auto append = [&](KeyBundle::KeyKind kind, int shift, auto&& save) {
+        uint64_t offset = out.tellp();
+        uint64_t aligned = (offset + BUNDLE_ALIGN - 1) / BUNDLE_ALIGN * BUNDLE_ALIGN;
+        for (uint64_t i = offset; i < aligned; ++i) out.put('\0');
+        
+        save(out);
+        entries.push_back({(uint32_t)kind, shift, aligned, (uint64_t)out.tellp() - aligned});
+    };
+    
+    append(KeyBundle::KeyKind::Relin, 0, [&](std::ostream& os) { server.relinKey().save(os); });
+    if (server.hasConjKey()) {
+        append(KeyBundle::KeyKind::Conj, 0, [&](std::ostream& os) { server.conjKey().save(os); });
+    }
+    for (int shift : server.rotKeys().residentShifts()) {
+        auto key = server.rotKeys().find(shift);
+        if (!key) continue;  // évincée entre-temps
+        append(KeyBundle::KeyKind::Rot, shift, [&](std::ostream& os) { key->save(os); });
+    }
+    if (server.hasBootstrap()) {
+        append(KeyBundle::KeyKind::Boot, 0, [&](std::ostream& os) { server.bootstrap().bootKeys().save(os); });
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Répertoire, puis en-tête définitif
+    // ------------------------------------------------------------
+    header.directory_offset = out.tellp();
+    header.num_entries = entries.size();
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BundleEntry));
+    
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    
+    if (!out || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("write_key_bundle: échec d'écriture de " + path);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "  ✅ " << entries.size() << " clés, " << header.directory_offset / (1 << 20)
+              << " Mo en " << duration.count() << " ms" << std::endl;
+}
+
+// ------------------------------------------------------------
+// Clé secrète: fichier client séparé
+// ------------------------------------------------------------
+std::string secret_key_path(const std::string& dir, PresetParamsId preset_id, uint64_t seed) {
+    return dir + "/sk_p" + std::to_string((uint32_t)preset_id) + "_s" + std::to_string(seed) + ".bin";
+}
+
+void write_secret_key(
+    const std::string& path,
+    PresetParamsId preset_id,
+    uint64_t seed,
+    const ISecretKey& sk
+) {
+    // Temporaire lisible par le propriétaire seul, puis renommé
+    std::string tmp_path = path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("write_secret_key: impossible de créer " + tmp_path);
+    }
+    close(fd);
+    
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    SecretHeader header;
+    std::memcpy(header.magic, SECRET_MAGIC, sizeof(SECRET_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.preset = (uint32_t)preset_id;
+    header.seed = seed;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    sk.save(out);
+    out.close();
+    
+    if (!out || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("write_secret_key: échec d'écriture de " + path);
+    }
+}
+
+Ptr<ISecretKey> load_secret_key(const std::string& path, PresetParamsId preset_id, uint64_t seed) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("load_secret_key: impossible d'ouvrir " + path);
+    }
+    
+    SecretHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, SECRET_MAGIC, sizeof(SECRET_MAGIC)) != 0 ||
+        header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error("load_secret_key " + path + ": format inconnu");
+    }
+    if (header.preset != (uint32_t)preset_id || header.seed != seed) {
+        throw std::runtime_error("load_secret_key " + path + ": autre preset ou autre graine");
+    }
+    
+    auto key = ISecretKey::make();
+    key->load(in);
+    return key;
+}
+
+} // namespace fhe_cnn
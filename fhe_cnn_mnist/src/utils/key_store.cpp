@@ -0,0 +1,326 @@
+#include "fhe_cnn/key_store.hpp"
+#include "fhe_cnn/key_bundle.hpp"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+RotationKeyStore::RotationKeyStore(
+    PresetParamsId preset_id,
+    int log_slots,
+    const ISecretKey* sk,
+    size_t max_resident
+)
+    : preset_id_(preset_id),
+      log_slots_(log_slots),
+      sk_(sk),
+      max_resident_(max_resident),
+      entries_(1 << log_slots)
+{
+}
+
+int RotationKeyStore::normalize(int shift) const {
+    int num_slots = 1 << log_slots_;
+    return ((shift % num_slots) + num_slots) % num_slots;
+}
+
+// ------------------------------------------------------------
+// Accès
+// ------------------------------------------------------------
+std::shared_ptr<const ISwKey> RotationKeyStore::get(int shift) {
+    int s = normalize(shift);
+    
+    std::shared_ptr<std::promise<std::shared_ptr<const ISwKey>>> promise;
+    std::shared_future<std::shared_ptr<const ISwKey>> pending;
+    std::shared_ptr<const KeyBundle> bundle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[s];
+        
+        if (entry.key) {
+            hits_++;
+            entry.uses++;
+            entry.last_use = ++clock_;
+            return entry.key;
+        }
+        misses_++;
+        
+        // Clé déjà en cours de chargement par un autre thread: l'attendre
+        auto it = pending_.find(s);
+        if (it != pending_.end()) {
+            pending = it->second;
+        } else {
+            bundle = bundle_;
+            if (!(bundle && bundle->hasRotKey(s)) && !sk_) {
+                throw std::runtime_error("RotationKeyStore: clé rotation " + std::to_string(s) +
+                                         " absente (table figée)");
+            }
+            promise = std::make_shared<std::promise<std::shared_ptr<const ISwKey>>>();
+            pending = promise->get_future().share();
+            pending_[s] = pending;
+        }
+    }
+    
+    if (!promise) return pending.get();
+    
+    // ------------------------------------------------------------
+    // Lecture / génération hors verrou (plusieurs secondes): les hits
+    // des autres threads ne l'attendent pas
+    // ------------------------------------------------------------
+    std::shared_ptr<const ISwKey> key;
+    try {
+        if (bundle && bundle->hasRotKey(s)) {
+            key = bundle->loadRotKey(s);
+        } else {
+            SwKeyGenerator swkgen(preset_id_);
+            key = swkgen.genRotKey(*sk_, s);
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.erase(s);
+        }
+        promise->set_exception(std::current_exception());
+        throw;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        store(s, key);
+        entries_[s].uses++;
+        entries_[s].last_use = ++clock_;
+        pending_.erase(s);
+    }
+    promise->set_value(key);
+    return key;
+}
+
+void RotationKeyStore::attach(std::shared_ptr<const KeyBundle> bundle) {
+    if (bundle && bundle->logSlots() != log_slots_) {
+        throw std::runtime_error("RotationKeyStore: paquet de clés pour log_slots = " +
+                                 std::to_string(bundle->logSlots()));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    bundle_ = std::move(bundle);
+}
+
+std::shared_ptr<const ISwKey> RotationKeyStore::find(int shift) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_[normalize(shift)].key;
+}
+
+std::vector<int> RotationKeyStore::residentShifts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> shifts;
+    for (int s = 0; s < (int)entries_.size(); ++s) {
+        if (entries_[s].key) shifts.push_back(s);
+    }
+    return shifts;
+}
+
+bool RotationKeyStore::resident(int shift) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_[normalize(shift)].key != nullptr;
+}
+
+bool RotationKeyStore::available(int shift) const {
+    int s = normalize(shift);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_[s].key || sk_ || (bundle_ && bundle_->hasRotKey(s));
+}
+
+bool RotationKeyStore::full() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_resident_ > 0 && resident_ >= max_resident_;
+}
+
+size_t RotationKeyStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_;
+}
+
+size_t RotationKeyStore::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t RotationKeyStore::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+size_t RotationKeyStore::evictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+// ------------------------------------------------------------
+// Insertion + éviction (mutex tenu par l'appelant)
+// ------------------------------------------------------------
+void RotationKeyStore::store(int s, std::shared_ptr<const ISwKey> key) {
+    Entry& entry = entries_[s];
+    if (!entry.key) {
+        if (max_resident_ > 0 && resident_ >= max_resident_) {
+            evictOne(s);
+        }
+        resident_++;
+    }
+    entry.key = std::move(key);
+}
+
+void RotationKeyStore::evictOne(int keep) {
+    // Moins utilisée d'abord, puis la plus ancienne
+    int victim = -1;
+    for (int s = 0; s < (int)entries_.size(); ++s) {
+        if (s == keep || !entries_[s].key) continue;
+        if (victim < 0 ||
+            entries_[s].uses < entries_[victim].uses ||
+            (entries_[s].uses == entries_[victim].uses &&
+             entries_[s].last_use < entries_[victim].last_use)) {
+            victim = s;
+        }
+    }
+    if (victim < 0) return;
+    
+    entries_[victim] = Entry();
+    resident_--;
+    evictions_++;
+}
+
+void RotationKeyStore::insert(int shift, std::shared_ptr<const ISwKey> key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    store(normalize(shift), std::move(key));
+}
+
+// ------------------------------------------------------------
+// Chargement + génération parallèle
+// ------------------------------------------------------------
+void RotationKeyStore::generate(const std::vector<int>& shifts, int num_threads) {
+    // ------------------------------------------------------------
+    // 1. Rotations manquantes (sans doublons), lues dans le paquet si possible
+    // ------------------------------------------------------------
+    std::shared_ptr<const KeyBundle> bundle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bundle = bundle_;
+    }
+    
+    std::vector<int> todo;
+    int loaded = 0;
+    for (int shift : shifts) {
+        int s = normalize(shift);
+        if (s == 0 || resident(s) || std::find(todo.begin(), todo.end(), s) != todo.end()) {
+            continue;
+        }
+        if (bundle && bundle->hasRotKey(s)) {
+            insert(s, bundle->loadRotKey(s));
+            loaded++;
+        } else {
+            todo.push_back(s);
+        }
+    }
+    if (loaded > 0) {
+        std::cout << "📂 " << loaded << " clés de rotation lues dans le paquet" << std::endl;
+    }
+    
+    int total = todo.size();
+    if (total == 0) return;
+    
+    if (!sk_) {
+        throw std::runtime_error("RotationKeyStore: génération impossible (table figée)");
+    }
+    
+    // Au-delà du budget, les clés générées évinceraient les résidentes (déjà
+    // là ou lues ci-dessus) puis s'évinceraient entre elles: on s'arrête au
+    // budget, les suivantes seront générées au premier get()
+    size_t room = todo.size();
+    if (max_resident_ > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        room = max_resident_ - std::min(max_resident_, resident_);
+    }
+    if (todo.size() > room) {
+        std::cout << "    ⚠️  " << total << " clés demandées > budget de " << max_resident_ 
+                  << ": " << room << " générées, les autres à la demande" << std::endl;
+        todo.resize(room);
+        total = todo.size();
+        if (total == 0) return;
+    }
+    
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, total);
+    
+    std::cout << "🔑 Génération de " << total << " clés de rotation ("
+              << num_threads << " threads)..." << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // ------------------------------------------------------------
+    // 2. Un générateur par thread, chaque thread pioche la clé suivante
+    // ------------------------------------------------------------
+    std::vector<Ptr<ISwKey>> keys(total);
+    std::atomic<int> next(0);
+    std::atomic<int> done(0);
+    std::mutex print_mutex;
+    int report_every = std::max(1, total / 10);
+    
+    auto worker = [&]() {
+        SwKeyGenerator swkgen(preset_id_);
+        
+        for (int i = next++; i < total; i = next++) {
+            keys[i] = swkgen.genRotKey(*sk_, todo[i]);
+            
+            int count = ++done;
+            if (count % report_every == 0 || count == total) {
+                auto now = std::chrono::high_resolution_clock::now();
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+                
+                std::lock_guard<std::mutex> lock(print_mutex);
+                std::cout << "    " << count << "/" << total << " clés ("
+                          << elapsed.count() << " ms)" << std::endl;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    // ------------------------------------------------------------
+    // 3. Fusion dans la table
+    // ------------------------------------------------------------
+    for (int i = 0; i < total; ++i) {
+        insert(todo[i], std::move(keys[i]));
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "  ✅ " << total << " clés en " << duration.count() << " ms ("
+              << duration.count() * num_threads / total << " ms/clé/thread)" << std::endl;
+}
+
+void RotationKeyStore::printStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    size_t lookups = hits_ + misses_;
+    std::cout << "🔑 Clés de rotation: " << resident_ << " résidentes";
+    if (max_resident_ > 0) std::cout << " / " << max_resident_;
+    std::cout << ", " << hits_ << " hits, " << misses_ << " misses";
+    if (lookups > 0) std::cout << " (" << 100 * hits_ / lookups << "% hits)";
+    std::cout << ", " << evictions_ << " évictions" << std::endl;
+}
+
+} // namespace fhe_cnn
@@ -1,59 +1,83 @@
 #include "fhe_cnn/utils.hpp"
+#include "fhe_cnn/server_context.hpp"
 #include <iostream>
+#include <cmath>
+#include <iomanip>
+#include <set>
 
 namespace fhe_cnn {
 
 using namespace heaan;
 
+std::vector<int> collect_rotation_shifts(
+    const std::vector<std::pair<std::string, std::vector<int>>>& requests,
+    int log_slots
+) {
+    int num_slots = 1 << log_slots;
+    std::set<int> all_shifts;
+    int requested = 0;
+    
+    std::cout << "🔑 Rotations déclarées par couche:" << std::endl;
+    
+    for (const auto& request : requests) {
+        std::set<int> layer_shifts;
+        for (int shift : request.second) {
+            int s = ((shift % num_slots) + num_slots) % num_slots;
+            if (s != 0) layer_shifts.insert(s);
+        }
+        
+        int added = 0;
+        for (int s : layer_shifts) {
+            if (all_shifts.insert(s).second) added++;
+        }
+        requested += layer_shifts.size();
+        
+        std::cout << "    " << std::left << std::setw(12) << request.first << std::right
+                  << std::setw(4) << layer_shifts.size() << " rotations, "
+                  << std::setw(4) << added << " nouvelles" << std::endl;
+    }
+    
+    std::cout << "  ✅ " << all_shifts.size() << " clés distinctes (" 
+              << requested << " demandées)" << std::endl;
+    
+    return std::vector<int>(all_shifts.begin(), all_shifts.end());
+}
+
 void generate_all_rot_keys(
+    ServerContext& server,
     const ISecretKey& sk,
     int max_rot,
-    std::map<int, Ptr<ISwKey>>& rot_keys
+    int num_threads
 ) {
     std::cout << "🔑 Génération des clés de rotation (0.." << max_rot-1 << ")..." << std::endl;
     
-    SwKeyGenerator swkgen(PresetParamsId::F16Opt_Gr);
+    std::vector<int> shifts;
     
     // Puissances de 2 pour rotate-and-sum
     for (int shift = 1; shift < max_rot; shift <<= 1) {
-        if (rot_keys.find(shift) == rot_keys.end()) {
-            std::cout << "    Rot key " << shift << "..." << std::endl;
-            auto rot_key = swkgen.genRotKey(sk, shift);
-            rot_keys[shift] = std::move(rot_key);
-        }
+        shifts.push_back(shift);
     }
     
     // Baby steps (1..sqrt(max_rot))
     int n2 = (int)std::sqrt(max_rot);
     for (int rot = 1; rot < n2; ++rot) {
-        if (rot_keys.find(rot) == rot_keys.end()) {
-            std::cout << "    Baby step key " << rot << "..." << std::endl;
-            auto rot_key = swkgen.genRotKey(sk, rot);
-            rot_keys[rot] = std::move(rot_key);
-        }
+        shifts.push_back(rot);
     }
     
     // Giant steps (multiples de n2)
     int n1 = max_rot / n2;
     for (int j = 1; j < n1; ++j) {
-        int rot = j * n2;
-        if (rot_keys.find(rot) == rot_keys.end()) {
-            std::cout << "    Giant step key " << rot << "..." << std::endl;
-            auto rot_key = swkgen.genRotKey(sk, rot);
-            rot_keys[rot] = std::move(rot_key);
-        }
+        shifts.push_back(j * n2);
     }
     
     // Rotations individuelles pour répartition finale
     for (int rot = 1; rot < max_rot; ++rot) {
-        if (rot_keys.find(rot) == rot_keys.end()) {
-            std::cout << "    Final key " << rot << "..." << std::endl;
-            auto rot_key = swkgen.genRotKey(sk, rot);
-            rot_keys[rot] = std::move(rot_key);
-        }
+        shifts.push_back(rot);
     }
     
-    std::cout << "  ✅ " << rot_keys.size() << " clés générées" << std::endl;
+    server.generateRotKeys(sk, shifts, num_threads);
+    
+    std::cout << "  ✅ " << server.rotKeys().size() << " clés générées" << std::endl;
 }
 
-} // namespace fhe_cnn
\ No newline at end of file
+} // namespace fhe_cnn
@@ -0,0 +1,69 @@
+#include "fhe_cnn/layout.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+SlotLayout SlotLayout::block(int batch, int stride) {
+    SlotLayout layout;
+    layout.order = BatchOrder::Block;
+    layout.batch = batch;
+    layout.stride = stride;
+    return layout;
+}
+
+SlotLayout SlotLayout::interleaved(int batch) {
+    SlotLayout layout;
+    layout.order = BatchOrder::Interleaved;
+    layout.batch = batch;
+    return layout;
+}
+
+int SlotLayout::slot(int image, int index) const {
+    return order == BatchOrder::Interleaved
+        ? index * batch + image
+        : image * stride + index;
+}
+
+int SlotLayout::rotation(int shift) const {
+    return order == BatchOrder::Interleaved ? shift * batch : shift;
+}
+
+std::vector<int> SlotLayout::rotations(const std::vector<int>& shifts) const {
+    std::vector<int> result;
+    for (int shift : shifts) result.push_back(rotation(shift));
+    return result;
+}
+
+int SlotLayout::span(int size) const {
+    return order == BatchOrder::Interleaved
+        ? size * batch
+        : (batch - 1) * stride + size;
+}
+
+Message<Complex> broadcast_message(
+    const std::vector<Complex>& values,
+    const SlotLayout& layout,
+    int log_slots
+) {
+    int num_slots = 1 << log_slots;
+    int size = (int)values.size();
+    if (layout.span(size) > num_slots) {
+        throw std::runtime_error("broadcast_message: " + std::to_string(layout.span(size)) +
+                                 " slots requis pour " + std::to_string(num_slots) + " disponibles");
+    }
+    
+    Message<Complex> msg(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) msg[i] = Complex(0.0, 0.0);
+    
+    for (int b = 0; b < layout.batch; ++b) {
+        for (int i = 0; i < size; ++i) {
+            msg[layout.slot(b, i)] = values[i];
+        }
+    }
+    return msg;
+}
+
+} // namespace fhe_cnn
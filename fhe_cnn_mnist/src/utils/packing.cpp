@@ -41,120 +41,72 @@ Ptr<ICiphertext> encrypt_image(
     return ctxt;
 }
 
-std::vector<double> decrypt_result(
-    const ICiphertext& ctxt,
-    const ISecretKey& sk,
-    EnDecoder& encoder,
-    EnDecryptor& encryptor,
-    int n
+Message<Complex> pack_complex(
+    const Message<Complex>& msg_re,
+    const Message<Complex>& msg_im
 ) {
-    auto ptxt = IPlaintext::make();
-    encryptor.decrypt(ctxt, sk, *ptxt);
-    
-    Message<Complex> msg;
-    encoder.decode(*ptxt, msg);
-    msg.to(Device::CPU);
+    int log_slots = msg_re.logSlots();
+    int num_slots = 1 << log_slots;
     
-    std::vector<double> result(n);
-    for (int i = 0; i < n; ++i) {
-        result[i] = msg[i].real() / n;  // Division par n !
+    Message<Complex> msg(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) {
+        msg[i] = Complex(msg_re[i].real(), msg_im[i].real());
     }
     
-    return result;
+    return msg;
 }
 
-// À AJOUTER dans packing.cpp
-
-Message<Complex> pack_4_images(
-    const std::vector<std::vector<double>>& images,
-    int log_slots,
-    Device device
+Ptr<IPlaintext> encode_at_level(
+    const Message<Complex>& msg,
+    int level,
+    EnDecoder& encoder,
+    HomEval& eval
 ) {
-    if (images.size() != 4) {
-        throw std::runtime_error("pack_4_images: besoin de 4 images");
-    }
-    
-    int num_slots = 1 << log_slots;
-    int img_size = 784;  // 28×28
-    
-    Message<Complex> msg(log_slots, device);
-    
-    // Image 1: slots 0-783
-    for (int i = 0; i < img_size && i < num_slots; ++i) {
-        msg[i] = Complex(images[0][i], 0.0);
-    }
-    
-    // Image 2: slots 784-1567
-    for (int i = 0; i < img_size && (i + img_size) < num_slots; ++i) {
-        msg[i + img_size] = Complex(images[1][i], 0.0);
-    }
+    auto ptxt = IPlaintext::make();
+    encoder.encode(msg, *ptxt);
     
-    // Image 3: slots 1568-2351
-    for (int i = 0; i < img_size && (i + 2*img_size) < num_slots; ++i) {
-        msg[i + 2*img_size] = Complex(images[2][i], 0.0);
-    }
+    auto ptxt_leveled = IPlaintext::make();
+    eval.levelDownTo(*ptxt, *ptxt_leveled, level);
+    return ptxt_leveled;
+}
+
+LeveledPlaintext::LeveledPlaintext(Message<Complex> msg) : msg_(std::move(msg)) {}
+
+const IPlaintext& LeveledPlaintext::at(int level, EnDecoder& encoder, HomEval& eval) const {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    // Image 4: slots 2352-3135
-    for (int i = 0; i < img_size && (i + 3*img_size) < num_slots; ++i) {
-        msg[i + 3*img_size] = Complex(images[3][i], 0.0);
+    auto it = by_level_.find(level);
+    if (it == by_level_.end()) {
+        it = by_level_.emplace(level, encode_at_level(msg_, level, encoder, eval)).first;
     }
-    
-    // Remplir le reste avec 0
-    for (int i = 4 * img_size; i < num_slots; ++i) {
-        msg[i] = Complex(0.0, 0.0);
-    }
-    
-    std::cout << "    📦 4 images packées: " 
-              << 4 * img_size << " slots utilisés" << std::endl;
-    
-    return msg;
+    return *it->second;
 }
 
-std::vector<std::vector<double>> unpack_4_results(
+size_t LeveledPlaintext::levels() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return by_level_.size();
+}
+
+std::vector<double> decrypt_result(
     const ICiphertext& ctxt,
     const ISecretKey& sk,
     EnDecoder& encoder,
-    EnDecryptor& decryptor,
-    int output_size
+    EnDecryptor& encryptor,
+    int n
 ) {
-    // Déchiffrement
     auto ptxt = IPlaintext::make();
-    decryptor.decrypt(ctxt, sk, *ptxt);
+    encryptor.decrypt(ctxt, sk, *ptxt);
     
     Message<Complex> msg;
     encoder.decode(*ptxt, msg);
     msg.to(Device::CPU);
     
-    int num_slots = 1 << msg.logSlots();
-    int stride = output_size;  // Espacement entre les résultats
-    
-    std::vector<std::vector<double>> results(4);
-    
-    // Image 1: slots 0..output_size-1
-    results[0].resize(output_size);
-    for (int i = 0; i < output_size; ++i) {
-        results[0][i] = msg[i].real();
-    }
-    
-    // Image 2: slots stride..stride+output_size-1
-    results[1].resize(output_size);
-    for (int i = 0; i < output_size; ++i) {
-        results[1][i] = msg[i + stride].real();
-    }
-    
-    // Image 3: slots 2*stride..2*stride+output_size-1
-    results[2].resize(output_size);
-    for (int i = 0; i < output_size; ++i) {
-        results[2][i] = msg[i + 2*stride].real();
-    }
-    
-    // Image 4: slots 3*stride..3*stride+output_size-1
-    results[3].resize(output_size);
-    for (int i = 0; i < output_size; ++i) {
-        results[3][i] = msg[i + 3*stride].real();
+    std::vector<double> result(n);
+    for (int i = 0; i < n; ++i) {
+        result[i] = msg[i].real() / n;  // Division par n !
     }
     
-    return results;
+    return result;
 }
 
 } // namespace fhe_cnn
\ No newline at end of file
@@ -0,0 +1,424 @@
+#include "fhe_cnn/permutation.hpp"
+#include "fhe_cnn/rotation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// Division entière arrondie vers -∞
+static int floor_div(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+SlotPermutation::SlotPermutation(
+    std::vector<SlotMove> moves,
+    int extent,
+    const SlotLayout& layout,
+    int log_slots,
+    const PermutationCost& cost
+)
+    : moves_(std::move(moves)),
+      extent_(extent),
+      layout_(layout),
+      log_slots_(log_slots),
+      cost_(cost),
+      method_(PermutationMethod::Bsgs)
+{
+    if (layout_.span(extent_) > (1 << log_slots_)) {
+        throw std::runtime_error("SlotPermutation: " + std::to_string(layout_.span(extent_)) +
+                                 " slots requis pour " + std::to_string(1 << log_slots_) + " disponibles");
+    }
+    
+    if (moves_.empty()) {
+        throw std::runtime_error("SlotPermutation: aucun déplacement");
+    }
+    
+    std::vector<bool> used(extent_, false);
+    for (const auto& move : moves_) {
+        if (move.src < 0 || move.src >= extent_ || move.dst < 0 || move.dst >= extent_) {
+            throw std::runtime_error("SlotPermutation: déplacement " + std::to_string(move.src) + " → " +
+                                     std::to_string(move.dst) + " hors de [0, " + std::to_string(extent_) + ")");
+        }
+        if (used[move.dst]) {
+            throw std::runtime_error("SlotPermutation: destination " + std::to_string(move.dst) + " en double");
+        }
+        used[move.dst] = true;
+    }
+    
+    // ------------------------------------------------------------
+    // Candidats: BSGS (un niveau) et réseau de décalages (un niveau par
+    // étage), le moins cher sous la profondeur disponible
+    // ------------------------------------------------------------
+    std::vector<Stage> bsgs, network;
+    bool has_bsgs = planBsgs(bsgs);
+    bool has_network = planShiftNetwork(network);
+    
+    auto plan_cost = [&](const std::vector<Stage>& stages) {
+        return countRotations(stages) * cost_.rotation + (double)stages.size() * cost_.level;
+    };
+    
+    has_bsgs = has_bsgs && (int)bsgs.size() <= cost_.max_depth;
+    has_network = has_network && (int)network.size() <= cost_.max_depth;
+    
+    if (!has_bsgs && !has_network) {
+        throw std::runtime_error("SlotPermutation: aucune décomposition en " +
+                                 std::to_string(cost_.max_depth) + " niveau(x)");
+    }
+    
+    if (has_network && (!has_bsgs || plan_cost(network) < plan_cost(bsgs))) {
+        method_ = PermutationMethod::ShiftNetwork;
+        stages_ = std::move(network);
+    } else {
+        method_ = PermutationMethod::Bsgs;
+        stages_ = std::move(bsgs);
+    }
+}
+
+// ------------------------------------------------------------
+// BSGS: décalage delta = src - dst = g·n1 + b,
+//   y = Σ_g Rot_{g·n1}( Σ_b M'_{g,b} ⊙ Rot_b(x) )
+// où M'_{g,b} = Rot_{-g·n1}(M_{g,b}) porte weight à l'élément dst + g·n1.
+// n1 minimise le nombre de rotations non nulles.
+// ------------------------------------------------------------
+bool SlotPermutation::planBsgs(std::vector<Stage>& stages) const {
+    int max_delta = 0;
+    for (const auto& move : moves_) max_delta = std::max(max_delta, std::abs(move.src - move.dst));
+    
+    int best_n1 = 0;
+    int best_cost = -1;
+    int limit = std::min(2 * (int)std::ceil(std::sqrt(max_delta + 1.0)) + 1, max_delta + 1);
+    
+    for (int n1 = 1; n1 <= limit; ++n1) {
+        std::set<int> babies, giants;
+        bool valid = true;
+        for (const auto& move : moves_) {
+            int delta = move.src - move.dst;
+            int g = floor_div(delta, n1);
+            int q = move.dst + g * n1;  // Position du masque pré-tourné
+            if (q < 0 || q >= extent_) {
+                valid = false;
+                break;
+            }
+            if (delta - g * n1 != 0) babies.insert(delta - g * n1);
+            if (g != 0) giants.insert(g);
+        }
+        
+        int cost = (int)(babies.size() + giants.size());
+        if (valid && (best_cost < 0 || cost < best_cost)) {
+            best_cost = cost;
+            best_n1 = n1;
+        }
+    }
+    if (best_cost < 0) return false;
+    
+    std::map<int, std::map<int, std::vector<double>>> masks;  // g → b → masque
+    for (const auto& move : moves_) {
+        int delta = move.src - move.dst;
+        int g = floor_div(delta, best_n1);
+        auto& mask = masks[g][delta - g * best_n1];
+        if (mask.empty()) mask.assign(extent_, 0.0);
+        mask[move.dst + g * best_n1] = move.weight;
+    }
+    
+    Stage stage;
+    for (auto& giant : masks) {
+        Group group;
+        group.post = giant.first * best_n1;
+        for (auto& baby : giant.second) {
+            group.terms.push_back({baby.first, std::move(baby.second)});
+        }
+        stage.push_back(std::move(group));
+    }
+    
+    stages.clear();
+    if (!stage.empty()) stages.push_back(std::move(stage));
+    return true;
+}
+
+// ------------------------------------------------------------
+// Réseau de décalages: à l'étage k, les éléments dont le bit k du
+// décalage restant est à 1 avancent de ±2^k, les autres restent:
+//   x' = M_0 ⊙ x + M_+ ⊙ Rot_{2^k}(x) + M_- ⊙ Rot_{-2^k}(x)
+// Les masques (positions après l'étage) effacent aussi les déchets; les
+// poids sont portés par le dernier étage.
+// ------------------------------------------------------------
+bool SlotPermutation::planShiftNetwork(std::vector<Stage>& stages) const {
+    int n = (int)moves_.size();
+    std::vector<int> pos(n), remaining(n);
+    int max_delta = 0;
+    for (int j = 0; j < n; ++j) {
+        pos[j] = moves_[j].src;
+        remaining[j] = moves_[j].src - moves_[j].dst;
+        max_delta = std::max(max_delta, std::abs(remaining[j]));
+    }
+    
+    stages.clear();
+    for (int step = 1; step <= max_delta; step <<= 1) {
+        bool moving = false;
+        for (int j = 0; j < n; ++j) moving = moving || (std::abs(remaining[j]) & step);
+        if (!moving) continue;
+        
+        std::map<int, std::vector<double>> masks;  // décalage → masque
+        std::vector<bool> taken(extent_, false);
+        for (int j = 0; j < n; ++j) {
+            int shift = 0;
+            if (std::abs(remaining[j]) & step) shift = remaining[j] > 0 ? step : -step;
+            
+            int next = pos[j] - shift;
+            if (next < 0 || next >= extent_ || taken[next]) return false;  // Sortie ou collision
+            taken[next] = true;
+            
+            auto& mask = masks[shift];
+            if (mask.empty()) mask.assign(extent_, 0.0);
+            mask[next] = 1.0;
+            
+            pos[j] = next;
+            remaining[j] -= shift;
+        }
+        
+        Group group;
+        group.post = 0;
+        for (auto& entry : masks) group.terms.push_back({entry.first, std::move(entry.second)});
+        stages.push_back({std::move(group)});
+    }
+    
+    // Aucun déplacement: un masque seul
+    if (stages.empty()) {
+        Group group;
+        group.post = 0;
+        group.terms.push_back({0, std::vector<double>(extent_, 0.0)});
+        for (const auto& move : moves_) group.terms[0].mask[move.dst] = 1.0;
+        stages.push_back({std::move(group)});
+    }
+    
+    // Poids au dernier étage: l'élément arrive à dst par un seul terme
+    for (const auto& move : moves_) {
+        for (auto& term : stages.back()[0].terms) {
+            if (term.mask[move.dst] != 0.0) {
+                term.mask[move.dst] = move.weight;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+int SlotPermutation::countRotations(const std::vector<Stage>& stages) {
+    int count = 0;
+    for (const auto& stage : stages) {
+        std::set<int> shifts;  // Rotations de l'entrée de l'étage, partagées
+        for (const auto& group : stage) {
+            for (const auto& term : group.terms) {
+                if (term.shift != 0) shifts.insert(term.shift);
+            }
+            if (group.post != 0) count++;
+        }
+        count += (int)shifts.size();
+    }
+    return count;
+}
+
+std::vector<int> SlotPermutation::rotationShifts() const {
+    std::set<int> shifts;
+    for (const auto& stage : stages_) {
+        for (const auto& group : stage) {
+            if (group.post != 0) shifts.insert(group.post);
+            for (const auto& term : group.terms) {
+                if (term.shift != 0) shifts.insert(term.shift);
+            }
+        }
+    }
+    return layout_.rotations(std::vector<int>(shifts.begin(), shifts.end()));
+}
+
+void SlotPermutation::buildMasks() const {
+    masks_.resize(stages_.size());
+    for (size_t s = 0; s < stages_.size(); ++s) {
+        masks_[s].resize(stages_[s].size());
+        for (size_t g = 0; g < stages_[s].size(); ++g) {
+            for (const auto& term : stages_[s][g].terms) {
+                std::vector<Complex> values(term.mask.size());
+                for (size_t i = 0; i < values.size(); ++i) values[i] = Complex(term.mask[i], 0.0);
+                
+                masks_[s][g].push_back(std::make_unique<LeveledPlaintext>(
+                    broadcast_message(values, layout_, log_slots_)));
+            }
+        }
+    }
+}
+
+Ptr<ICiphertext> SlotPermutation::apply(
+    const ICiphertext& ctxt,
+    RotationKeyStore& rot_keys,
+    HomEval& eval,
+    EnDecoder& encoder
+) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (masks_.empty()) buildMasks();
+    }
+    
+    const ICiphertext* ct_in = &ctxt;
+    Ptr<ICiphertext> ct_stage;
+    
+    for (size_t s = 0; s < stages_.size(); ++s) {
+        int level = eval.getLevel(*ct_in);
+        // Rotations de l'entrée, partagées par les groupes (un seul appel)
+        std::vector<int> shifts;
+        for (const Group& group : stages_[s]) {
+            for (const Term& term : group.terms) {
+                if (term.shift != 0) shifts.push_back(layout_.rotation(term.shift));
+            }
+        }
+        std::sort(shifts.begin(), shifts.end());
+        shifts.erase(std::unique(shifts.begin(), shifts.end()), shifts.end());
+        
+        std::map<int, Ptr<ICiphertext>> rotated;
+        auto cts = homomorphic_rotate_many(*ct_in, shifts, rot_keys, eval);
+        for (size_t t = 0; t < shifts.size(); ++t) rotated[shifts[t]] = std::move(cts[t]);
+        Ptr<ICiphertext> ct_out;
+        
+        for (size_t g = 0; g < stages_[s].size(); ++g) {
+            const Group& group = stages_[s][g];
+            Ptr<ICiphertext> ct_group;
+            
+            for (size_t t = 0; t < group.terms.size(); ++t) {
+                int shift = group.terms[t].shift;
+                const ICiphertext* ct_shifted = ct_in;
+                if (shift != 0) ct_shifted = rotated.at(layout_.rotation(shift)).get();
+                
+                auto ct_mul = ICiphertext::make();
+                eval.mul(*ct_shifted, masks_[s][g][t]->at(level, encoder, eval), *ct_mul);
+                eval.rescale(*ct_mul, *ct_mul);
+                
+                if (!ct_group) {
+                    ct_group = std::move(ct_mul);
+                } else {
+                    auto ct_add = ICiphertext::make();
+                    eval.add(*ct_group, *ct_mul, *ct_add);
+                    ct_group = std::move(ct_add);
+                }
+            }
+            
+            if (group.post != 0) {
+                ct_group = homomorphic_rotate(*ct_group, layout_.rotation(group.post), rot_keys, eval);
+            }
+            
+            if (!ct_out) {
+                ct_out = std::move(ct_group);
+            } else {
+                auto ct_add = ICiphertext::make();
+                eval.add(*ct_out, *ct_group, *ct_add);
+                ct_out = std::move(ct_add);
+            }
+        }
+        
+        ct_stage = std::move(ct_out);
+        ct_in = ct_stage.get();
+    }
+    return ct_stage;
+}
+
+std::vector<double> SlotPermutation::simulate(const std::vector<double>& elements) const {
+    auto rotate = [&](const std::vector<double>& v, int shift) {
+        std::vector<double> out(extent_, 0.0);
+        for (int i = 0; i < extent_; ++i) {
+            if (i + shift >= 0 && i + shift < extent_) out[i] = v[i + shift];
+        }
+        return out;
+    };
+    
+    std::vector<double> v(elements);
+    v.resize(extent_, 0.0);
+    
+    for (const auto& stage : stages_) {
+        std::vector<double> out(extent_, 0.0);
+        for (const auto& group : stage) {
+            std::vector<double> sum(extent_, 0.0);
+            for (const auto& term : group.terms) {
+                auto shifted = rotate(v, term.shift);
+                for (int i = 0; i < extent_; ++i) sum[i] += term.mask[i] * shifted[i];
+            }
+            sum = rotate(sum, group.post);
+            for (int i = 0; i < extent_; ++i) out[i] += sum[i];
+        }
+        v = std::move(out);
+    }
+    return v;
+}
+
+// ------------------------------------------------------------
+// Cache par contenu
+// ------------------------------------------------------------
+static size_t hash_combine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+static size_t hash_double(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return std::hash<uint64_t>()(bits);
+}
+
+std::shared_ptr<const SlotPermutation> make_permutation(
+    const std::vector<SlotMove>& moves,
+    int extent,
+    const SlotLayout& layout,
+    int log_slots,
+    PresetParamsId preset_id,
+    const PermutationCost& cost
+) {
+    // Plans d'un preset (leurs masques sont encodés pour ce preset)
+    using Entry = std::pair<PresetParamsId, std::shared_ptr<const SlotPermutation>>;
+    static std::mutex cache_mutex;
+    static std::unordered_map<size_t, std::vector<Entry>> cache;
+    
+    size_t key = 0;
+    for (int value : {(int)preset_id, extent, (int)layout.order, layout.batch, layout.stride, log_slots,
+                      cost.max_depth}) {
+        key = hash_combine(key, std::hash<int>()(value));
+    }
+    key = hash_combine(key, hash_double(cost.rotation));
+    key = hash_combine(key, hash_double(cost.level));
+    for (const auto& move : moves) {
+        key = hash_combine(key, std::hash<int>()(move.src));
+        key = hash_combine(key, std::hash<int>()(move.dst));
+        key = hash_combine(key, hash_double(move.weight));
+    }
+    
+    auto same = [&](const SlotPermutation& perm) {
+        const SlotLayout& l = perm.layout();
+        const PermutationCost& c = perm.cost();
+        if (perm.extent() != extent || perm.logSlots() != log_slots || l.order != layout.order ||
+            l.batch != layout.batch || l.stride != layout.stride || c.rotation != cost.rotation ||
+            c.level != cost.level || c.max_depth != cost.max_depth || perm.moves().size() != moves.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < moves.size(); ++i) {
+            const SlotMove& a = perm.moves()[i];
+            if (a.src != moves[i].src || a.dst != moves[i].dst || a.weight != moves[i].weight) return false;
+        }
+        return true;
+    };
+    
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto& bucket = cache[key];
+    for (const auto& entry : bucket) {
+        if (entry.first == preset_id && same(*entry.second)) return entry.second;
+    }
+    
+    auto perm = std::make_shared<const SlotPermutation>(moves, extent, layout, log_slots, cost);
+    bucket.push_back({preset_id, perm});
+    return perm;
+}
+
+} // namespace fhe_cnn
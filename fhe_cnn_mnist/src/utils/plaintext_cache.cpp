@@ -0,0 +1,200 @@
+#include "fhe_cnn/plaintext_cache.hpp"
+#include "fhe_cnn/utils.hpp"
+#include <iostream>
+#include <cstring>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// Budget du cache global: ~2048 limbs (masques et poids d'un réseau MNIST)
+static const size_t GLOBAL_MAX_LIMBS = 2048;
+
+PlaintextCache::PlaintextCache(size_t max_limbs)
+    : max_limbs_(max_limbs)
+{
+}
+
+PlaintextCache& PlaintextCache::global() {
+    static PlaintextCache cache(GLOBAL_MAX_LIMBS);
+    return cache;
+}
+
+// ------------------------------------------------------------
+// Clé: hash du preset, du niveau et des valeurs
+// ------------------------------------------------------------
+static size_t hash_combine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+static size_t hash_double(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return std::hash<uint64_t>()(bits);
+}
+
+static size_t hash_message(const Message<Complex>& msg, int level, PresetParamsId preset_id) {
+    size_t key = hash_combine(std::hash<int>()(msg.logSlots()), std::hash<int>()(level));
+    key = hash_combine(key, std::hash<int>()((int)preset_id));
+    for (int i = 0; i < (1 << msg.logSlots()); ++i) {
+        key = hash_combine(key, hash_double(msg[i].real()));
+        key = hash_combine(key, hash_double(msg[i].imag()));
+    }
+    return key;
+}
+
+static bool same_message(const Message<Complex>& a, const Message<Complex>& b) {
+    if (a.logSlots() != b.logSlots()) return false;
+    for (int i = 0; i < (1 << a.logSlots()); ++i) {
+        if (a[i].real() != b[i].real() || a[i].imag() != b[i].imag()) return false;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Accès
+// ------------------------------------------------------------
+std::shared_ptr<const IPlaintext> PlaintextCache::get(
+    const Message<Complex>& msg,
+    int level,
+    PresetParamsId preset_id,
+    EnDecoder& encoder,
+    HomEval& eval
+) {
+    size_t key = hash_message(msg, level, preset_id);
+    
+    auto lookup = [&]() -> Entry* {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return nullptr;
+        for (auto& entry : it->second) {
+            if (entry.level == level && entry.preset_id == preset_id && same_message(entry.msg, msg)) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    };
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Entry* entry = lookup()) {
+            hits_++;
+            entry->uses++;
+            entry->last_use = ++clock_;
+            return entry->ptxt;
+        }
+        misses_++;
+    }
+    
+    // Encodage hors verrou; un autre thread a pu insérer le même plaintext
+    std::shared_ptr<const IPlaintext> ptxt = encode_at_level(msg, level, encoder, eval);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Entry* entry = lookup()) {
+        entry->uses++;
+        entry->last_use = ++clock_;
+        return entry->ptxt;
+    }
+    
+    size_t cost = level + 1;
+    if (max_limbs_ > 0 && cost > max_limbs_) return ptxt;  // Trop grand pour le budget: non gardé
+    evictOver(max_limbs_ > 0 ? max_limbs_ - cost : 0);
+    
+    Entry entry{msg, level, preset_id, ptxt};
+    entry.uses = 1;
+    entry.last_use = ++clock_;
+    entries_[key].push_back(std::move(entry));
+    size_++;
+    limbs_ += cost;
+    return ptxt;
+}
+
+void PlaintextCache::setBudget(size_t max_limbs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_limbs_ = max_limbs;
+    evictOver(max_limbs_);
+}
+
+void PlaintextCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    size_ = 0;
+    limbs_ = 0;
+}
+
+size_t PlaintextCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t PlaintextCache::limbs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limbs_;
+}
+
+size_t PlaintextCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t PlaintextCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+size_t PlaintextCache::evictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+// ------------------------------------------------------------
+// Éviction jusqu'à limbs_ <= limit (mutex tenu par l'appelant)
+// ------------------------------------------------------------
+void PlaintextCache::evictOver(size_t limit) {
+    if (max_limbs_ == 0) return;
+    
+    while (limbs_ > limit && size_ > 0) {
+        // Moins utilisée d'abord, puis la plus ancienne
+        std::vector<Entry>* victim_bucket = nullptr;
+        size_t victim = 0;
+        for (auto& bucket : entries_) {
+            for (size_t i = 0; i < bucket.second.size(); ++i) {
+                const Entry& e = bucket.second[i];
+                if (!victim_bucket ||
+                    e.uses < (*victim_bucket)[victim].uses ||
+                    (e.uses == (*victim_bucket)[victim].uses &&
+                     e.last_use < (*victim_bucket)[victim].last_use)) {
+                    victim_bucket = &bucket.second;
+                    victim = i;
+                }
+            }
+        }
+        
+        limbs_ -= (*victim_bucket)[victim].level + 1;
+        victim_bucket->erase(victim_bucket->begin() + victim);
+        size_--;
+        evictions_++;
+    }
+}
+
+void PlaintextCache::printStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    size_t lookups = hits_ + misses_;
+    std::cout << "🧊 Cache de plaintexts: " << size_ << " plaintexts, " << limbs_ << " limbs";
+    if (max_limbs_ > 0) std::cout << " / " << max_limbs_;
+    std::cout << ", " << hits_ << " hits, " << misses_ << " misses";
+    if (lookups > 0) std::cout << " (" << 100 * hits_ / lookups << "% hits)";
+    std::cout << ", " << evictions_ << " évictions" << std::endl;
+}
+
+std::shared_ptr<const IPlaintext> encode_cached(
+    const Message<Complex>& msg,
+    int level,
+    PresetParamsId preset_id,
+    EnDecoder& encoder,
+    HomEval& eval
+) {
+    return PlaintextCache::global().get(msg, level, preset_id, encoder, eval);
+}
+
+} // namespace fhe_cnn
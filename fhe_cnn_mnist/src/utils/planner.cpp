@@ -0,0 +1,162 @@
+#include "fhe_cnn/planner.hpp"
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace fhe_cnn {
+
+static bool is_linear(LayerKind kind) {
+    return kind == LayerKind::Conv2d || kind == LayerKind::FC;
+}
+
+// ------------------------------------------------------------
+// Coûts déclarés (doivent suivre l'implémentation des couches)
+// ------------------------------------------------------------
+int layer_depth(const LayerSpec& layer) {
+    int split = layer.split_complex ? 1 : 0;  // conjugaison + ×0.5
+    
+    switch (layer.kind) {
+        case LayerKind::Conv2d:
+            return split + 1;  // poids × rotations
+        case LayerKind::AvgPool:
+            return split + 1;  // × 0.25
+        case LayerKind::FC:
+            return split + 2;  // diagonales + extraction du slot 0
+        case LayerKind::OneHot:
+            return split + 6;  // masque + polynôme de signe (4) + masque des paires
+        case LayerKind::ReLU: {
+            int poly = 0;
+            if (layer.relu_degree == 3) poly = 3;       // x², x³, 0.2978x³
+            else if (layer.relu_degree == 5) poly = 4;  // x², x³, x⁵, 0.0625x⁵
+            int scaling = (layer.relu_scale != 1.0) ? 2 : 0;  // 1/scale puis ×scale
+            return split + poly + scaling;
+        }
+    }
+    return 0;
+}
+
+LevelPlan plan_levels(
+    const std::vector<LayerSpec>& network,
+    int initial_level,
+    int boot_level,
+    int min_level,
+    bool fold_scales,
+    int boot_input_depth
+) {
+    int n = network.size();
+    
+    LevelPlan plan;
+    plan.bootstrap_before.assign(n, false);
+    plan.level_in.assign(n, 0);
+    plan.level_out.assign(n, 0);
+    plan.weight_scale.assign(n, 1.0);
+    plan.bias_scale.assign(n, 1.0);
+    plan.relu_scale.assign(n, 1.0);
+    plan.value_scale.assign(n, 1.0);
+    
+    // --------------------------------------------------------
+    // 1. Repli des scales des ReLU dans les couches linéaires
+    // --------------------------------------------------------
+    for (int i = 0; i < n; ++i) {
+        if (network[i].kind != LayerKind::ReLU) continue;
+        
+        double s = network[i].relu_scale;
+        plan.relu_scale[i] = s;
+        if (!fold_scales || s == 1.0) continue;
+        
+        // Couche linéaire avant (AvgPool transparent)
+        int prev = i - 1;
+        while (prev >= 0 && network[prev].kind == LayerKind::AvgPool) prev--;
+        
+        // Couche linéaire après (AvgPool transparent)
+        int next = i + 1;
+        while (next < n && network[next].kind == LayerKind::AvgPool) next++;
+        
+        if (prev < 0 || next >= n) continue;
+        if (!is_linear(network[prev].kind) || !is_linear(network[next].kind)) continue;
+        
+        plan.weight_scale[prev] /= s;
+        plan.bias_scale[prev] /= s;
+        plan.weight_scale[next] *= s;
+        plan.relu_scale[i] = 1.0;
+        
+        for (int j = prev + 1; j <= next; ++j) {
+            plan.value_scale[j] *= s;
+        }
+    }
+    
+    // --------------------------------------------------------
+    // 2. Placement glouton des bootstraps (le plus tard possible)
+    // --------------------------------------------------------
+    std::vector<int> depths(n);
+    for (int i = 0; i < n; ++i) {
+        LayerSpec effective = network[i];
+        effective.relu_scale = plan.relu_scale[i];
+        depths[i] = layer_depth(effective);
+    }
+    
+    // Niveaux consommés de la couche i jusqu'à la fin du réseau
+    std::vector<int> rest(n + 1, 0);
+    for (int i = n - 1; i >= 0; --i) rest[i] = rest[i + 1] + depths[i];
+    
+    // Un bootstrap posé ici doit garder min_level en entrée après ses masques
+    int boot_min_input = min_level + boot_input_depth;
+    int level = initial_level;
+    
+    for (int i = 0; i < n; ++i) {
+        int depth = depths[i];
+        
+        // Sans autre bootstrap, la fin du réseau tient; sinon la couche doit
+        // laisser assez de niveaux pour bootstrapper plus loin
+        bool fits = level - rest[i] >= min_level || level - depth >= boot_min_input;
+        
+        if (!fits) {
+            if (boot_level - depth < min_level) {
+                throw std::runtime_error("plan_levels: la couche " + network[i].name +
+                                         " consomme plus de niveaux qu'un bootstrap n'en fournit");
+            }
+            if (level < boot_min_input) {
+                throw std::runtime_error("plan_levels: niveau " + std::to_string(level) + 
+                                         " insuffisant pour bootstrapper avant " + network[i].name +
+                                         " (" + std::to_string(boot_min_input) + " requis)");
+            }
+            plan.bootstrap_before[i] = true;
+            plan.num_bootstraps++;
+            level = boot_level;
+        }
+        
+        plan.level_in[i] = level;
+        level -= depth;
+        plan.level_out[i] = level;
+    }
+    
+    return plan;
+}
+
+void print_plan(const std::vector<LayerSpec>& network, const LevelPlan& plan) {
+    std::cout << "📋 Plan de niveaux (" << plan.num_bootstraps << " bootstrap(s))" << std::endl;
+    
+    for (int i = 0; i < (int)network.size(); ++i) {
+        if (plan.bootstrap_before[i]) {
+            std::cout << "    🔷 BOOTSTRAP (valeurs / " << plan.value_scale[i] << ")" << std::endl;
+        }
+        
+        std::cout << "    " << std::left << std::setw(10) << network[i].name << std::right
+                  << " niveau " << std::setw(2) << plan.level_in[i]
+                  << " → " << std::setw(2) << plan.level_out[i];
+        
+        if (plan.weight_scale[i] != 1.0) {
+            std::cout << ", poids ×" << plan.weight_scale[i];
+        }
+        if (plan.bias_scale[i] != 1.0) {
+            std::cout << ", bias ×" << plan.bias_scale[i];
+        }
+        if (network[i].kind == LayerKind::ReLU && plan.relu_scale[i] != network[i].relu_scale) {
+            std::cout << ", scale replié";
+        }
+        std::cout << std::endl;
+    }
+}
+
+} // namespace fhe_cnn
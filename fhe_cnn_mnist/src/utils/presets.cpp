@@ -0,0 +1,55 @@
+#include "fhe_cnn/presets.hpp"
+#include <stdexcept>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// ------------------------------------------------------------
+// Table des presets (FTa: pas de bootstrap, réseau sans rafraîchissement)
+//
+// F16Opt_Gr est le preset de référence du projet. Les autres ne sont
+// compilés que si CMake a trouvé leur valeur dans l'enum PresetParamsId
+// du HEAAN2 installé (FHE_CNN_HAS_PRESET_<nom>)
+// ------------------------------------------------------------
+const std::vector<PresetInfo>& known_presets() {
+    static const std::vector<PresetInfo> presets = {
+#ifdef FHE_CNN_HAS_PRESET_FVa
+        {PresetParamsId::FVa, "FVa", true},
+#endif
+        {PresetParamsId::F16Opt_Gr, "F16Opt_Gr", true},
+#ifdef FHE_CNN_HAS_PRESET_FGb
+        {PresetParamsId::FGb, "FGb", true},
+#endif
+#ifdef FHE_CNN_HAS_PRESET_FTa
+        {PresetParamsId::FTa, "FTa", false},
+#endif
+    };
+    return presets;
+}
+
+PresetParamsId parse_preset(const std::string& name) {
+    std::string names;
+    for (const auto& preset : known_presets()) {
+        if (name == preset.name) return preset.id;
+        names += names.empty() ? "" : ", ";
+        names += preset.name;
+    }
+    throw std::runtime_error("Preset inconnu: " + name + " (connus: " + names + ")");
+}
+
+const char* preset_name(PresetParamsId preset_id) {
+    for (const auto& preset : known_presets()) {
+        if (preset.id == preset_id) return preset.name;
+    }
+    return "?";
+}
+
+bool preset_has_bootstrap(PresetParamsId preset_id) {
+    for (const auto& preset : known_presets()) {
+        if (preset.id == preset_id) return preset.bootstrap;
+    }
+    return false;
+}
+
+} // namespace fhe_cnn
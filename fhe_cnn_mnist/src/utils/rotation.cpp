@@ -0,0 +1,452 @@
+#include "fhe_cnn/rotation.hpp"
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <string>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// ------------------------------------------------------------
+// Décompositions en puissances de 2 (rotations normalisées dans [0, N))
+// ------------------------------------------------------------
+static int normalize_shift(int shift, int num_slots) {
+    return ((shift % num_slots) + num_slots) % num_slots;
+}
+
+// Forme non adjacente: s = Σ d_k 2^k, d_k ∈ {-1, 0, 1}
+static std::vector<int> naf_steps(int s, int num_slots) {
+    std::vector<int> steps;
+    long long v = s;
+    
+    for (int k = 0; v != 0; ++k, v >>= 1) {
+        if (v & 1) {
+            int digit = (v & 2) ? -1 : 1;
+            v -= digit;
+            
+            // 2^log_slots ≡ 0: rotation identité
+            int power = 1 << k;
+            if (power < num_slots) {
+                steps.push_back(normalize_shift(digit * power, num_slots));
+            }
+        }
+    }
+    return steps;
+}
+
+static std::vector<int> binary_steps(int s) {
+    std::vector<int> steps;
+    for (int k = 0; (s >> k) != 0; ++k) {
+        if ((s >> k) & 1) steps.push_back(1 << k);
+    }
+    return steps;
+}
+
+static bool all_available(
+    const std::vector<int>& steps,
+    const std::function<bool(int)>& has_key
+) {
+    for (int step : steps) {
+        if (!has_key(step)) return false;
+    }
+    return true;
+}
+
+std::vector<int> rotation_steps(
+    int shift,
+    int log_slots,
+    const std::function<bool(int)>& has_key
+) {
+    int num_slots = 1 << log_slots;
+    int s = normalize_shift(shift, num_slots);
+    
+    if (s == 0) return {};
+    if (has_key(s)) return {s};
+    
+    auto naf = naf_steps(s, num_slots);
+    if (all_available(naf, has_key)) return naf;
+    
+    auto binary = binary_steps(s);
+    if (all_available(binary, has_key)) return binary;
+    
+    throw std::runtime_error("Rotation " + std::to_string(s) +
+                             ": ni clé directe ni décomposition en puissances de 2");
+}
+
+Ptr<ICiphertext> homomorphic_rotate(
+    const ICiphertext& ctxt,
+    int shift,
+    RotationKeyStore& rot_keys,
+    HomEval& eval
+) {
+    int log_slots = rot_keys.logSlots();
+    int s = normalize_shift(shift, 1 << log_slots);
+    
+    // Clé directe si résidente ou s'il reste de la place pour la charger ou
+    // la générer, sinon décomposition sur les clés résidentes (clé directe
+    // en dernier recours)
+    std::vector<int> steps;
+    if (s != 0 && (rot_keys.resident(s) || (rot_keys.available(s) && !rot_keys.full()))) {
+        steps = {s};
+    } else {
+        try {
+            steps = rotation_steps(s, log_slots, [&](int k) { return rot_keys.resident(k); });
+        } catch (const std::runtime_error&) {
+            if (!rot_keys.available(s)) throw;
+            steps = {s};
+        }
+    }
+    
+    auto ct_rot = ICiphertext::make();
+    *ct_rot = ctxt;
+    
+    for (int step : steps) {
+        auto key = rot_keys.get(step);
+        auto ct_next = ICiphertext::make();
+        eval.rot(*ct_rot, step, *ct_next, *key);
+        ct_rot = std::move(ct_next);
+    }
+    return ct_rot;
+}
+
+// ------------------------------------------------------------
+// Rotations multiples: arbre glouton, la rotation restante la moins
+// chère (depuis n'importe quel nœud calculé) d'abord
+// ------------------------------------------------------------
+std::vector<RotationEdge> plan_rotations(
+    const std::vector<int>& shifts,
+    int log_slots,
+    const std::function<bool(int)>& has_key
+) {
+    int num_slots = 1 << log_slots;
+    
+    std::set<int> todo;
+    for (int shift : shifts) {
+        int s = normalize_shift(shift, num_slots);
+        if (s != 0) todo.insert(s);
+    }
+    
+    std::vector<int> computed = {0};
+    std::set<int> done = {0};
+    std::vector<RotationEdge> plan;
+    
+    while (!todo.empty()) {
+        int best_target = -1;
+        int best_from = 0;
+        std::vector<int> best_steps;
+        
+        for (int target : todo) {
+            for (int from : computed) {
+                std::vector<int> steps;
+                try {
+                    steps = rotation_steps(target - from, log_slots, has_key);
+                } catch (const std::runtime_error&) {
+                    continue;
+                }
+                if (best_target < 0 || steps.size() < best_steps.size()) {
+                    best_target = target;
+                    best_from = from;
+                    best_steps = std::move(steps);
+                }
+            }
+        }
+        
+        if (best_target < 0) {
+            // Même message que homomorphic_rotate
+            rotation_steps(*todo.begin(), log_slots, has_key);
+        }
+        
+        // Chaque nœud du chemin devient réutilisable
+        int node = best_from;
+        for (int step : best_steps) {
+            int next = normalize_shift(node + step, num_slots);
+            if (!done.count(next)) {
+                plan.push_back({node, next});
+                done.insert(next);
+                computed.push_back(next);
+            }
+            todo.erase(next);
+            node = next;
+        }
+    }
+    return plan;
+}
+
+std::vector<Ptr<ICiphertext>> homomorphic_rotate_many(
+    const ICiphertext& ctxt,
+    const std::vector<int>& shifts,
+    RotationKeyStore& rot_keys,
+    HomEval& eval
+) {
+    int log_slots = rot_keys.logSlots();
+    int num_slots = 1 << log_slots;
+    
+    // Mêmes clés que homomorphic_rotate: résidentes, ou chargeables sans évincer
+    auto plan = plan_rotations(shifts, log_slots, [&](int k) {
+        return rot_keys.resident(k) || (rot_keys.available(k) && !rot_keys.full());
+    });
+    
+    std::map<int, Ptr<ICiphertext>> nodes;
+    for (const auto& edge : plan) {
+        const ICiphertext& ct_from = edge.from == 0 ? ctxt : *nodes.at(edge.from);
+        int key_shift = normalize_shift(edge.to - edge.from, num_slots);
+        
+        auto key = rot_keys.get(key_shift);
+        auto ct_rot = ICiphertext::make();
+        eval.rot(ct_from, key_shift, *ct_rot, *key);
+        nodes[edge.to] = std::move(ct_rot);
+    }
+    
+    // Nœuds intermédiaires abandonnés; une copie par doublon seulement
+    std::vector<Ptr<ICiphertext>> rotated;
+    std::map<int, size_t> first;
+    for (int shift : shifts) {
+        int s = normalize_shift(shift, num_slots);
+        if (s != 0 && !first.count(s)) {
+            first[s] = rotated.size();
+            rotated.push_back(std::move(nodes.at(s)));
+            continue;
+        }
+        auto ct_copy = ICiphertext::make();
+        *ct_copy = s == 0 ? ctxt : *rotated[first.at(s)];
+        rotated.push_back(std::move(ct_copy));
+    }
+    return rotated;
+}
+
+// ------------------------------------------------------------
+// Rotate-and-sum log-step: Σ_{k<count} Rot_{k·shift}(x)
+//   Registre 0 = x; chaque étape crée reg = reg[kept] + Rot_{copies·shift}(reg[rotated])
+//
+//   Doublement : bits de count du poids fort au poids faible, chaque bit
+//                double la fenêtre, un bit à 1 ajoute x en tête
+//                (rotations de copies quelconques)
+//   Puissances : fenêtres W_{2^e} par doublements, puis concaténation des
+//                fenêtres des bits à 1 (rotations de 2^e copies uniquement)
+//
+//   Même nombre de rotations; le coût dépend des clés disponibles
+// ------------------------------------------------------------
+struct SumStep {
+    int kept;       // Registre ajouté tel quel
+    int rotated;    // Registre tourné
+    int copies;     // Rotation, en copies
+};
+
+static int top_bit(int count) {
+    if (count < 1) {
+        throw std::runtime_error("Rotate-and-sum: count = " + std::to_string(count));
+    }
+    int top = 0;
+    while ((count >> (top + 1)) != 0) top++;
+    return top;
+}
+
+static std::vector<SumStep> doubling_schedule(int count) {
+    int top = top_bit(count);
+    
+    std::vector<SumStep> schedule;
+    int acc = 0;
+    int copies = 1;
+    for (int bit = top - 1; bit >= 0; --bit) {
+        schedule.push_back({acc, acc, copies});
+        acc = schedule.size();
+        copies *= 2;
+        if ((count >> bit) & 1) {
+            schedule.push_back({0, acc, 1});
+            acc = schedule.size();
+            copies += 1;
+        }
+    }
+    return schedule;
+}
+
+static std::vector<SumStep> power_schedule(int count) {
+    int top = top_bit(count);
+    
+    std::vector<SumStep> schedule;
+    std::vector<int> window(top + 1, 0);  // window[e] = registre de W_{2^e}
+    for (int e = 1; e <= top; ++e) {
+        schedule.push_back({window[e - 1], window[e - 1], 1 << (e - 1)});
+        window[e] = schedule.size();
+    }
+    
+    int low = 0;
+    while (!((count >> low) & 1)) low++;
+    
+    int acc = window[low];
+    for (int e = low + 1; e <= top; ++e) {
+        if (!((count >> e) & 1)) continue;
+        schedule.push_back({window[e], acc, 1 << e});
+        acc = schedule.size();
+    }
+    return schedule;
+}
+
+// Key-switches d'une rotation avec les clés de la table (comme homomorphic_rotate)
+static int rotation_cost(int shift, RotationKeyStore& rot_keys) {
+    int s = normalize_shift(shift, 1 << rot_keys.logSlots());
+    if (s == 0) return 0;
+    if (rot_keys.resident(s) || (rot_keys.available(s) && !rot_keys.full())) return 1;
+    
+    try {
+        return rotation_steps(s, rot_keys.logSlots(), [&](int k) { return rot_keys.resident(k); }).size();
+    } catch (const std::runtime_error&) {
+        return rot_keys.available(s) ? 1 : std::numeric_limits<int>::max() / 64;
+    }
+}
+
+static Ptr<ICiphertext> rotate_and_sum(
+    const ICiphertext& ctxt,
+    int count,
+    int shift,
+    const SlotLayout& layout,
+    RotationKeyStore& rot_keys,
+    HomEval& eval
+) {
+    // Planning le moins cher avec les clés disponibles (égalité: puissances de 2)
+    auto cost = [&](const std::vector<SumStep>& schedule) {
+        int total = 0;
+        for (const auto& step : schedule) {
+            total += rotation_cost(layout.rotation(step.copies * shift), rot_keys);
+        }
+        return total;
+    };
+    auto schedule = power_schedule(count);
+    auto doubling = doubling_schedule(count);
+    if (cost(doubling) < cost(schedule)) schedule = std::move(doubling);
+    
+    std::vector<Ptr<ICiphertext>> regs;  // regs[r - 1] = registre r
+    auto reg = [&](int r) -> const ICiphertext& { return r == 0 ? ctxt : *regs[r - 1]; };
+    
+    for (const auto& step : schedule) {
+        auto ct_rot = homomorphic_rotate(reg(step.rotated), layout.rotation(step.copies * shift), rot_keys, eval);
+        
+        auto ct_add = ICiphertext::make();
+        eval.add(reg(step.kept), *ct_rot, *ct_add);
+        regs.push_back(std::move(ct_add));
+    }
+    
+    if (regs.empty()) {
+        auto ct_copy = ICiphertext::make();
+        *ct_copy = ctxt;
+        return ct_copy;
+    }
+    return std::move(regs.back());
+}
+
+// Rotations du planning par puissances de 2 (celui retenu quand toutes les clés existent)
+static std::vector<int> rotate_and_sum_shifts(int count, int shift, const SlotLayout& layout) {
+    std::set<int> shifts;
+    for (const auto& step : power_schedule(count)) {
+        int s = layout.rotation(step.copies * shift);
+        if (s != 0) shifts.insert(s);
+    }
+    return std::vector<int>(shifts.begin(), shifts.end());
+}
+
+Ptr<ICiphertext> homomorphic_replicate(
+    const ICiphertext& ctxt,
+    int count,
+    int shift,
+    const SlotLayout& layout,
+    RotationKeyStore& rot_keys,
+    HomEval& eval
+) {
+    return rotate_and_sum(ctxt, count, shift, layout, rot_keys, eval);
+}
+
+std::vector<int> replicate_rotation_shifts(int count, int shift, const SlotLayout& layout) {
+    return rotate_and_sum_shifts(count, shift, layout);
+}
+
+// ------------------------------------------------------------
+// Somme par blocs: la tête de chaque bloc lit vers l'avant
+// ------------------------------------------------------------
+Ptr<ICiphertext> homomorphic_block_sum(
+    const ICiphertext& ctxt,
+    int block,
+    int stride,
+    const SlotLayout& layout,
+    RotationKeyStore& rot_keys,
+    HomEval& eval
+) {
+    return rotate_and_sum(ctxt, block, stride, layout, rot_keys, eval);
+}
+
+std::vector<int> block_sum_rotation_shifts(int block, int stride, const SlotLayout& layout) {
+    return rotate_and_sum_shifts(block, stride, layout);
+}
+
+Message<Complex> block_heads_mask(
+    int block,
+    int num_blocks,
+    int stride,
+    const SlotLayout& layout,
+    int log_slots
+) {
+    std::vector<Complex> heads((num_blocks - 1) * block * stride + 1, Complex(0.0, 0.0));
+    for (int k = 0; k < num_blocks; ++k) {
+        heads[k * block * stride] = Complex(1.0, 0.0);
+    }
+    return broadcast_message(heads, layout, log_slots);
+}
+
+std::vector<int> select_rotation_keys(
+    const std::vector<int>& shifts,
+    int log_slots,
+    int key_budget
+) {
+    int num_slots = 1 << log_slots;
+    
+    // Fréquence de chaque rotation demandée
+    std::map<int, int> uses;
+    for (int shift : shifts) {
+        int s = normalize_shift(shift, num_slots);
+        if (s != 0) uses[s]++;
+    }
+    
+    std::set<int> keys;
+    if (key_budget <= 0) {
+        for (const auto& u : uses) keys.insert(u.first);
+        return std::vector<int>(keys.begin(), keys.end());
+    }
+    
+    // ------------------------------------------------------------
+    // 1. Base NAF: toujours présente
+    // ------------------------------------------------------------
+    for (const auto& u : uses) {
+        for (int step : naf_steps(u.first, num_slots)) keys.insert(step);
+    }
+    int base_size = keys.size();
+    
+    if (base_size > key_budget) {
+        throw std::runtime_error("select_rotation_keys: budget " + std::to_string(key_budget) +
+                                 " < base NAF (" + std::to_string(base_size) + " clés)");
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Rotations directes, par key-switches économisés décroissants
+    // ------------------------------------------------------------
+    std::vector<std::pair<long long, int>> candidates;
+    for (const auto& u : uses) {
+        if (keys.count(u.first)) continue;
+        long long saved = (long long)u.second * ((int)naf_steps(u.first, num_slots).size() - 1);
+        if (saved > 0) candidates.push_back({-saved, u.first});
+    }
+    std::sort(candidates.begin(), candidates.end());
+    
+    for (const auto& c : candidates) {
+        if ((int)keys.size() >= key_budget) break;
+        keys.insert(c.second);
+    }
+    
+    std::cout << "🔑 Budget " << key_budget << " clés: " << base_size << " puissances de 2 + "
+              << keys.size() - base_size << " directes (" << uses.size()
+              << " rotations distinctes demandées)" << std::endl;
+    
+    return std::vector<int>(keys.begin(), keys.end());
+}
+
+} // namespace fhe_cnn
@@ -14,6 +14,14 @@ double compute_scale_factor(const std::vector<double>& activations) {
     return max_val + 0.1;  // Un peu de marge
 }
 
+std::vector<double> scale_values(const std::vector<double>& values, double factor) {
+    std::vector<double> scaled(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        scaled[i] = values[i] * factor;
+    }
+    return scaled;
+}
+
 Ptr<ICiphertext> scale_ciphertext(
     const ICiphertext& ctxt,
     double factor,
@@ -0,0 +1,195 @@
+#include "fhe_cnn/server_context.hpp"
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fhe_cnn {
+
+using namespace heaan;
+
+// ------------------------------------------------------------
+// Construction
+// ------------------------------------------------------------
+ServerContext::ServerContext(std::shared_ptr<const KeyBundle> bundle, size_t max_resident)
+    : preset_id_(bundle->preset()),
+      log_slots_(bundle->logSlots()),
+      bundle_(bundle),
+      relin_key_(bundle->loadRelinKey()),
+      conj_key_(bundle->has(KeyBundle::KeyKind::Conj) ? bundle->loadConjKey() : nullptr),
+      rot_keys_(bundle->preset(), bundle->logSlots(), nullptr, max_resident)
+{
+    rot_keys_.attach(bundle_);
+    
+    if (bundle_->has(KeyBundle::KeyKind::Boot)) {
+        boot_ctx_ = std::make_unique<BootstrapContext>(preset_id_, *bundle_);
+    }
+    
+    std::cout << "🖥️  Contexte serveur (paquet): " << bundle_->rotShifts().size()
+              << " clés de rotation disponibles, bootstrap "
+              << (boot_ctx_ ? "oui" : "non") << std::endl;
+}
+
+ServerContext::ServerContext(
+    PresetParamsId preset_id,
+    const ISecretKey& sk,
+    bool with_bootstrap,
+    size_t max_resident
+)
+    : preset_id_(preset_id),
+      log_slots_(sk.logDegree() - 1),
+      rot_keys_(preset_id, sk.logDegree() - 1, nullptr, max_resident)
+{
+    SwKeyGenerator swkgen(preset_id);
+    relin_key_ = swkgen.genRelinKey(sk);
+    conj_key_ = swkgen.genConjKey(sk);
+    
+    if (with_bootstrap) {
+        boot_ctx_ = std::make_unique<BootstrapContext>(preset_id, sk);
+    }
+}
+
+void ServerContext::generateRotKeys(const ISecretKey& sk, const std::vector<int>& shifts, int num_threads) {
+    // Génération dans une table temporaire: la table du serveur reste figée
+    RotationKeyStore generator(preset_id_, log_slots_, &sk);
+    
+    std::vector<int> missing;
+    for (int shift : shifts) {
+        if (!rot_keys_.resident(shift)) missing.push_back(shift);
+    }
+    generator.generate(missing, num_threads);
+    
+    for (int s : generator.residentShifts()) {
+        rot_keys_.insert(s, generator.find(s));
+    }
+}
+
+void ServerContext::preload(const std::vector<int>& shifts) {
+    rot_keys_.generate(shifts);
+}
+
+// ------------------------------------------------------------
+// Accès
+// ------------------------------------------------------------
+const ISwKey& ServerContext::conjKey() const {
+    if (!conj_key_) {
+        throw std::runtime_error("ServerContext: pas de clé de conjugaison");
+    }
+    return *conj_key_;
+}
+
+BootstrapContext& ServerContext::bootstrap() {
+    if (!boot_ctx_) {
+        throw std::runtime_error("ServerContext: pas de clés de bootstrap");
+    }
+    return *boot_ctx_;
+}
+
+const BootstrapContext& ServerContext::bootstrap() const {
+    if (!boot_ctx_) {
+        throw std::runtime_error("ServerContext: pas de clés de bootstrap");
+    }
+    return *boot_ctx_;
+}
+
+// ------------------------------------------------------------
+// Workers forkés
+// ------------------------------------------------------------
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+std::vector<std::vector<double>> run_workers(
+    int num_workers,
+    const std::function<std::vector<double>(int)>& job
+) {
+    std::cout << "👷 " << num_workers << " workers forkés (clés partagées)" << std::endl;
+    std::cout.flush();
+    
+    // ------------------------------------------------------------
+    // 1. Fork: chaque worker écrit ses résultats dans son pipe
+    // ------------------------------------------------------------
+    std::vector<pid_t> pids;
+    std::vector<int> pipes;
+    
+    for (int worker = 0; worker < num_workers; ++worker) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            throw std::runtime_error("run_workers: pipe impossible");
+        }
+        
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("run_workers: fork impossible");
+        }
+        
+        if (pid == 0) {
+            close(fds[0]);
+            int status = 0;
+            try {
+                std::vector<double> result = job(worker);
+                uint64_t count = result.size();
+                if (!write_all(fds[1], &count, sizeof(count)) ||
+                    !write_all(fds[1], result.data(), count * sizeof(double))) {
+                    status = 1;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "❌ Worker " << worker << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            close(fds[1]);
+            std::cout.flush();
+            _exit(status);
+        }
+        
+        close(fds[1]);
+        pids.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Collecte (lecture avant waitpid: un pipe plein bloquerait le worker)
+    // ------------------------------------------------------------
+    std::vector<std::vector<double>> results(num_workers);
+    int failures = 0;
+    
+    for (int worker = 0; worker < num_workers; ++worker) {
+        uint64_t count = 0;
+        bool ok = read_all(pipes[worker], &count, sizeof(count));
+        if (ok) {
+            results[worker].resize(count);
+            ok = read_all(pipes[worker], results[worker].data(), count * sizeof(double));
+        }
+        close(pipes[worker]);
+        
+        int status = 0;
+        waitpid(pids[worker], &status, 0);
+        if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+    }
+    
+    if (failures > 0) {
+        throw std::runtime_error("run_workers: " + std::to_string(failures) + " worker(s) en échec");
+    }
+    return results;
+}
+
+} // namespace fhe_cnn
@@ -0,0 +1,205 @@
+#include "fhe_cnn/batch_packer.hpp"
+#include "fhe_cnn/ct_tensor.hpp"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+using namespace heaan;
+using namespace fhe_cnn;
+
+int main() {
+    std::cout << "\n🧪 Test BatchPacker" << std::endl;
+    std::cout << "===================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    int failures = 0;
+    
+    // ------------------------------------------------------------
+    // 1. Capacité selon logSlots (empreinte max du réseau: 8×24×24)
+    // ------------------------------------------------------------
+    std::cout << "\n1. Capacité..." << std::endl;
+    
+    int footprint = 8 * 24 * 24;
+    int expected[][2] = {{13, 1}, {14, 3}, {15, 7}, {16, 14}};
+    for (const auto& e : expected) {
+        BatchPacker packer(e[0], 784, footprint);
+        std::cout << "    logSlots " << e[0] << ": " << packer.capacity() << " images" << std::endl;
+        if (packer.capacity() != e[1] || packer.stride() != footprint) {
+            std::cout << "    ❌ Capacité " << packer.capacity() << " (attendu " << e[1] << ")" << std::endl;
+            failures++;
+        }
+    }
+    
+    if (BatchPacker(15, 784, footprint, 4).capacity() != 4) {
+        std::cout << "    ❌ Plafond max_images ignoré" << std::endl;
+        failures++;
+    }
+    
+    bool thrown = false;
+    try {
+        BatchPacker(12, 784, footprint);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Image trop grande acceptée" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Aller-retour pack / unpack
+    // ------------------------------------------------------------
+    std::cout << "\n2. Aller-retour..." << std::endl;
+    
+    BatchPacker packer(10, 16, 100);  // 10 images de 16 valeurs, stride 100
+    
+    std::vector<std::vector<double>> images(packer.capacity(), std::vector<double>(16));
+    for (int k = 0; k < packer.capacity(); ++k) {
+        for (int i = 0; i < 16; ++i) images[k][i] = k + 0.01 * i;
+    }
+    
+    auto msg = packer.pack(images);
+    auto back = packer.unpack(msg, packer.capacity(), 16);
+    
+    double max_err = 0.0;
+    for (int k = 0; k < packer.capacity(); ++k) {
+        for (int i = 0; i < 16; ++i) {
+            max_err = std::max(max_err, std::abs(back[k][i] - images[k][i]));
+        }
+    }
+    if (max_err > 0.0) {
+        std::cout << "    ❌ Erreur aller-retour: " << max_err << std::endl;
+        failures++;
+    }
+    
+    // Slots entre deux blocs: nuls
+    if (std::abs(msg[packer.offset(1) - 1].real()) > 0.0) {
+        std::cout << "    ❌ Slot hors bloc non nul" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 3. Layout entrelacé: slot = i·B + image
+    // ------------------------------------------------------------
+    std::cout << "\n3. Layout entrelacé..." << std::endl;
+    
+    BatchPacker inter(10, 16, 100, 0, BatchOrder::Interleaved);
+    const SlotLayout& layout = inter.layout();
+    
+    if (inter.capacity() != packer.capacity() || layout.slot(2, 3) != 3 * inter.capacity() + 2) {
+        std::cout << "    ❌ Slot entrelacé incorrect: " << layout.slot(2, 3) << std::endl;
+        failures++;
+    }
+    
+    auto msg_inter = inter.pack(images);
+    auto back_inter = inter.unpack(msg_inter, inter.capacity(), 16);
+    
+    max_err = 0.0;
+    for (int k = 0; k < inter.capacity(); ++k) {
+        for (int i = 0; i < 16; ++i) {
+            max_err = std::max(max_err, std::abs(back_inter[k][i] - images[k][i]));
+        }
+    }
+    if (max_err > 0.0) {
+        std::cout << "    ❌ Erreur aller-retour entrelacé: " << max_err << std::endl;
+        failures++;
+    }
+    
+    // Une rotation de s·B décale toutes les images de s pixels, sans mélange
+    int shift = 5;
+    int rot = layout.rotation(shift);
+    for (int k = 0; k < inter.capacity(); ++k) {
+        for (int i = 0; i + shift < 16; ++i) {
+            if (msg_inter[layout.slot(k, i) + rot] != msg_inter[layout.slot(k, i + shift)]) {
+                std::cout << "    ❌ Rotation ×B: image " << k << " pixel " << i << std::endl;
+                failures++;
+            }
+        }
+    }
+    
+    // Masque répliqué: même valeur à l'élément i de chaque image
+    auto msg_mask = broadcast_message({Complex(1.0, 0.0), Complex(2.0, 0.0)}, layout, 10);
+    if (msg_mask[layout.slot(inter.capacity() - 1, 1)].real() != 2.0 || msg_mask[layout.span(2)].real() != 0.0) {
+        std::cout << "    ❌ broadcast_message incorrect" << std::endl;
+        failures++;
+    }
+    
+    std::cout << "    Rotation de " << shift << " pixels: " << rot << " slots" << std::endl;
+    
+    // ------------------------------------------------------------
+    // 4. Emplacement d'un tenseur [c][h][w] dans le layout
+    // ------------------------------------------------------------
+    std::cout << "\n4. TensorLayout..." << std::endl;
+    
+    auto t = TensorLayout::dense(8, 24, 24, layout);
+    if (!t.dense() || t.extent() != t.size() || t.slot(1, 2, 3, 4) != layout.slot(1, (2 * 24 + 3) * 24 + 4)) {
+        std::cout << "    ❌ Tenseur dense incorrect" << std::endl;
+        failures++;
+    }
+    
+    // Strides doublés (pooling sans compaction): même pixel d'origine
+    TensorLayout pooled = t;
+    pooled.h = 12;
+    pooled.w = 12;
+    pooled.h_stride *= 2;
+    pooled.w_stride *= 2;
+    if (pooled.dense() || pooled.index(2, 3, 4) != t.index(2, 6, 8)) {
+        std::cout << "    ❌ Tenseur strided incorrect" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 5. Découpage par canaux
+    // ------------------------------------------------------------
+    std::cout << "\n5. Découpage par canaux..." << std::endl;
+    
+    // 16×64×64 = 65536 éléments: 2 canaux par ciphertext en logSlots 13
+    auto wide = TensorLayout::dense(16, 64, 64).split(13);
+    std::cout << "    16×64×64 en logSlots 13: " << wide.numCts() << " ciphertexts de "
+              << wide.channelsPerCt() << " canaux" << std::endl;
+    if (wide.numCts() != 8 || wide.ctOf(5) != 2 || wide.index(5, 1, 2) != 4096 + 64 + 2 ||
+        wide.extent() != 8192) {
+        std::cout << "    ❌ Découpage incorrect" << std::endl;
+        failures++;
+    }
+    
+    // Plafond explicite, dernier ciphertext partiel
+    auto capped = TensorLayout::dense(5, 4, 4).split(13, 2);
+    if (capped.numCts() != 3 || capped.channelsIn(2) != 1 || capped.firstChannel(2) != 4) {
+        std::cout << "    ❌ Plafond de canaux ignoré" << std::endl;
+        failures++;
+    }
+    
+    // Tout tient: un seul ciphertext, indices inchangés
+    auto single = TensorLayout::dense(8, 24, 24);
+    if (single.split(13).numCts() != 1 || single.split(13).index(7, 23, 23) != single.index(7, 23, 23)) {
+        std::cout << "    ❌ Tenseur découpé inutilement" << std::endl;
+        failures++;
+    }
+    
+    thrown = false;
+    try {
+        TensorLayout::dense(1, 128, 128).split(13);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Canal trop grand accepté" << std::endl;
+        failures++;
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Résultats ===" << std::endl;
+    std::cout << "  Échecs: " << failures << std::endl;
+    std::cout << "  Temps: " << duration.count() << " ms" << std::endl;
+    
+    if (failures == 0) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
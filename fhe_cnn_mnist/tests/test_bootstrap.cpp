@@ -2,6 +2,8 @@
 #include "fhe_cnn/utils.hpp"
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <map>
 
 using namespace heaan;
 using namespace fhe_cnn;
@@ -77,7 +79,8 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n5. Exécution du bootstrapping..." << std::endl;
     
-    bootstrap_ciphertext(ctxt, *sk, eval, preset_id);
+    BootstrapContext boot_ctx(preset_id, *sk);
+    bootstrap_ciphertext(ctxt, boot_ctx, eval);
     
     // ------------------------------------------------------------
     // 6. Déchiffrer et vérifier
@@ -99,6 +102,55 @@ int main() {
     std::cout << "    Valeur après bootstrap: " << value << std::endl;
     std::cout << "    Erreur: " << err << std::endl;
     
+    // ------------------------------------------------------------
+    // 7. Bootstrap fusionné: 3 ciphertexts, un seul bootstrap
+    // ------------------------------------------------------------
+    std::cout << "\n7. Bootstrap fusionné (3 ciphertexts)..." << std::endl;
+    
+    int merge_count = 3;
+    int live_slots = 16;
+    
+    RotationKeyStore rot_keys(preset_id, log_slots, sk.get());
+    rot_keys.generate(merge_rotation_shifts(merge_count, live_slots, log_slots));
+    
+    std::vector<Ptr<ICiphertext>> cts;
+    for (int k = 0; k < merge_count; ++k) {
+        Message<Complex> msg_k(log_slots, Device::CPU);
+        for (int i = 0; i < (1 << log_slots); ++i) {
+            // Données utiles + déchets hors des live_slots
+            msg_k[i] = Complex(i < live_slots ? 0.1 * (k + 1) + 0.01 * i : 0.5, 0.0);
+        }
+        
+        auto ptxt_k = IPlaintext::make();
+        encoder.encode(msg_k, *ptxt_k);
+        
+        auto ct_k = ICiphertext::make();
+        encryptor.encrypt(*ptxt_k, *sk, *ct_k);
+        
+        auto ct_low = ICiphertext::make();
+        eval.levelDownTo(*ct_k, *ct_low, 4);
+        cts.push_back(std::move(ct_low));
+    }
+    
+    bootstrap_merged(cts, live_slots, log_slots, boot_ctx, rot_keys, eval, encoder);
+    
+    for (int k = 0; k < merge_count; ++k) {
+        auto ptxt_k = IPlaintext::make();
+        encryptor.decrypt(*cts[k], *sk, *ptxt_k);
+        
+        Message<Complex> msg_k;
+        encoder.decode(*ptxt_k, msg_k);
+        msg_k.to(Device::CPU);
+        
+        for (int i = 0; i < 2 * live_slots; ++i) {
+            double want = i < live_slots ? 0.1 * (k + 1) + 0.01 * i : 0.0;
+            err = std::max(err, std::abs(msg_k[i].real() - want));
+        }
+    }
+    
+    std::cout << "    Bootstraps effectués: " << boot_ctx.count() << std::endl;
+    std::cout << "    Erreur max (fusionné): " << err << std::endl;
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     
@@ -0,0 +1,114 @@
+#include "fhe_cnn/complex_packing.hpp"
+#include "fhe_cnn/utils.hpp"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+using namespace heaan;
+using namespace fhe_cnn;
+
+int main() {
+    std::cout << "\n🧪 Test Packing complexe" << std::endl;
+    std::cout << "========================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // ------------------------------------------------------------
+    // 1. Initialisation HEAAN2
+    // ------------------------------------------------------------
+    std::cout << "\n1. Initialisation HEAAN2..." << std::endl;
+    
+    auto preset_id = PresetParamsId::F16Opt_Gr;
+    
+    SKGenerator skgen(preset_id);
+    auto sk = skgen.genKey();
+    sk->to(Device::CPU);
+    
+    SwKeyGenerator swkgen(preset_id);
+    auto conj_key = swkgen.genConjKey(*sk);
+    
+    HomEval eval(preset_id);
+    EnDecoder encoder(preset_id);
+    EnDecryptor encryptor(preset_id);
+    
+    int log_slots = sk->logDegree() - 1;
+    int num_slots = 1 << log_slots;
+    int n = 64;
+    
+    // ------------------------------------------------------------
+    // 2. Deux tenseurs réels dans un seul ciphertext
+    // ------------------------------------------------------------
+    std::cout << "\n2. Packing a + i·b..." << std::endl;
+    
+    Message<Complex> msg_a(log_slots, Device::CPU);
+    Message<Complex> msg_b(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) {
+        msg_a[i] = Complex(i < n ? std::sin(0.1 * i) : 0.0, 0.0);
+        msg_b[i] = Complex(i < n ? std::cos(0.1 * i) : 0.0, 0.0);
+    }
+    
+    auto ptxt = IPlaintext::make();
+    encoder.encode(pack_complex(msg_a, msg_b), *ptxt);
+    
+    auto ctxt = ICiphertext::make();
+    encryptor.encrypt(*ptxt, *sk, *ctxt);
+    
+    // Opération linéaire commune: ×0.5 s'applique aux deux parties
+    auto ct_half = ICiphertext::make();
+    eval.mul(*ctxt, 0.5, *ct_half);
+    eval.rescale(*ct_half, *ct_half);
+    
+    // ------------------------------------------------------------
+    // 3. Séparation puis recombinaison
+    // ------------------------------------------------------------
+    std::cout << "\n3. Séparation par conjugaison..." << std::endl;
+    
+    auto parts = split_complex(*ct_half, *conj_key, eval);
+    auto ct_combined = combine_complex(*parts.first, *parts.second, eval);
+    
+    std::cout << "    Niveau avant: " << eval.getLevel(*ct_half) 
+              << ", après séparation: " << eval.getLevel(*parts.first) << std::endl;
+    
+    // ------------------------------------------------------------
+    // 4. Vérification
+    // ------------------------------------------------------------
+    std::cout << "\n4. Vérification..." << std::endl;
+    
+    auto decrypt = [&](const ICiphertext& ct) {
+        auto ptxt_out = IPlaintext::make();
+        encryptor.decrypt(ct, *sk, *ptxt_out);
+        Message<Complex> msg_out;
+        encoder.decode(*ptxt_out, msg_out);
+        msg_out.to(Device::CPU);
+        return msg_out;
+    };
+    
+    auto msg_re = decrypt(*parts.first);
+    auto msg_im = decrypt(*parts.second);
+    auto msg_z = decrypt(*ct_combined);
+    
+    double max_err = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Complex want_re(0.5 * msg_a[i].real(), 0.0);
+        Complex want_im(0.5 * msg_b[i].real(), 0.0);
+        max_err = std::max(max_err, std::abs(msg_re[i] - want_re));
+        max_err = std::max(max_err, std::abs(msg_im[i] - want_im));
+        max_err = std::max(max_err, std::abs(msg_z[i] - Complex(want_re.real(), want_im.real())));
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Statistiques ===" << std::endl;
+    std::cout << "  Erreur max: " << max_err << std::endl;
+    std::cout << "  Temps total: " << duration.count() << " ms" << std::endl;
+    
+    if (max_err < 1e-5) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
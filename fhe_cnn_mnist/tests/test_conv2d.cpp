@@ -1,4 +1,6 @@
 #include "fhe_cnn/conv2d.hpp"
+#include "fhe_cnn/plaintext_cache.hpp"
+#include "fhe_cnn/presets.hpp"
 #include "fhe_cnn/utils.hpp"
 #include <iostream>
 #include <chrono>
@@ -24,10 +26,6 @@ int main() {
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
-    
-    HomEval eval(preset_id);
     EnDecoder encoder(preset_id);
     EnDecryptor encryptor(preset_id);
     
@@ -36,9 +34,10 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n2. Génération des clés de rotation..." << std::endl;
     
-    std::map<int, Ptr<ISwKey>> rot_keys;
+    // Clés d'évaluation seulement (pas de bootstrap pour ce test)
+    FheContext ctx(preset_id, *sk, false);
     int max_rot = 900;  // Pour image 28×28 + décalages
-    generate_all_rot_keys(*sk, max_rot, rot_keys);
+    generate_all_rot_keys(ctx.server(), *sk, max_rot);
     
     // ------------------------------------------------------------
     // 3. Création des données de test (petite image)
@@ -84,19 +83,15 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n5. Exécution Conv2D homomorphe..." << std::endl;
     
-    auto ct_output = homomorphic_conv2d(
-        *ct_input, weight, bias,
-        in_c, in_h, in_w,
-        out_c, kernel, out_h, out_w,
-        *sk, rot_keys, *relin_key, eval
-    );
+    CtTensor x_t(std::move(ct_input), TensorLayout::dense(in_c, in_h, in_w));
+    auto y = homomorphic_conv2d(x_t, weight, bias, out_c, kernel, ctx);
     
     // ------------------------------------------------------------
     // 6. Déchiffrement
     // ------------------------------------------------------------
     std::cout << "\n6. Déchiffrement..." << std::endl;
     
-    auto output = decrypt_result(*ct_output, *sk, encoder, encryptor, out_c * out_h * out_w);
+    auto output = decrypt_result(y.ct(), *sk, encoder, encryptor, out_c * out_h * out_w);
     
     // ------------------------------------------------------------
     // 7. Calcul en clair pour vérification
@@ -153,6 +148,118 @@ int main() {
                   << ", Erreur: " << err << std::endl;
     }
     
+    // ------------------------------------------------------------
+    // 9. Sortie découpée: un canal par ciphertext, mêmes valeurs
+    // ------------------------------------------------------------
+    std::cout << "\n=== Découpage par canaux ===" << std::endl;
+    
+    auto y_split = homomorphic_conv2d(x_t, weight, bias, out_c, kernel, ctx, false, 1);
+    
+    if ((int)y_split.cts.size() != out_c || y_split.layout.numCts() != out_c) {
+        std::cout << "  ❌ " << y_split.cts.size() << " ciphertexts (attendu " << out_c << ")" << std::endl;
+        max_err = 1.0;
+    } else {
+        double split_err = 0.0;
+        for (int oc = 0; oc < out_c; ++oc) {
+            auto part = decrypt_result(*y_split.cts[oc], *sk, encoder, encryptor, out_h * out_w);
+            for (int i = 0; i < out_h * out_w; ++i) {
+                split_err = std::max(split_err, std::abs(part[i] - output[oc * out_h * out_w + i]));
+            }
+        }
+        std::cout << "  Écart avec un seul ciphertext: " << split_err << std::endl;
+        max_err = std::max(max_err, split_err);
+    }
+    
+    // ------------------------------------------------------------
+    // 10. Plaintext encodé au niveau de la sortie (une fois par niveau)
+    // ------------------------------------------------------------
+    std::cout << "\n=== Encodage par niveau ===" << std::endl;
+    
+    HomEval& eval = ctx.eval();
+    LeveledPlaintext offset(encode_image(input, ctx.logSlots(), Device::CPU));
+    
+    int level_out = eval.getLevel(y.ct());
+    const IPlaintext& ptxt_out = offset.at(level_out, encoder, eval);
+    offset.at(eval.getLevel(x_t.ct()), encoder, eval);
+    
+    if (&offset.at(level_out, encoder, eval) != &ptxt_out || offset.levels() != 2) {
+        std::cout << "  ❌ Plaintext réencodé pour un niveau déjà servi" << std::endl;
+        max_err = 1.0;
+    }
+    
+    auto ct_shifted_out = ICiphertext::make();
+    eval.add(y.ct(), ptxt_out, *ct_shifted_out);
+    auto shifted = decrypt_result(*ct_shifted_out, *sk, encoder, encryptor, out_c * out_h * out_w);
+    
+    double level_err = 0.0;
+    for (int i = 0; i < out_c * out_h * out_w; ++i) {
+        double added = i < (int)input.size() ? input[i] : 0.0;
+        level_err = std::max(level_err, std::abs(shifted[i] - output[i] - added));
+    }
+    std::cout << "  Erreur après ajout au niveau " << level_out << ": " << level_err << std::endl;
+    max_err = std::max(max_err, level_err);
+    
+    // ------------------------------------------------------------
+    // 11. Cache de plaintexts: un second appel ne réencode rien
+    // ------------------------------------------------------------
+    std::cout << "\n=== Cache de plaintexts ===" << std::endl;
+    
+    PlaintextCache& cache = PlaintextCache::global();
+    size_t misses_before = cache.misses();
+    size_t hits_before = cache.hits();
+    
+    auto y_again = homomorphic_conv2d(x_t, weight, bias, out_c, kernel, ctx);
+    cache.printStats();
+    
+    if (cache.misses() != misses_before || cache.hits() <= hits_before) {
+        std::cout << "  ❌ Poids réencodés au second appel" << std::endl;
+        max_err = 1.0;
+    }
+    
+    // Budget d'un seul plaintext: le second évince le premier
+    PlaintextCache small(level_out + 1);
+    auto msg_a = encode_image(input, ctx.logSlots(), Device::CPU);
+    auto msg_b = encode_image(weight, ctx.logSlots(), Device::CPU);
+    auto ptxt_a = small.get(msg_a, level_out, preset_id, encoder, eval);
+    small.get(msg_b, level_out, preset_id, encoder, eval);
+    
+    if (small.size() != 1 || small.evictions() != 1 ||
+        small.get(msg_a, level_out, preset_id, encoder, eval) == ptxt_a) {
+        std::cout << "  ❌ Budget du cache non respecté" << std::endl;
+        max_err = 1.0;
+    }
+    
+    // Deux presets de la table: même message au même niveau, un plaintext
+    // par preset (échelle d'encodage propre à chaque preset)
+    const PresetInfo* other = nullptr;
+    for (const auto& preset : known_presets()) {
+        if (preset.id != preset_id) {
+            other = &preset;
+            break;
+        }
+    }
+    auto other_id = other ? other->id : preset_id;
+    int other_log_slots = other ? SKGenerator(other_id).genKey()->logDegree() - 1 : 0;
+    if (!other) {
+        std::cout << "  (un seul preset installé, pas de comparaison)" << std::endl;
+    } else if (other_log_slots == ctx.logSlots()) {
+        EnDecoder other_encoder(other_id);
+        HomEval other_eval(other_id);
+        
+        PlaintextCache shared;
+        auto ptxt_first = shared.get(msg_a, 1, preset_id, encoder, eval);
+        auto ptxt_other = shared.get(msg_a, 1, other_id, other_encoder, other_eval);
+        
+        if (shared.size() != 2 || shared.misses() != 2 || ptxt_other == ptxt_first ||
+            shared.get(msg_a, 1, preset_id, encoder, eval) != ptxt_first) {
+            std::cout << "  ❌ Plaintext servi à un autre preset" << std::endl;
+            max_err = 1.0;
+        }
+    } else {
+        std::cout << "  (" << other->name << ": logSlots " << other_log_slots 
+                  << ", message non partageable)" << std::endl;
+    }
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     
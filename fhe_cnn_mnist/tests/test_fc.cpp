@@ -23,7 +23,6 @@ int main() {
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    HomEval eval(preset_id);
     EnDecoder encoder(preset_id);
     EnDecryptor encryptor(preset_id);
     
@@ -32,9 +31,10 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n2. Génération des clés de rotation..." << std::endl;
     
-    std::map<int, Ptr<ISwKey>> rot_keys;
+    // Clés d'évaluation seulement (pas de bootstrap pour ce test)
+    FheContext ctx(preset_id, *sk, false);
     int max_rot = 16;  // Pour test
-    generate_all_rot_keys(*sk, max_rot, rot_keys);
+    generate_all_rot_keys(ctx.server(), *sk, max_rot);
     
     // ------------------------------------------------------------
     // 3. Création des données de test
@@ -75,16 +75,15 @@ int main() {
     auto ct_x = ICiphertext::make();
     encryptor.encrypt(*ptxt_x, *sk, *ct_x);
     
-    std::cout << "    Niveau: " << eval.getLevel(*ct_x) << std::endl;
+    std::cout << "    Niveau: " << ctx.eval().getLevel(*ct_x) << std::endl;
     
     // ------------------------------------------------------------
     // 5. FC homomorphe
     // ------------------------------------------------------------
     std::cout << "\n5. Exécution FC homomorphe..." << std::endl;
     
-    auto ct_y = homomorphic_fc(
-        *ct_x, weight, bias, in_features, out_features, *sk, rot_keys, eval
-    );
+    CtTensor x_t(std::move(ct_x), TensorLayout::dense(in_features, 1, 1));
+    auto y = homomorphic_fc(x_t, weight, bias, out_features, ctx);
     
     // ------------------------------------------------------------
     // 6. Déchiffrement
@@ -92,7 +91,7 @@ int main() {
     std::cout << "\n6. Déchiffrement..." << std::endl;
     
     auto ptxt_y = IPlaintext::make();
-    encryptor.decrypt(*ct_y, *sk, *ptxt_y);
+    encryptor.decrypt(y.ct(), *sk, *ptxt_y);
     
     Message<Complex> msg_y;
     encoder.decode(*ptxt_y, msg_y);
@@ -129,15 +128,77 @@ int main() {
                   << ", Erreur: " << err << std::endl;
     }
     
+    // ------------------------------------------------------------
+    // 9. Plusieurs images en blocs: chaque bloc doit donner les sorties
+    //    de son image seule (poids, masques et bias répliqués par bloc)
+    // ------------------------------------------------------------
+    std::cout << "\n9. FC sur 3 images en blocs (stride 32)..." << std::endl;
+    
+    const SlotLayout blocks = SlotLayout::block(3, 32);
+    std::vector<std::vector<double>> images(blocks.batch, std::vector<double>(in_features));
+    Message<Complex> msg_blocks(log_slots, Device::CPU);
+    for (int i = 0; i < (1 << log_slots); ++i) msg_blocks[i] = Complex(0.0, 0.0);
+    for (int k = 0; k < blocks.batch; ++k) {
+        for (int i = 0; i < in_features; ++i) {
+            images[k][i] = (double)rand() / RAND_MAX;
+            msg_blocks[blocks.slot(k, i)] = Complex(images[k][i], 0.0);
+        }
+    }
+    
+    auto ptxt_blocks = IPlaintext::make();
+    encoder.encode(msg_blocks, *ptxt_blocks);
+    auto ct_blocks = ICiphertext::make();
+    encryptor.encrypt(*ptxt_blocks, *sk, *ct_blocks);
+    
+    auto y_blocks = homomorphic_fc(CtTensor(std::move(ct_blocks), TensorLayout::dense(in_features, 1, 1, blocks)),
+                                   weight, bias, out_features, ctx);
+    
+    auto ptxt_y_blocks = IPlaintext::make();
+    encryptor.decrypt(y_blocks.ct(), *sk, *ptxt_y_blocks);
+    Message<Complex> msg_y_blocks;
+    encoder.decode(*ptxt_y_blocks, msg_y_blocks);
+    msg_y_blocks.to(Device::CPU);
+    
+    // Référence: la dernière image (k > 0), chiffrée seule
+    const int k_ref = blocks.batch - 1;
+    Message<Complex> msg_single(log_slots, Device::CPU);
+    for (int i = 0; i < (1 << log_slots); ++i) msg_single[i] = Complex(0.0, 0.0);
+    for (int i = 0; i < in_features; ++i) msg_single[i] = Complex(images[k_ref][i], 0.0);
+    
+    auto ptxt_single = IPlaintext::make();
+    encoder.encode(msg_single, *ptxt_single);
+    auto ct_single = ICiphertext::make();
+    encryptor.encrypt(*ptxt_single, *sk, *ct_single);
+    
+    auto y_single = homomorphic_fc(CtTensor(std::move(ct_single), TensorLayout::dense(in_features, 1, 1)),
+                                   weight, bias, out_features, ctx);
+    
+    auto ptxt_y_single = IPlaintext::make();
+    encryptor.decrypt(y_single.ct(), *sk, *ptxt_y_single);
+    Message<Complex> msg_y_single;
+    encoder.decode(*ptxt_y_single, msg_y_single);
+    msg_y_single.to(Device::CPU);
+    
+    double block_err = 0.0;
+    for (int i = 0; i < out_features; ++i) {
+        double y_block = msg_y_blocks[y_blocks.layout.slots.slot(k_ref, i)].real();
+        double err = std::abs(y_block - msg_y_single[i].real());
+        block_err = std::max(block_err, err);
+        
+        std::cout << "  image " << k_ref << " [" << i << "] Seule: " << msg_y_single[i].real()
+                  << ", En blocs: " << y_block << ", Erreur: " << err << std::endl;
+    }
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     
     std::cout << "\n=== Statistiques ===" << std::endl;
     std::cout << "  Erreur max: " << max_err << std::endl;
+    std::cout << "  Erreur image " << k_ref << " en blocs: " << block_err << std::endl;
     std::cout << "  Erreur (log2): " << std::log2(max_err) << " bits" << std::endl;
     std::cout << "  Temps: " << duration.count() << " ms" << std::endl;
     
-    if (max_err < 1e-6) {
+    if (max_err < 1e-6 && block_err < 1e-6) {
         std::cout << "\n✅ TEST PASSÉ!" << std::endl;
         return 0;
     } else {
@@ -0,0 +1,192 @@
+#include "fhe_cnn/server_context.hpp"
+#include "fhe_cnn/presets.hpp"
+#include "fhe_cnn/rotation.hpp"
+#include "fhe_cnn/utils.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+
+using namespace heaan;
+using namespace fhe_cnn;
+
+int main() {
+    std::cout << "\n🧪 Test Paquet de clés (mmap)" << std::endl;
+    std::cout << "=============================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    int failures = 0;
+    
+    // ------------------------------------------------------------
+    // 1. Initialisation HEAAN2
+    // ------------------------------------------------------------
+    std::cout << "\n1. Initialisation HEAAN2..." << std::endl;
+    
+    auto preset_id = PresetParamsId::F16Opt_Gr;
+    
+    SKGenerator skgen(preset_id);
+    auto sk = skgen.genKey();
+    sk->to(Device::CPU);
+    
+    HomEval eval(preset_id);
+    EnDecoder encoder(preset_id);
+    EnDecryptor encryptor(preset_id);
+    
+    int log_slots = sk->logDegree() - 1;
+    uint64_t seed = 42;
+    
+    // ------------------------------------------------------------
+    // 2. Écriture (sans clés de bootstrap, pour rester rapide)
+    // ------------------------------------------------------------
+    std::cout << "\n2. Écriture du paquet..." << std::endl;
+    
+    ServerContext server(preset_id, *sk, false);
+    server.generateRotKeys(*sk, {1, 2, 3});
+    
+    std::string path = key_bundle_path("/tmp", preset_id, seed);
+    std::string sk_path = secret_key_path("/tmp", preset_id, seed);
+    write_key_bundle(path, seed, server);
+    write_secret_key(sk_path, preset_id, seed, *sk);
+    
+    // ------------------------------------------------------------
+    // 3. Relecture: répertoire et contrôles d'identité
+    // ------------------------------------------------------------
+    std::cout << "\n3. Projection du paquet..." << std::endl;
+    
+    auto bundle = std::make_shared<KeyBundle>(path, preset_id, seed);
+    
+    if (bundle->rotShifts() != std::vector<int>({1, 2, 3}) || bundle->logSlots() != log_slots) {
+        std::cout << "    ❌ Répertoire incorrect" << std::endl;
+        failures++;
+    }
+    if (!bundle->has(KeyBundle::KeyKind::Conj) || bundle->has(KeyBundle::KeyKind::Boot) ||
+        bundle->bootOutputLevel() != -1) {
+        std::cout << "    ❌ Clés absentes annoncées" << std::endl;
+        failures++;
+    }
+    if (bundle->has(KeyBundle::KeyKind::Secret)) {
+        std::cout << "    ❌ Clé secrète dans le paquet du serveur" << std::endl;
+        failures++;
+    }
+    
+    bool thrown = false;
+    try {
+        KeyBundle other(path, preset_id, seed + 1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Graine différente acceptée" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 4. Rotation avec une clé chargée à la demande
+    // ------------------------------------------------------------
+    std::cout << "\n4. Rotation avec les clés du paquet..." << std::endl;
+    
+    // Clé secrète: fichier client, jamais dans le paquet
+    auto sk_loaded = load_secret_key(sk_path, preset_id, seed);
+    sk_loaded->to(Device::CPU);
+    
+    // Contexte serveur sur le paquet: toute clé vient du fichier
+    ServerContext loaded(bundle);
+    RotationKeyStore& loaded_keys = loaded.rotKeys();
+    
+    std::vector<double> input(16);
+    for (int i = 0; i < 16; ++i) input[i] = i + 1;
+    
+    auto ct = encrypt_image(input, *sk_loaded, encoder, encryptor);
+    auto ct_rot = homomorphic_rotate(*ct, 3, loaded_keys, eval);
+    auto output = decrypt_result(*ct_rot, *sk_loaded, encoder, encryptor, 13);
+    
+    double max_err = 0.0;
+    for (int i = 0; i < 13; ++i) {
+        max_err = std::max(max_err, std::abs(output[i] - input[i + 3]));
+    }
+    std::cout << "    Erreur max: " << max_err << std::endl;
+    if (max_err > 1e-5) {
+        std::cout << "    ❌ Rotation incorrecte" << std::endl;
+        failures++;
+    }
+    if (loaded_keys.size() != 1 || loaded_keys.misses() != 1) {
+        std::cout << "    ❌ Chargement non paresseux" << std::endl;
+        failures++;
+    }
+    
+    thrown = false;
+    try {
+        load_secret_key(sk_path, preset_id, seed + 1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Clé secrète d'une autre graine acceptée" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 5. Workers forkés sur le plus petit preset installé: clés du paquet chargées
+    //    avant le fork, même rotation attendue dans chaque worker
+    // ------------------------------------------------------------
+    std::cout << "\n5. Workers forkés..." << std::endl;
+    
+    auto tiny_id = known_presets().back().id;
+    SKGenerator tiny_skgen(tiny_id);
+    auto tiny_sk = tiny_skgen.genKey();
+    tiny_sk->to(Device::CPU);
+    
+    ServerContext tiny_server(tiny_id, *tiny_sk, false);
+    tiny_server.generateRotKeys(*tiny_sk, {1, 2});
+    std::string tiny_path = key_bundle_path("/tmp", tiny_id, seed);
+    write_key_bundle(tiny_path, seed, tiny_server);
+    
+    ServerContext tiny_loaded(std::make_shared<KeyBundle>(tiny_path, tiny_id, seed));
+    tiny_loaded.preload({1, 2});
+    
+    EnDecoder tiny_encoder(tiny_id);
+    EnDecryptor tiny_encryptor(tiny_id);
+    auto ct_tiny = encrypt_image(input, *tiny_sk, tiny_encoder, tiny_encryptor);
+    
+    // Le worker w tourne de w + 1
+    auto worker_results = run_workers(2, [&](int worker) {
+        HomEval tiny_eval(tiny_id);
+        auto ct_worker = homomorphic_rotate(*ct_tiny, worker + 1, tiny_loaded.rotKeys(), tiny_eval);
+        return decrypt_result(*ct_worker, *tiny_sk, tiny_encoder, tiny_encryptor, 13);
+    });
+    
+    double worker_err = 0.0;
+    for (int worker = 0; worker < 2; ++worker) {
+        for (int i = 0; i < 13; ++i) {
+            worker_err = std::max(worker_err, std::abs(worker_results[worker][i] - input[i + worker + 1]));
+        }
+    }
+    // Les deux workers voient les mêmes données décalées d'un slot
+    for (int i = 0; i < 12; ++i) {
+        worker_err = std::max(worker_err, std::abs(worker_results[0][i + 1] - worker_results[1][i]));
+    }
+    std::cout << "    Erreur max (" << preset_name(tiny_id) << ", 2 workers): " << worker_err << std::endl;
+    if (worker_err > 1e-5) {
+        std::cout << "    ❌ Résultats des workers incorrects" << std::endl;
+        failures++;
+    }
+    
+    std::remove(path.c_str());
+    std::remove(sk_path.c_str());
+    std::remove(tiny_path.c_str());
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Statistiques ===" << std::endl;
+    std::cout << "  Échecs: " << failures << std::endl;
+    std::cout << "  Temps total: " << duration.count() << " ms" << std::endl;
+    
+    if (failures == 0) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
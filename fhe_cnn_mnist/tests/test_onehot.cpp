@@ -25,10 +25,6 @@ int main() {
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
-    
-    HomEval eval(preset_id);
     EnDecoder encoder(preset_id);
     EnDecryptor decryptor(preset_id);
     
@@ -37,17 +33,12 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n2. Génération des clés..." << std::endl;
     
-    std::map<int, Ptr<ISwKey>> rot_keys;
-    for (int rot : {1,2,3,4,5,6,7,8,9}) {
-        auto rot_key = swkgen.genRotKey(*sk, rot);
-        rot_keys[rot] = std::move(rot_key);
-    }
-    for (int shift = 1; shift < 16; shift <<= 1) {
-        if (rot_keys.find(shift) == rot_keys.end()) {
-            auto rot_key = swkgen.genRotKey(*sk, shift);
-            rot_keys[shift] = std::move(rot_key);
-        }
-    }
+    int log_slots = sk->logDegree() - 1;
+    
+    // Clés d'évaluation + bootstrap, et rotations de l'argmax SIMD (1 image, 10 classes)
+    FheContext ctx(preset_id, *sk);
+    ctx.server().generateRotKeys(*sk, argmax_rotation_shifts(10, SlotLayout(), log_slots));
+    std::cout << "    " << ctx.rotKeys().size() << " clés générées" << std::endl;
     
     // ------------------------------------------------------------
     // 3. Création des logits de test
@@ -61,7 +52,6 @@ int main() {
     // Correction: mettons le max à 0.9 à l'index 8
     logits[8] = 0.9;  // S'assurer que c'est le max
     
-    int log_slots = sk->logDegree() - 1;
     Message<Complex> msg_logits(log_slots, Device::CPU);
     
     for (int i = 0; i < 10; ++i) {
@@ -90,7 +80,8 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n4. Exécution one-hot..." << std::endl;
     
-    auto ct_onehot = homomorphic_onehot(*ct_logits, *sk, rot_keys, eval, *relin_key);
+    CtTensor logits_t(std::move(ct_logits), TensorLayout::dense(10, 1, 1));
+    auto onehot = homomorphic_onehot(logits_t, ctx);
     
     // ------------------------------------------------------------
     // 5. Déchiffrement
@@ -98,7 +89,7 @@ int main() {
     std::cout << "\n5. Déchiffrement..." << std::endl;
     
     auto ptxt_onehot = IPlaintext::make();
-    decryptor.decrypt(*ct_onehot, *sk, *ptxt_onehot);
+    decryptor.decrypt(onehot.ct(), *sk, *ptxt_onehot);
     
     Message<Complex> msg_onehot;
     encoder.decode(*ptxt_onehot, msg_onehot);
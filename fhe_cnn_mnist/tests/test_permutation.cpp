@@ -0,0 +1,151 @@
+#include "fhe_cnn/permutation.hpp"
+#include "fhe_cnn/presets.hpp"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace heaan;
+using namespace fhe_cnn;
+
+// Écart max entre le plan appliqué en clair et out[dst] = weight·in[src]
+static double plan_error(const SlotPermutation& perm) {
+    std::vector<double> in(perm.extent());
+    for (int i = 0; i < perm.extent(); ++i) in[i] = 1.0 + 0.001 * i;
+    
+    std::vector<double> expected(perm.extent(), 0.0);
+    for (const auto& move : perm.moves()) expected[move.dst] = move.weight * in[move.src];
+    
+    auto out = perm.simulate(in);
+    double err = 0.0;
+    for (int i = 0; i < perm.extent(); ++i) err = std::max(err, std::abs(out[i] - expected[i]));
+    return err;
+}
+
+int main() {
+    std::cout << "\n🧪 Test SlotPermutation" << std::endl;
+    std::cout << "=======================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    int failures = 0;
+    
+    // Compaction d'un pooling 8×24×24 → 8×12×12 (pixels (2y, 2x), ×0.25)
+    std::vector<SlotMove> compaction;
+    for (int ch = 0; ch < 8; ++ch) {
+        for (int y = 0; y < 12; ++y) {
+            for (int x = 0; x < 12; ++x) {
+                compaction.push_back({ch * 576 + 2 * y * 24 + 2 * x, (ch * 12 + y) * 12 + x, 0.25});
+            }
+        }
+    }
+    
+    // ------------------------------------------------------------
+    // 1. BSGS (un niveau disponible)
+    // ------------------------------------------------------------
+    std::cout << "\n1. BSGS..." << std::endl;
+    
+    SlotPermutation bsgs(compaction, 8 * 576, SlotLayout(), 13);
+    std::cout << "    " << bsgs.rotations() << " rotations, profondeur " << bsgs.depth() << std::endl;
+    
+    if (bsgs.method() != PermutationMethod::Bsgs || bsgs.depth() != 1 || bsgs.rotations() > 2 * 60) {
+        std::cout << "    ❌ Plan BSGS inattendu" << std::endl;
+        failures++;
+    }
+    if (plan_error(bsgs) > 1e-12) {
+        std::cout << "    ❌ Erreur BSGS: " << plan_error(bsgs) << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Réseau de décalages (niveaux disponibles, rotations chères)
+    // ------------------------------------------------------------
+    std::cout << "\n2. Réseau de décalages..." << std::endl;
+    
+    PermutationCost deep;
+    deep.level = 0.5;
+    deep.max_depth = 16;
+    SlotPermutation network(compaction, 8 * 576, SlotLayout(), 13, deep);
+    std::cout << "    " << network.rotations() << " rotations, profondeur " << network.depth() << std::endl;
+    
+    if (network.method() != PermutationMethod::ShiftNetwork || network.rotations() >= bsgs.rotations()) {
+        std::cout << "    ❌ Réseau de décalages non choisi" << std::endl;
+        failures++;
+    }
+    if (plan_error(network) > 1e-12) {
+        std::cout << "    ❌ Erreur réseau: " << plan_error(network) << std::endl;
+        failures++;
+    }
+    
+    // Inversion: les décalages se croisent, repli sur BSGS
+    std::vector<SlotMove> reverse;
+    for (int i = 0; i < 64; ++i) reverse.push_back({i, 63 - i});
+    SlotPermutation reversed(reverse, 64, SlotLayout(), 13, deep);
+    if (reversed.method() != PermutationMethod::Bsgs || plan_error(reversed) > 1e-12) {
+        std::cout << "    ❌ Inversion incorrecte" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 3. Layout entrelacé: rotations ×batch
+    // ------------------------------------------------------------
+    std::cout << "\n3. Layout entrelacé..." << std::endl;
+    
+    SlotPermutation inter(reverse, 64, SlotLayout::interleaved(4), 13);
+    for (int shift : inter.rotationShifts()) {
+        if (shift % 4 != 0) {
+            std::cout << "    ❌ Rotation " << shift << " non multiple du batch" << std::endl;
+            failures++;
+            break;
+        }
+    }
+    
+    // ------------------------------------------------------------
+    // 4. Cache et erreurs
+    // ------------------------------------------------------------
+    std::cout << "\n4. Cache..." << std::endl;
+    
+    auto first = make_permutation(compaction, 8 * 576, SlotLayout(), 13, PresetParamsId::F16Opt_Gr);
+    auto second = make_permutation(compaction, 8 * 576, SlotLayout(), 13, PresetParamsId::F16Opt_Gr);
+    auto other = make_permutation(compaction, 8 * 576, SlotLayout(), 14, PresetParamsId::F16Opt_Gr);
+    if (first != second || first == other) {
+        std::cout << "    ❌ Cache par contenu incorrect" << std::endl;
+        failures++;
+    }
+    
+    // Masques encodés pour un preset: un autre preset de la table a son
+    // propre plan (rien à comparer si F16Opt_Gr est seul installé)
+    for (const auto& preset : known_presets()) {
+        if (preset.id == PresetParamsId::F16Opt_Gr) continue;
+        auto other_preset = make_permutation(compaction, 8 * 576, SlotLayout(), 13, preset.id);
+        if (other_preset == first) {
+            std::cout << "    ❌ Plan partagé entre F16Opt_Gr et " << preset.name << std::endl;
+            failures++;
+        }
+    }
+    
+    bool thrown = false;
+    try {
+        SlotPermutation({{0, 1}, {2, 1}}, 4, SlotLayout(), 13);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Destination en double acceptée" << std::endl;
+        failures++;
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Résultats ===" << std::endl;
+    std::cout << "  Échecs: " << failures << std::endl;
+    std::cout << "  Temps: " << duration.count() << " ms" << std::endl;
+    
+    if (failures == 0) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,174 @@
+#include "fhe_cnn/planner.hpp"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+using namespace fhe_cnn;
+
+int main() {
+    std::cout << "\n🧪 Test Plan de niveaux" << std::endl;
+    std::cout << "=======================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    int failures = 0;
+    
+    // ------------------------------------------------------------
+    // 1. Réseau MNIST (même description que main_fin)
+    // ------------------------------------------------------------
+    std::vector<LayerSpec> network = {
+        {"conv1", LayerKind::Conv2d},
+        {"relu1", LayerKind::ReLU, 5, 2.0},
+        {"pool1", LayerKind::AvgPool},
+        {"conv2", LayerKind::Conv2d},
+        {"relu2", LayerKind::ReLU, 5, 2.0},
+        {"pool2", LayerKind::AvgPool},
+        {"fc1", LayerKind::FC},
+        {"relu3", LayerKind::ReLU, 5, 2.0},
+        {"fc2", LayerKind::FC},
+        {"relu4", LayerKind::ReLU, 5, 2.0},
+        {"fc3", LayerKind::FC},
+        {"onehot", LayerKind::OneHot}
+    };
+    
+    int initial_level = 12;
+    int boot_level = 12;
+    int min_level = 3;
+    
+    // ------------------------------------------------------------
+    // 2. Plan sans repli des scales
+    // ------------------------------------------------------------
+    std::cout << "\n2. Plan sans repli..." << std::endl;
+    
+    auto plan_raw = plan_levels(network, initial_level, boot_level, min_level, false);
+    print_plan(network, plan_raw);
+    
+    // ------------------------------------------------------------
+    // 3. Plan avec repli des scales
+    // ------------------------------------------------------------
+    std::cout << "\n3. Plan avec repli..." << std::endl;
+    
+    auto plan = plan_levels(network, initial_level, boot_level, min_level, true);
+    print_plan(network, plan);
+    
+    // ------------------------------------------------------------
+    // 4. Vérifications
+    // ------------------------------------------------------------
+    std::cout << "\n4. Vérification..." << std::endl;
+    
+    // Aucune couche ne descend sous min_level
+    for (const auto* p : {&plan_raw, &plan}) {
+        for (size_t i = 0; i < network.size(); ++i) {
+            if (p->level_out[i] < min_level) {
+                std::cout << "    ❌ " << network[i].name << " sort au niveau " 
+                          << p->level_out[i] << std::endl;
+                failures++;
+            }
+        }
+    }
+    
+    // Minimalité: sans le dernier bootstrap, on passe sous min_level
+    for (const auto* p : {&plan_raw, &plan}) {
+        int last = -1;
+        for (size_t i = 0; i < network.size(); ++i) {
+            if (p->bootstrap_before[i]) last = i;
+        }
+        if (last < 0) continue;
+        
+        // Le niveau ne fait que descendre: il suffit de regarder la fin
+        // (bootstrap avant la première couche: on part d'un ciphertext frais)
+        int level = last > 0 ? p->level_out[last - 1] : initial_level;
+        for (size_t i = last; i < network.size(); ++i) {
+            LayerSpec effective = network[i];
+            effective.relu_scale = p->relu_scale[i];
+            level -= layer_depth(effective);
+        }
+        if (level >= min_level) {
+            std::cout << "    ❌ Le bootstrap avant " << network[last].name 
+                      << " n'est pas nécessaire" << std::endl;
+            failures++;
+        }
+    }
+    
+    // Le repli ne doit jamais ajouter de bootstrap
+    if (plan.num_bootstraps > plan_raw.num_bootstraps) {
+        std::cout << "    ❌ Repli: " << plan.num_bootstraps << " bootstraps > " 
+                  << plan_raw.num_bootstraps << std::endl;
+        failures++;
+    }
+    
+    // Repli: conv1 ×1/2, conv2 ×2×1/2, fc3 ×2, ReLU à scale 1
+    double expected_scales[] = {0.5, 1.0, 1.0, 1.0, 2.0};
+    int linear_layers[] = {0, 3, 6, 8, 10};
+    for (int k = 0; k < 5; ++k) {
+        int i = linear_layers[k];
+        if (std::abs(plan.weight_scale[i] - expected_scales[k]) > 1e-12) {
+            std::cout << "    ❌ " << network[i].name << ": poids ×" << plan.weight_scale[i] 
+                      << " (attendu ×" << expected_scales[k] << ")" << std::endl;
+            failures++;
+        }
+    }
+    for (int i : {1, 4, 7, 9}) {
+        if (plan.relu_scale[i] != 1.0) {
+            std::cout << "    ❌ " << network[i].name << " non replié" << std::endl;
+            failures++;
+        }
+    }
+    
+    // Packing complexe: la séparation coûte un niveau de plus
+    LayerSpec relu_split = {"relu", LayerKind::ReLU, 5, 1.0, true};
+    if (layer_depth(relu_split) != layer_depth({"relu", LayerKind::ReLU, 5, 1.0}) + 1) {
+        std::cout << "    ❌ split_complex: profondeur " << layer_depth(relu_split) << std::endl;
+        failures++;
+    }
+    
+    // Masque avant bootstrap: l'entrée du bootstrap reste à min_level après
+    // le masque (sans ce niveau, le second bootstrap entrerait au niveau 2)
+    std::vector<LayerSpec> fcs = {{"fc1", LayerKind::FC}, {"fc2", LayerKind::FC}, {"fc3", LayerKind::FC}};
+    auto plan_unmasked = plan_levels(fcs, 7, 6, 3);
+    auto plan_masked = plan_levels(fcs, 7, 6, 3, true, 1);
+    
+    auto boot_inputs_ok = [&](const LevelPlan& p, int mask_depth) {
+        for (size_t i = 0; i < fcs.size(); ++i) {
+            if (!p.bootstrap_before[i]) continue;
+            int level = i > 0 ? p.level_out[i - 1] : 7;
+            if (level - mask_depth < 3) return false;
+        }
+        return true;
+    };
+    if (boot_inputs_ok(plan_unmasked, 1) || !boot_inputs_ok(plan_masked, 1)) {
+        std::cout << "    ❌ Niveau du masque avant bootstrap non compté" << std::endl;
+        failures++;
+    }
+    if (plan_masked.level_out.back() < 3) {
+        std::cout << "    ❌ Plan avec masque: sortie au niveau " << plan_masked.level_out.back() << std::endl;
+        failures++;
+    }
+    
+    // Une couche plus profonde que le bootstrap doit être refusée
+    bool thrown = false;
+    try {
+        plan_levels({{"onehot", LayerKind::OneHot}}, 5, 5, 3);
+    } catch (const std::exception&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Plan impossible accepté" << std::endl;
+        failures++;
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Résultats ===" << std::endl;
+    std::cout << "  Bootstraps sans repli: " << plan_raw.num_bootstraps << std::endl;
+    std::cout << "  Bootstraps avec repli: " << plan.num_bootstraps << std::endl;
+    std::cout << "  Temps: " << duration.count() << " ms" << std::endl;
+    
+    if (failures == 0) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
@@ -24,7 +24,6 @@ int main() {
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    HomEval eval(preset_id);
     EnDecoder encoder(preset_id);
     EnDecryptor encryptor(preset_id);
     
@@ -33,14 +32,9 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n2. Génération des clés de rotation..." << std::endl;
     
-    std::map<int, Ptr<ISwKey>> rot_keys;
-    SwKeyGenerator swkgen(preset_id);
-    
-    // Clés nécessaires pour pooling
-    for (int rot : {1, 4, 5}) {  // w=4 pour test
-        auto rot_key = swkgen.genRotKey(*sk, rot);
-        rot_keys[rot] = std::move(rot_key);
-    }
+    // Table figée (sans clé secrète): seules les clés générées sont utilisables
+    FheContext ctx(preset_id, *sk, false);
+    ctx.server().generateRotKeys(*sk, avgpool2d_rotation_shifts(TensorLayout::dense(2, 4, 4), ctx.logSlots()));  // 2×4×4 pour test
     
     // ------------------------------------------------------------
     // 3. Création des données de test
@@ -67,14 +61,24 @@ int main() {
     // ------------------------------------------------------------
     std::cout << "\n5. Exécution AveragePool..." << std::endl;
     
-    auto ct_output = homomorphic_avgpool2d(*ct_input, c, h, w, rot_keys, eval);
+    CtTensor x(std::move(ct_input), TensorLayout::dense(c, h, w));
+    auto y = homomorphic_avgpool2d(x, ctx);
     
     // ------------------------------------------------------------
     // 6. Déchiffrement
     // ------------------------------------------------------------
     std::cout << "\n6. Déchiffrement..." << std::endl;
     
-    auto output = decrypt_result(*ct_output, *sk, encoder, encryptor, c * out_h * out_w);
+    // Sortie compactée: pixel (oh, ow) à l'indice dense du layout de sortie
+    auto slots = decrypt_result(y.ct(), *sk, encoder, encryptor, c * h * w);
+    std::vector<double> output(c * out_h * out_w);
+    for (int ch = 0; ch < c; ++ch) {
+        for (int oh = 0; oh < out_h; ++oh) {
+            for (int ow = 0; ow < out_w; ++ow) {
+                output[(ch * out_h + oh) * out_w + ow] = slots[y.layout.index(ch, oh, ow)];
+            }
+        }
+    }
     
     // ------------------------------------------------------------
     // 7. Calcul en clair
@@ -106,14 +110,23 @@ int main() {
     std::cout << "\n=== Résultats ===" << std::endl;
     
     double max_err = 0.0;
-    for (int i = 0; i < std::min(5, (int)output.size()); ++i) {
+    for (int i = 0; i < (int)output.size(); ++i) {
         double err = std::abs(output[i] - y_clear[i]);
         max_err = std::max(max_err, err);
+        if (i >= 5) continue;
         std::cout << "  [" << i << "] Clair: " << y_clear[i] 
                   << ", FHE: " << output[i]
                   << ", Erreur: " << err << std::endl;
     }
     
+    // Compaction: plus de déchets après la sortie dense
+    double garbage = 0.0;
+    for (int i = (int)output.size(); i < c * h * w; ++i) {
+        garbage = std::max(garbage, std::abs(slots[i]));
+    }
+    std::cout << "  Slots hors sortie (max): " << garbage << std::endl;
+    max_err = std::max(max_err, garbage);
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     
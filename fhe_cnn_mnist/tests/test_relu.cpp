@@ -24,10 +24,8 @@ int main() {
     auto sk = skgen.genKey();
     sk->to(Device::CPU);
     
-    SwKeyGenerator swkgen(preset_id);
-    auto relin_key = swkgen.genRelinKey(*sk);
-    
-    HomEval eval(preset_id);
+    // Contexte FHE (relinéarisation seule: pas de rotation ni de bootstrap)
+    FheContext ctx(preset_id, *sk, false);
     EnDecoder encoder(preset_id);
     EnDecryptor encryptor(preset_id);
     
@@ -54,10 +52,10 @@ int main() {
     // 4. ReLU homomorphe (degré 3,5,7)
     // ------------------------------------------------------------
     std::cout << "\n4. Exécution ReLU degré 3..." << std::endl;
-    auto ct_relu3 = homomorphic_relu(*ct_input, 3, scale_factor, eval, *relin_key);
+    auto ct_relu3 = homomorphic_relu(*ct_input, 3, scale_factor, ctx);
     
     std::cout << "\n5. Exécution ReLU degré 5..." << std::endl;
-    auto ct_relu5 = homomorphic_relu(*ct_input, 5, scale_factor, eval, *relin_key);
+    auto ct_relu5 = homomorphic_relu(*ct_input, 5, scale_factor, ctx);
     
     // ------------------------------------------------------------
     // 5. Déchiffrement
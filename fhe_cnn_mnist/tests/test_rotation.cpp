@@ -0,0 +1,371 @@
+#include "fhe_cnn/rotation.hpp"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <set>
+
+using namespace heaan;
+using namespace fhe_cnn;
+
+int main() {
+    std::cout << "\n🧪 Test Décomposition des rotations" << std::endl;
+    std::cout << "===================================" << std::endl;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    int failures = 0;
+    
+    int log_slots = 10;
+    int num_slots = 1 << log_slots;
+    
+    // Composition des étapes modulo num_slots
+    auto compose = [&](const std::vector<int>& steps) {
+        int total = 0;
+        for (int s : steps) total = (total + s) % num_slots;
+        return total;
+    };
+    
+    // Clés disponibles = appartenance à un ensemble
+    auto in = [](const std::set<int>& keys) {
+        return [keys](int k) { return keys.count(k) > 0; };
+    };
+    
+    // ------------------------------------------------------------
+    // 1. Base ±2^k: toute rotation se décompose
+    // ------------------------------------------------------------
+    std::cout << "\n1. Décomposition avec les clés ±2^k..." << std::endl;
+    
+    std::set<int> pow2_keys;
+    for (int p = 1; p < num_slots; p <<= 1) {
+        pow2_keys.insert(p);
+        pow2_keys.insert(num_slots - p);
+    }
+    
+    int max_steps = 0;
+    for (int shift = -num_slots + 1; shift < num_slots; ++shift) {
+        auto steps = rotation_steps(shift, log_slots, in(pow2_keys));
+        int want = ((shift % num_slots) + num_slots) % num_slots;
+        if (compose(steps) != want) {
+            std::cout << "    ❌ Rotation " << shift << " mal décomposée" << std::endl;
+            failures++;
+        }
+        max_steps = std::max(max_steps, (int)steps.size());
+    }
+    std::cout << "    Étapes max (NAF): " << max_steps << std::endl;
+    if (max_steps > log_slots / 2 + 1) {
+        std::cout << "    ❌ NAF trop long" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 2. Clés positives uniquement: repli binaire
+    // ------------------------------------------------------------
+    std::cout << "\n2. Repli binaire..." << std::endl;
+    
+    std::set<int> positive_keys;
+    for (int p = 1; p < num_slots; p <<= 1) positive_keys.insert(p);
+    
+    auto steps_7 = rotation_steps(7, log_slots, in(positive_keys));  // NAF: 8 - 1
+    if (compose(steps_7) != 7 || steps_7.size() != 3) {
+        std::cout << "    ❌ 7 devrait donner 1 + 2 + 4" << std::endl;
+        failures++;
+    }
+    
+    // Clé directe prioritaire
+    positive_keys.insert(7);
+    if (rotation_steps(7, log_slots, in(positive_keys)).size() != 1) {
+        std::cout << "    ❌ Clé directe ignorée" << std::endl;
+        failures++;
+    }
+    
+    // Aucune décomposition: exception
+    bool thrown = false;
+    try {
+        rotation_steps(3, log_slots, in(std::set<int>()));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Rotation impossible acceptée" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 3. Sélection sous budget
+    // ------------------------------------------------------------
+    std::cout << "\n3. Sélection sous budget..." << std::endl;
+    
+    std::vector<int> demanded = {1, 2, 4, 28, 29, 29, 29, 57, 57, 100};
+    
+    auto all_keys = select_rotation_keys(demanded, log_slots, 0);
+    if (all_keys.size() != 7) {
+        std::cout << "    ❌ Sans budget: " << all_keys.size() << " clés (attendu 7)" << std::endl;
+        failures++;
+    }
+    
+    int budget = 12;
+    auto selected = select_rotation_keys(demanded, log_slots, budget);
+    std::set<int> selected_set(selected.begin(), selected.end());
+    
+    if ((int)selected.size() > budget) {
+        std::cout << "    ❌ Budget dépassé: " << selected.size() << std::endl;
+        failures++;
+    }
+    for (int shift : demanded) {
+        if (compose(rotation_steps(shift, log_slots, in(selected_set))) != shift) {
+            std::cout << "    ❌ " << shift << " non réalisable sous budget" << std::endl;
+            failures++;
+        }
+    }
+    // 29 (3 utilisations, NAF 32 - 4 + 1) doit être direct
+    if (!selected_set.count(29)) {
+        std::cout << "    ❌ La rotation la plus fréquente n'est pas directe" << std::endl;
+        failures++;
+    }
+    
+    thrown = false;
+    try {
+        select_rotation_keys(demanded, log_slots, 2);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ Budget trop petit accepté" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 4. Table figée: une clé absente n'est pas inventée
+    // ------------------------------------------------------------
+    std::cout << "\n4. Table de clés figée..." << std::endl;
+    
+    RotationKeyStore frozen(PresetParamsId::F16Opt_Gr, log_slots);
+    if (frozen.lazy() || frozen.resident(3) || frozen.full()) {
+        std::cout << "    ❌ Table vide mal initialisée" << std::endl;
+        failures++;
+    }
+    
+    thrown = false;
+    try {
+        frozen.get(3);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown || frozen.misses() != 1 || frozen.size() != 0) {
+        std::cout << "    ❌ Clé absente servie par une table figée" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 5. Table paresseuse sous budget: éviction de la moins utilisée
+    // ------------------------------------------------------------
+    std::cout << "\n5. Table paresseuse (budget 2 clés)..." << std::endl;
+    
+    SKGenerator skgen(PresetParamsId::F16Opt_Gr);
+    auto sk = skgen.genKey();
+    sk->to(Device::CPU);
+    
+    RotationKeyStore lazy_store(PresetParamsId::F16Opt_Gr, log_slots, sk.get(), 2);
+    lazy_store.get(1);
+    lazy_store.get(1);
+    lazy_store.get(2);
+    lazy_store.get(-1);  // normalisée en num_slots - 1: évince 2 (1 seule utilisation)
+    
+    if (!lazy_store.resident(1) || lazy_store.resident(2) || !lazy_store.resident(num_slots - 1)) {
+        std::cout << "    ❌ Mauvaise clé évincée" << std::endl;
+        failures++;
+    }
+    if (lazy_store.size() != 2 || lazy_store.hits() != 1 || lazy_store.misses() != 3 ||
+        lazy_store.evictions() != 1) {
+        std::cout << "    ❌ Compteurs incorrects" << std::endl;
+        failures++;
+    }
+    lazy_store.printStats();
+    
+    // Deux threads demandent la même clé absente: une seule génération,
+    // pendant laquelle les hits d'un autre thread passent
+    std::shared_ptr<const ISwKey> key_a, key_b;
+    std::thread thread_a([&]() { key_a = lazy_store.get(5); });
+    std::thread thread_b([&]() { key_b = lazy_store.get(5); });
+    lazy_store.get(1);
+    thread_a.join();
+    thread_b.join();
+    if (!key_a || key_a != key_b || lazy_store.find(5) != key_a) {
+        std::cout << "    ❌ Clé générée deux fois en parallèle" << std::endl;
+        failures++;
+    }
+    
+    // Génération au-delà du budget: plafonnée, le reste à la demande
+    RotationKeyStore capped(PresetParamsId::F16Opt_Gr, log_slots, sk.get(), 2);
+    capped.generate({3, 4, 5});
+    if (capped.size() != 2 || capped.evictions() != 0 || capped.resident(5)) {
+        std::cout << "    ❌ Génération non plafonnée au budget" << std::endl;
+        failures++;
+    }
+    
+    // Table déjà à moitié pleine: seule la place restante est générée,
+    // la clé résidente n'est pas évincée
+    RotationKeyStore partial(PresetParamsId::F16Opt_Gr, log_slots, sk.get(), 2);
+    partial.get(1);
+    partial.generate({3, 4});
+    if (partial.size() != 2 || partial.evictions() != 0 || !partial.resident(1) || partial.resident(4)) {
+        std::cout << "    ❌ Génération plafonnée sans compter les clés résidentes" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 6. Réplication log-step
+    // ------------------------------------------------------------
+    std::cout << "\n6. Réplication log-step..." << std::endl;
+    
+    // Puissance de 2: un doublement par bit (1, 2, 4, 8 copies d'écart)
+    if (replicate_rotation_shifts(16, -64) != std::vector<int>({-512, -256, -128, -64})) {
+        std::cout << "    ❌ Doublements incorrects" << std::endl;
+        failures++;
+    }
+    
+    // 10 = 1010b: fenêtres 1, 2, 4, 8 par doublements, puis W_8 + Rot_8(W_2)
+    auto ten = replicate_rotation_shifts(10, 3);
+    std::cout << "    10 copies: " << ten.size() << " rotations distinctes" << std::endl;
+    if (ten != std::vector<int>({3, 6, 12, 24})) {
+        std::cout << "    ❌ Réplication non puissance de 2 incorrecte" << std::endl;
+        failures++;
+    }
+    
+    // Entrelacé: chaque image dans son segment (rotations ×batch)
+    for (int s : replicate_rotation_shifts(10, 3, SlotLayout::interleaved(4))) {
+        if (s % 12 != 0) {
+            std::cout << "    ❌ Rotation " << s << " hors segment" << std::endl;
+            failures++;
+        }
+    }
+    
+    if (!replicate_rotation_shifts(1, 5).empty()) {
+        std::cout << "    ❌ Une seule copie: aucune rotation attendue" << std::endl;
+        failures++;
+    }
+    
+    thrown = false;
+    try {
+        replicate_rotation_shifts(0, 1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "    ❌ count = 0 accepté" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 7. Somme par blocs de 3 (chiffrée), planning selon les clés
+    // ------------------------------------------------------------
+    std::cout << "\n7. Somme par blocs..." << std::endl;
+    
+    // Seule la clé 1 existe: doublements avec ajout en tête (rotations de 1),
+    // pas de clé 2 à décomposer
+    RotationKeyStore unit_store(PresetParamsId::F16Opt_Gr, log_slots);
+    SwKeyGenerator swkgen(PresetParamsId::F16Opt_Gr);
+    unit_store.insert(1, swkgen.genRotKey(*sk, 1));
+    
+    Message<Complex> msg_blocks(log_slots, Device::CPU);
+    for (int i = 0; i < num_slots; ++i) msg_blocks[i] = Complex(i < 12 ? i + 1.0 : 0.0, 0.0);
+    
+    EnDecoder encoder(PresetParamsId::F16Opt_Gr);
+    EnDecryptor encryptor(PresetParamsId::F16Opt_Gr);
+    HomEval eval(PresetParamsId::F16Opt_Gr);
+    
+    auto ptxt_blocks = IPlaintext::make();
+    encoder.encode(msg_blocks, *ptxt_blocks);
+    auto ct_blocks = ICiphertext::make();
+    encryptor.encrypt(*ptxt_blocks, *sk, *ct_blocks);
+    
+    auto ct_sums = homomorphic_block_sum(*ct_blocks, 3, 1, SlotLayout(), unit_store, eval);
+    std::cout << "    Key-switches: " << unit_store.hits() << std::endl;
+    if (unit_store.hits() != 2) {
+        std::cout << "    ❌ Planning non adapté aux clés (" << unit_store.hits() << " key-switches)" << std::endl;
+        failures++;
+    }
+    
+    auto ptxt_sums = IPlaintext::make();
+    encryptor.decrypt(*ct_sums, *sk, *ptxt_sums);
+    Message<Complex> msg_sums;
+    encoder.decode(*ptxt_sums, msg_sums);
+    msg_sums.to(Device::CPU);
+    
+    // Têtes 0, 3, 6, 9: 1+2+3, 4+5+6, ...
+    double block_err = 0.0;
+    for (int k = 0; k < 4; ++k) {
+        double want = 9.0 * k + 6.0;
+        block_err = std::max(block_err, std::abs(msg_sums[3 * k].real() - want));
+    }
+    std::cout << "    Erreur max aux têtes: " << block_err << std::endl;
+    if (block_err > 1e-3) {
+        std::cout << "    ❌ Sommes par blocs incorrectes" << std::endl;
+        failures++;
+    }
+    
+    auto heads = block_heads_mask(3, 4, 1, SlotLayout(), log_slots);
+    if (heads[9].real() != 1.0 || heads[10].real() != 0.0 || heads[12].real() != 0.0) {
+        std::cout << "    ❌ Masque des têtes incorrect" << std::endl;
+        failures++;
+    }
+    
+    // ------------------------------------------------------------
+    // 8. Rotations multiples d'un même ciphertext (clés ±2^k seulement)
+    // ------------------------------------------------------------
+    std::cout << "\n8. Rotations multiples..." << std::endl;
+    
+    // Chaque étape part d'un nœud déjà calculé, avec une clé existante
+    auto check_plan = [&](const std::vector<int>& shifts, const std::vector<RotationEdge>& plan) {
+        std::set<int> nodes = {0};
+        for (const auto& edge : plan) {
+            int key = ((edge.to - edge.from) % num_slots + num_slots) % num_slots;
+            if (!nodes.count(edge.from) || !pow2_keys.count(key)) return false;
+            nodes.insert(edge.to);
+        }
+        for (int shift : shifts) {
+            if (!nodes.count(((shift % num_slots) + num_slots) % num_slots)) return false;
+        }
+        return true;
+    };
+    
+    // Baby steps 1..7: une étape chacun (au lieu de 11 en décompositions séparées)
+    std::vector<int> baby = {1, 2, 3, 4, 5, 6, 7};
+    auto baby_plan = plan_rotations(baby, log_slots, in(pow2_keys));
+    if (!check_plan(baby, baby_plan) || baby_plan.size() != 7) {
+        std::cout << "    ❌ Plan des baby steps incorrect (" << baby_plan.size() << " étapes)" << std::endl;
+        failures++;
+    }
+    
+    // Taps 5×5 d'une image 28×28
+    std::vector<int> taps;
+    int separate = 0;
+    for (int kh = 0; kh < 5; ++kh) {
+        for (int kw = 0; kw < 5; ++kw) {
+            if (kh == 0 && kw == 0) continue;
+            taps.push_back(kh * 28 + kw);
+            separate += rotation_steps(kh * 28 + kw, log_slots, in(pow2_keys)).size();
+        }
+    }
+    auto taps_plan = plan_rotations(taps, log_slots, in(pow2_keys));
+    std::cout << "    Taps 5×5: " << taps_plan.size() << " key-switches (séparés: " << separate << ")" << std::endl;
+    if (!check_plan(taps, taps_plan) || (int)taps_plan.size() >= separate) {
+        std::cout << "    ❌ Key-switches non partagés" << std::endl;
+        failures++;
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    
+    std::cout << "\n=== Statistiques ===" << std::endl;
+    std::cout << "  Échecs: " << failures << std::endl;
+    std::cout << "  Temps total: " << duration.count() << " ms" << std::endl;
+    
+    if (failures == 0) {
+        std::cout << "\n✅ TEST PASSÉ!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\n❌ TEST ÉCHOUÉ!" << std::endl;
+        return 1;
+    }
+}
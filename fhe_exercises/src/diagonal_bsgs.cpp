@@ -6,7 +6,8 @@
 
 using namespace heaan;
 
-const auto preset_id = PresetParamsId::F16Opt_Gr;
+// Preset défini par CMake (FHE_PRESET, défaut F16Opt_Gr, vérifié à la configuration)
+const auto preset_id = PresetParamsId::FHE_PRESET;
 const auto device = Device::CPU;
 
 std::vector<double> diagonalMethodBSGS(